@@ -1,16 +1,66 @@
 #include <stdio.h>
+#include <pthread.h>
+#include <sys/uio.h>
 #include "des.h"
 #include <string.h>
 #include <stdlib.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 // #include <assert.h>
 
-void deskey(key, edf)
+static void cookey_r(unsigned long *, unsigned long *);
+static void deskey_r(unsigned char *, short, unsigned long *);
+static void deskey_std(unsigned char *, short, unsigned long *);
+static void deskey_raw(unsigned char *, short, unsigned long *);
+#ifdef DES_BMI2
+static void deskey_bmi2(unsigned char *, short, unsigned long *);
+#endif
+static unsigned long long des_ip64(unsigned long long);
+static unsigned long long des_rounds64(unsigned long long,
+                                       const unsigned long *);
+static unsigned long long des_fp64(unsigned long long);
+static void des_rounds_x(unsigned long *, unsigned long *,
+                         const unsigned long *);
+static void desfunc_x(unsigned long *, unsigned long *);
+#ifdef DES_AVX2
+static void desfunc_avx2(unsigned char *, unsigned long *);
+#endif
+
+/* deskey() without the internal key register: the cooked schedule goes
+   to cook[32], so threads may expand keys concurrently.  Uses the BMI2
+   schedule below when the CPU has it. */
+static void deskey_r(unsigned char *key, short edf, unsigned long *cook) {
+#ifdef DES_BMI2
+  if (des_simd_bmi2(-1)) {
+    deskey_bmi2(key, edf, cook);
+    return;
+  }
+#endif
+  deskey_std(key, edf, cook);
+}
+
+/* The portable schedule: PC-1, rotations and PC-2 a bit at a time. */
+static void deskey_std(key, edf, cook)
+unsigned char *key;
+short edf;
+unsigned long *cook;
+{
+  unsigned long kn[32];
+
+  deskey_raw(key, edf, kn);
+  cookey_r(kn, cook);
+  return;
+}
+
+/* PC-1, rotations and PC-2 into the raw (uncooked) schedule kn[32]. */
+static void deskey_raw(key, edf, kn)
 unsigned char *key;
 short edf;
+unsigned long *kn;
 {
   register int i, j, l, m, n;
   unsigned char pc1m[56], pcr[56];
-  unsigned long kn[32];
 
   for (j=0; j<56; j++) {
     l = pc1[j];
@@ -46,18 +96,45 @@ short edf;
         kn[n] |= bigbyte[j];
     }
   }
+  return;
+}
+
+void deskey(key, edf)
+unsigned char *key;
+short edf;
+{
+  unsigned long kn[32];
+
+#ifdef DES_BMI2
+  if (des_simd_bmi2(-1)) {
+    deskey_bmi2(key, edf, kn);
+    usekey(kn);
+    return;
+  }
+#endif
+  deskey_raw(key, edf, kn);
   cookey(kn);
   return;
 }
 
+/* Cook the raw schedule into the internal key register. */
 static void cookey(raw1)
-register unsigned long *raw1;
+unsigned long *raw1;
 {
-  register unsigned long *cook, *raw0;
   unsigned long dough[32];
+
+  cookey_r(raw1, dough);
+  usekey(dough);
+  return;
+}
+
+/* cookey() without the key register: the cooked schedule goes to cook. */
+static void cookey_r(raw1, cook)
+register unsigned long *raw1, *cook;
+{
+  register unsigned long *raw0;
   register int i;
 
-  cook = dough;
   for (i=0; i<16; i++, raw1++) {
     raw0 = raw1++;
     *cook    = (*raw0 & 0x00fc0000L) << 6;
@@ -69,7 +146,6 @@ register unsigned long *raw1;
     *cook   |= (*raw1 & 0x0003f000L) >> 4;
     *cook++ |= (*raw1 & 0x0000003fL);
   }
-  usekey(dough);
   return;
 }
 
@@ -280,6 +356,63 @@ static unsigned long SP8[64] = {
 	0x10041040L, 0x00041000L, 0x00041000L, 0x00001040L,
 	0x00001040L, 0x00040040L, 0x10000000L, 0x10041000L };
 
+#ifdef DES_TRACE
+static des_tracer *des_trace_sink = NULL;
+
+void des_trace_attach(des_tracer *t) {
+  des_trace_sink = t;
+}
+
+void des_trace_flush(void) {
+  des_tracer *t = des_trace_sink;
+
+  if (t == NULL || t->len == 0)
+    return;
+  if (t->flush)
+    t->flush(t->buf, t->len, t->arg);
+  t->len = 0;
+}
+
+static void des_trace_put(unsigned int round, unsigned long l,
+                          unsigned long r, unsigned long *keys) {
+  des_tracer *t = des_trace_sink;
+  des_trace_rec *rec;
+
+  if (t->len == t->cap) {
+    if (t->flush == NULL) {
+      t->dropped++;
+      return;
+    }
+    des_trace_flush();
+  }
+  rec = &t->buf[t->len++];
+  rec->round = round;
+  /* desfunc keeps both halves rotated left by one bit */
+  rec->l = (unsigned int) (((l >> 1) | (l << 31)) & 0xffffffffL);
+  rec->r = (unsigned int) (((r >> 1) | (r << 31)) & 0xffffffffL);
+  rec->k0 = keys ? (unsigned int) keys[0] : 0;
+  rec->k1 = keys ? (unsigned int) keys[1] : 0;
+}
+
+#define DES_TRACE_ROUND(n, l, r, k) \
+  do { if (des_trace_sink) des_trace_put((n), (l), (r), (k)); } while (0)
+#else
+#define DES_TRACE_ROUND(n, l, r, k) ((void) 0)
+#endif
+
+/* Undo cookey(): k0 holds the S1/S3/S5/S7 six-bit groups, k1 holds
+   S2/S4/S6/S8, each in bits 29..24, 21..16, 13..8 and 5..0. */
+unsigned long long des_trace_subkey(unsigned int k0, unsigned int k1) {
+  unsigned long long k = 0;
+  int i;
+
+  for (i=0; i<4; i++) {
+    k = (k << 6) | ((k0 >> (24 - 8*i)) & 0x3f);
+    k = (k << 6) | ((k1 >> (24 - 8*i)) & 0x3f);
+  }
+  return k;
+}
+
 static void desfunc(block, keys)
 register unsigned long *block, *keys;
 {
@@ -305,6 +438,7 @@ register unsigned long *block, *keys;
   leftt ^= work;
   right ^= work;
   leftt = ((leftt<<1) | ((leftt>>31) & 1L)) & 0xffffffffL;
+  DES_TRACE_ROUND(0, leftt, right, NULL);
 
   for (round=0; round<8; round++) {
     work  = (right<<28) | (right>>4);
@@ -319,6 +453,7 @@ register unsigned long *block, *keys;
     fval |= SP4[(work>>16) & 0x3fL];
     fval |= SP2[(work>>24) & 0x3fL];
     leftt ^= fval;
+    DES_TRACE_ROUND(2*round+1, right, leftt, keys-2);
     work  = (leftt<<28) | (leftt>>4);
     work ^= *keys++;
     fval  = SP7[work       & 0x3fL];
@@ -331,6 +466,7 @@ register unsigned long *block, *keys;
     fval |= SP4[(work>>16) & 0x3fL];
     fval |= SP2[(work>>24) & 0x3fL];
     right ^= fval;
+    DES_TRACE_ROUND(2*round+2, leftt, right, keys-2);
   }
 
   right = (right<<31) | (right>>1);
@@ -365,42 +501,1211 @@ register unsigned long *block, *keys;
  ******************************************************/
 
 void des_key(des_ctx *dc, unsigned char *key) {
-  deskey(key, EN0);
-  cpkey(dc->ek);
-  deskey(key, DE1);
-  cpkey(dc->dk);
+  deskey_r(key, EN0, dc->ek);
+  deskey_r(key, DE1, dc->dk);
 }
 
 /* Encrypt several blocks in ECB mode. Caller is responsible for
    short blocks. */
-void des_enc(des_ctx *dc, unsigned char *data, int blocks) {
-  unsigned long work[2];
-  int i;
+static void des_ecb(unsigned long *keys, unsigned char *data, int blocks) {
+  unsigned long work[2*DES_INTERLEAVE];
+  int i, j;
   unsigned char *cp;
 
   cp = data;
-  for (i=0; i<blocks; i++) {
+  i = 0;
+#ifdef DES_AVX2
+  if (blocks >= 8 && des_simd_avx2(-1))
+    for (; i+8<=blocks; i+=8) {
+      desfunc_avx2(cp, keys);
+      cp += 64;
+    }
+#endif
+  if (DES_INTERLEAVE > 1)
+    for (; i+DES_INTERLEAVE<=blocks; i+=DES_INTERLEAVE) {
+      for (j=0; j<DES_INTERLEAVE; j++)
+        scrunch(cp + 8*j, work + 2*j);
+      desfunc_x(work, keys);
+      for (j=0; j<DES_INTERLEAVE; j++)
+        unscrun(work + 2*j, cp + 8*j);
+      cp += 8*DES_INTERLEAVE;
+    }
+  for (; i<blocks; i++) {
     scrunch(cp, work);
-    desfunc(work, dc->ek);
+    desfunc(work, keys);
     unscrun(work, cp);
     cp += 8;
   }
 }
 
+void des_enc(des_ctx *dc, unsigned char *data, int blocks) {
+  des_ecb(dc->ek, data, blocks);
+}
+
 void des_dec(des_ctx *dc, unsigned char *data, int blocks) {
+  des_ecb(dc->dk, data, blocks);
+}
+
+/* Counter mode: ctr is a big-endian 64-bit counter block, advanced once
+   per block and left pointing at the next unused value.  Encryption and
+   decryption are the same operation; only ek is used.  Counter blocks
+   are encrypted DES_CHUNK at a time so des_ecb() can batch them. */
+#define DES_CHUNK 16
+
+void des_ctr(des_ctx *dc, unsigned char *ctr, unsigned char *data,
+             int blocks) {
+  unsigned char ks[8*DES_CHUNK];
+  int i, j, n;
+  unsigned char *cp;
+
+  cp = data;
+  for (i=0; i<blocks; i+=n) {
+    n = blocks - i < DES_CHUNK ? blocks - i : DES_CHUNK;
+    for (j=0; j<n; j++) {
+      int k;
+
+      memcpy(ks + 8*j, ctr, 8);
+      for (k=7; k>=0; k--)
+        if (++ctr[k] != 0)
+          break;
+    }
+    des_ecb(dc->ek, ks, n);
+    for (j=0; j<8*n; j++)
+      cp[j] ^= ks[j];
+    cp += 8*n;
+  }
+}
+
+/* CBC: iv is updated to the last ciphertext block, so consecutive calls
+   continue one chain.  Encryption is serial; decryption has no
+   dependency between blocks and runs DES_CHUNK blocks at a time through
+   des_ecb(), like the counter blocks in des_ctr(). */
+void des_cbc_enc(des_ctx *dc, unsigned char *iv, unsigned char *data,
+                 int blocks) {
   unsigned long work[2];
-  int i;
+  int i, j;
   unsigned char *cp;
 
   cp = data;
   for (i=0; i<blocks; i++) {
+    for (j=0; j<8; j++)
+      cp[j] ^= iv[j];
     scrunch(cp, work);
-    desfunc(work, dc->dk);
+    desfunc(work, dc->ek);
     unscrun(work, cp);
+    memcpy(iv, cp, 8);
     cp += 8;
   }
 }
 
+void des_cbc_dec(des_ctx *dc, unsigned char *iv, unsigned char *data,
+                 int blocks) {
+  unsigned char prev[8*(DES_CHUNK+1)];
+  int i, j, n;
+  unsigned char *cp;
+
+  cp = data;
+  memcpy(prev, iv, 8);
+  for (i=0; i<blocks; i+=n) {
+    n = blocks - i < DES_CHUNK ? blocks - i : DES_CHUNK;
+    memcpy(prev + 8, cp, 8*n);
+    des_ecb(dc->dk, cp, n);
+    for (j=0; j<8*n; j++)
+      cp[j] ^= prev[j];
+    memcpy(prev, prev + 8*n, 8);
+    cp += 8*n;
+  }
+  memcpy(iv, prev, 8);
+}
+
+/* Scatter/gather ECB.  A cursor walks an iovec array; empty entries are
+   skipped.  Runs where both sides have whole blocks left go to des_ecb()
+   in the destination fragment (copied there first when src != dst), and
+   only a block that straddles a fragment boundary on either side goes
+   through an 8-byte bounce. */
+#define DES_SG_RUN (1 << 20)   /* most blocks per des_ecb() call */
+typedef struct {
+  const struct iovec *v;
+  int n;
+  size_t off;
+} sg_cursor;
+
+static size_t sg_avail(sg_cursor *c) {
+  while (c->n > 0 && c->off == c->v->iov_len) {
+    c->v++;
+    c->n--;
+    c->off = 0;
+  }
+  return c->n > 0 ? c->v->iov_len - c->off : 0;
+}
+
+static void sg_move(sg_cursor *c, unsigned char *buf, int out) {
+  size_t k, i = 0;
+
+  while (i < 8) {
+    k = sg_avail(c);
+    if (k > 8 - i)
+      k = 8 - i;
+    if (out)
+      memcpy((unsigned char *) c->v->iov_base + c->off, buf + i, k);
+    else
+      memcpy(buf + i, (unsigned char *) c->v->iov_base + c->off, k);
+    c->off += k;
+    i += k;
+  }
+}
+
+static size_t sg_total(const struct iovec *v, int n) {
+  size_t t = 0;
+
+  while (n-- > 0)
+    t += (v++)->iov_len;
+  return t;
+}
+
+static long desfunc_sg(unsigned long *keys, const struct iovec *src,
+                       int nsrc, const struct iovec *dst, int ndst) {
+  sg_cursor in, out;
+  unsigned long work[2];
+  unsigned char bounce[8], *ip, *op;
+  size_t blocks, left, run, sa, da;
+
+  left = sg_total(src, nsrc);
+  if (left % 8 != 0 || sg_total(dst, ndst) < left)
+    return -1;
+  blocks = left /= 8;
+  in.v = src; in.n = nsrc; in.off = 0;
+  out.v = dst; out.n = ndst; out.off = 0;
+  while (left > 0) {
+    sa = sg_avail(&in);
+    da = sg_avail(&out);
+    if (sa >= 8 && da >= 8) {
+      run = (sa < da ? sa : da) / 8;
+      if (run > left)
+        run = left;
+      if (run > DES_SG_RUN)
+        run = DES_SG_RUN;
+      left -= run;
+      ip = (unsigned char *) in.v->iov_base + in.off;
+      op = (unsigned char *) out.v->iov_base + out.off;
+      if (op != ip)
+        memcpy(op, ip, 8*run);
+      des_ecb(keys, op, (int) run);
+      in.off += 8*run;
+      out.off += 8*run;
+    } else {
+      sg_move(&in, bounce, 0);
+      scrunch(bounce, work);
+      desfunc(work, keys);
+      unscrun(work, bounce);
+      sg_move(&out, bounce, 1);
+      left--;
+    }
+  }
+  return (long) blocks;
+}
+
+long des_encv(des_ctx *dc, const struct iovec *iov, int iovcnt) {
+  return desfunc_sg(dc->ek, iov, iovcnt, iov, iovcnt);
+}
+
+long des_decv(des_ctx *dc, const struct iovec *iov, int iovcnt) {
+  return desfunc_sg(dc->dk, iov, iovcnt, iov, iovcnt);
+}
+
+long des_encv_to(des_ctx *dc, const struct iovec *src, int nsrc,
+                 const struct iovec *dst, int ndst) {
+  return desfunc_sg(dc->ek, src, nsrc, dst, ndst);
+}
+
+long des_decv_to(des_ctx *dc, const struct iovec *src, int nsrc,
+                 const struct iovec *dst, int ndst) {
+  return desfunc_sg(dc->dk, src, nsrc, dst, ndst);
+}
+
+/* Native 64-bit blocks.  The block is one big-endian word, so a single
+   byte swap replaces scrunch/unscrun.  The state between des_ip64,
+   des_rounds64 and des_fp64 is desfunc's rotated leftt/right pair packed
+   as (leftt << 32) | right; des_rounds64 hands it back with the halves
+   swapped, which is both what des_fp64 expects and the input of the
+   next stage, since FP followed by IP cancels out. */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define des_be64(x) (x)
+#else
+#define des_be64(x) __builtin_bswap64(x)
+#endif
+
+static unsigned long long des_ip64(unsigned long long block) {
+  register unsigned long work, right, leftt;
+
+  leftt = (unsigned long) (block >> 32);
+  right = (unsigned long) block & 0xffffffffL;
+  work = ((leftt>>4) ^ right) & 0x0f0f0f0fL;
+  right ^= work;
+  leftt ^= (work<<4);
+  work = ((leftt>>16) ^ right) & 0x0000ffffL;
+  right ^= work;
+  leftt ^= (work<<16);
+  work = ((right>>2) ^ leftt) & 0x33333333L;
+  leftt ^= work;
+  right ^= (work<<2);
+  work = ((right>>8) ^ leftt) & 0x00ff00ffL;
+  leftt ^= work;
+  right ^= (work<<8);
+  right = ((right<<1) | ((right>>31) & 1L)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  leftt = ((leftt<<1) | ((leftt>>31) & 1L)) & 0xffffffffL;
+  return ((unsigned long long) leftt << 32) | right;
+}
+
+static unsigned long long des_rounds64(unsigned long long lr,
+                                       const unsigned long *keys) {
+  register unsigned long fval, work, right, leftt;
+  register int round;
+
+  leftt = (unsigned long) (lr >> 32);
+  right = (unsigned long) lr & 0xffffffffL;
+  for (round=0; round<8; round++) {
+    work  = (right<<28) | (right>>4);
+    work ^= *keys++;
+    fval  = SP7[work       & 0x3fL];
+    fval |= SP5[(work>> 8) & 0x3fL];
+    fval |= SP3[(work>>16) & 0x3fL];
+    fval |= SP1[(work>>24) & 0x3fL];
+    work  = right ^ *keys++;
+    fval |= SP8[work       & 0x3fL];
+    fval |= SP6[(work>> 8) & 0x3fL];
+    fval |= SP4[(work>>16) & 0x3fL];
+    fval |= SP2[(work>>24) & 0x3fL];
+    leftt ^= fval;
+    work  = (leftt<<28) | (leftt>>4);
+    work ^= *keys++;
+    fval  = SP7[work       & 0x3fL];
+    fval |= SP5[(work>> 8) & 0x3fL];
+    fval |= SP3[(work>>16) & 0x3fL];
+    fval |= SP1[(work>>24) & 0x3fL];
+    work  = leftt ^ *keys++;
+    fval |= SP8[work       & 0x3fL];
+    fval |= SP6[(work>> 8) & 0x3fL];
+    fval |= SP4[(work>>16) & 0x3fL];
+    fval |= SP2[(work>>24) & 0x3fL];
+    right ^= fval;
+  }
+  return ((unsigned long long) right << 32) | leftt;
+}
+
+static unsigned long long des_fp64(unsigned long long rl) {
+  register unsigned long work, right, leftt;
+
+  right = (unsigned long) (rl >> 32);
+  leftt = (unsigned long) rl & 0xffffffffL;
+  right = ((right<<31) | (right>>1)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  leftt = ((leftt<<31) | (leftt>>1)) & 0xffffffffL;
+  work = ((leftt>>8) ^ right) & 0x00ff00ffL;
+  right ^= work;
+  leftt ^= (work<<8);
+  work = ((leftt>>2) ^right) & 0x33333333L;
+  right ^= work;
+  leftt ^= (work<<2);
+  work = ((right>>16) ^ leftt) & 0x0000ffffL;
+  leftt ^= work;
+  right ^= (work<<16);
+  work = ((right>>4) ^ leftt) & 0x0f0f0f0fL;
+  leftt ^= work;
+  right ^= (work<<4);
+  return ((unsigned long long) right << 32) | (leftt & 0xffffffffL);
+}
+
+/* Interleaved kernel: DES_INTERLEAVE independent blocks (2, 4 or 8)
+   go through each round together.  A block's rounds form one long chain
+   of dependent SP loads, so desfunc() mostly waits on load latency; the
+   other blocks' lookups fill those waits.  block[] holds the blocks as
+   scrunch() leaves them, two words each. */
+
+/* The sixteen rounds of desfunc_x() on IP'd halves, which come back
+   swapped as des_rounds64() returns them: ready for des_fp64() as
+   (l << 32) | r, or for the next stage of a chain. */
+static void des_rounds_x(unsigned long *l, unsigned long *r,
+                         const unsigned long *keys) {
+  register unsigned long fval, work, k0, k1;
+  int j, round;
+
+  for (round=0; round<8; round++) {
+    k0 = *keys++;
+    k1 = *keys++;
+#pragma GCC unroll 8
+    for (j=0; j<DES_INTERLEAVE; j++) {
+      work  = (r[j]<<28) | (r[j]>>4);
+      work ^= k0;
+      fval  = SP7[work       & 0x3fL];
+      fval |= SP5[(work>> 8) & 0x3fL];
+      fval |= SP3[(work>>16) & 0x3fL];
+      fval |= SP1[(work>>24) & 0x3fL];
+      work  = r[j] ^ k1;
+      fval |= SP8[work       & 0x3fL];
+      fval |= SP6[(work>> 8) & 0x3fL];
+      fval |= SP4[(work>>16) & 0x3fL];
+      fval |= SP2[(work>>24) & 0x3fL];
+      l[j] ^= fval;
+    }
+    k0 = *keys++;
+    k1 = *keys++;
+#pragma GCC unroll 8
+    for (j=0; j<DES_INTERLEAVE; j++) {
+      work  = (l[j]<<28) | (l[j]>>4);
+      work ^= k0;
+      fval  = SP7[work       & 0x3fL];
+      fval |= SP5[(work>> 8) & 0x3fL];
+      fval |= SP3[(work>>16) & 0x3fL];
+      fval |= SP1[(work>>24) & 0x3fL];
+      work  = l[j] ^ k1;
+      fval |= SP8[work       & 0x3fL];
+      fval |= SP6[(work>> 8) & 0x3fL];
+      fval |= SP4[(work>>16) & 0x3fL];
+      fval |= SP2[(work>>24) & 0x3fL];
+      r[j] ^= fval;
+    }
+  }
+#pragma GCC unroll 8
+  for (j=0; j<DES_INTERLEAVE; j++) {
+    work = l[j];
+    l[j] = r[j];
+    r[j] = work;
+  }
+}
+
+static void desfunc_x(unsigned long *block, unsigned long *keys) {
+  unsigned long l[DES_INTERLEAVE], r[DES_INTERLEAVE];
+  unsigned long long lr;
+  int j;
+
+#pragma GCC unroll 8
+  for (j=0; j<DES_INTERLEAVE; j++) {
+    lr = des_ip64(((unsigned long long) block[2*j] << 32) | block[2*j+1]);
+    l[j] = (unsigned long) (lr >> 32);
+    r[j] = (unsigned long) lr & 0xffffffffL;
+  }
+  des_rounds_x(l, r, keys);
+#pragma GCC unroll 8
+  for (j=0; j<DES_INTERLEAVE; j++) {
+    lr = des_fp64(((unsigned long long) l[j] << 32) | r[j]);
+    block[2*j] = (unsigned long) (lr >> 32);
+    block[2*j+1] = (unsigned long) lr & 0xffffffffL;
+  }
+}
+
+#ifdef DES_AVX2
+/* AVX2 kernel: eight blocks, one per 32-bit lane, with the same SP
+   tables as desfunc() narrowed to 32 bits so each S-box lookup is one
+   gather for all eight.  IP and FP are desfunc's swap networks on the
+   lane vectors.  Selected at run time by des_simd_avx2(). */
+#include <immintrin.h>
+
+static unsigned int SP32[8][64] __attribute__((aligned(64)));
+static pthread_once_t des_avx2_once = PTHREAD_ONCE_INIT;
+static int des_avx2_on;
+
+static void des_avx2_setup(void) {
+  static unsigned long *const sp[8] = {
+    SP1, SP2, SP3, SP4, SP5, SP6, SP7, SP8};
+  int n, v;
+
+  for (n=0; n<8; n++)
+    for (v=0; v<64; v++)
+      SP32[n][v] = (unsigned int) sp[n][v];
+  __builtin_cpu_init();
+  des_avx2_on = __builtin_cpu_supports("avx2") != 0;
+}
+
+int des_simd_avx2(int enable) {
+  pthread_once(&des_avx2_once, des_avx2_setup);
+  if (enable == 0)
+    des_avx2_on = 0;
+  else if (enable > 0)
+    des_avx2_on = __builtin_cpu_supports("avx2") != 0;
+  return des_avx2_on;
+}
+
+/* a ^= (b shifted) swap step of IP/FP: t = ((a >> s) ^ b) & m. */
+#define AVX_SWAP(a, b, s, m)                                              \
+  do {                                                                    \
+    t = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi32(a, s), b),   \
+                         _mm256_set1_epi32(m));                           \
+    b = _mm256_xor_si256(b, t);                                           \
+    a = _mm256_xor_si256(a, _mm256_slli_epi32(t, s));                     \
+  } while (0)
+
+#define AVX_ROTL(x, n)                                                    \
+  _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32-(n)))
+
+#define AVX_SP(n, w, s)                                                   \
+  _mm256_i32gather_epi32((const int *) SP32[n],                           \
+    _mm256_and_si256(_mm256_srli_epi32(w, s), m6), 4)
+
+#define AVX_HALF(l, r, k0, k1)                                            \
+  do {                                                                    \
+    w = _mm256_xor_si256(AVX_ROTL(r, 28), _mm256_set1_epi32((int) (k0))); \
+    f = _mm256_or_si256(                                                  \
+          _mm256_or_si256(AVX_SP(6, w, 0), AVX_SP(4, w, 8)),              \
+          _mm256_or_si256(AVX_SP(2, w, 16), AVX_SP(0, w, 24)));           \
+    w = _mm256_xor_si256(r, _mm256_set1_epi32((int) (k1)));               \
+    f = _mm256_or_si256(f, _mm256_or_si256(                               \
+          _mm256_or_si256(AVX_SP(7, w, 0), AVX_SP(5, w, 8)),              \
+          _mm256_or_si256(AVX_SP(3, w, 16), AVX_SP(1, w, 24))));          \
+    l = _mm256_xor_si256(l, f);                                           \
+  } while (0)
+
+__attribute__((target("avx2")))
+static void desfunc_avx2(unsigned char *data, unsigned long *keys) {
+  const __m256i bswap = _mm256_setr_epi8(
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  const __m256i m6 = _mm256_set1_epi32(0x3f);
+  __m256i a, b, leftt, right, t, w, f;
+  int round;
+
+  /* eight big-endian (L, R) pairs -> lanes of leftt and right */
+  a = _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i *) data), bswap);
+  b = _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i *) (data+32)), bswap);
+  a = _mm256_permutevar8x32_epi32(a, _mm256_setr_epi32(0,2,4,6,1,3,5,7));
+  b = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(0,2,4,6,1,3,5,7));
+  leftt = _mm256_permute2x128_si256(a, b, 0x20);
+  right = _mm256_permute2x128_si256(a, b, 0x31);
+
+  AVX_SWAP(leftt, right, 4, 0x0f0f0f0f);
+  AVX_SWAP(leftt, right, 16, 0x0000ffff);
+  AVX_SWAP(right, leftt, 2, 0x33333333);
+  AVX_SWAP(right, leftt, 8, 0x00ff00ff);
+  right = AVX_ROTL(right, 1);
+  t = _mm256_and_si256(_mm256_xor_si256(leftt, right),
+                       _mm256_set1_epi32((int) 0xaaaaaaaa));
+  leftt = _mm256_xor_si256(leftt, t);
+  right = _mm256_xor_si256(right, t);
+  leftt = AVX_ROTL(leftt, 1);
+
+  for (round=0; round<8; round++) {
+    AVX_HALF(leftt, right, keys[0], keys[1]);
+    AVX_HALF(right, leftt, keys[2], keys[3]);
+    keys += 4;
+  }
+
+  right = AVX_ROTL(right, 31);
+  t = _mm256_and_si256(_mm256_xor_si256(leftt, right),
+                       _mm256_set1_epi32((int) 0xaaaaaaaa));
+  leftt = _mm256_xor_si256(leftt, t);
+  right = _mm256_xor_si256(right, t);
+  leftt = AVX_ROTL(leftt, 31);
+  AVX_SWAP(leftt, right, 8, 0x00ff00ff);
+  AVX_SWAP(leftt, right, 2, 0x33333333);
+  AVX_SWAP(right, leftt, 16, 0x0000ffff);
+  AVX_SWAP(right, leftt, 4, 0x0f0f0f0f);
+
+  /* lanes -> eight (right, leftt) pairs, as desfunc() stores them */
+  a = _mm256_permute2x128_si256(right, leftt, 0x20);
+  b = _mm256_permute2x128_si256(right, leftt, 0x31);
+  a = _mm256_permutevar8x32_epi32(a, _mm256_setr_epi32(0,4,1,5,2,6,3,7));
+  b = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(0,4,1,5,2,6,3,7));
+  _mm256_storeu_si256((__m256i *) data, _mm256_shuffle_epi8(a, bswap));
+  _mm256_storeu_si256((__m256i *) (data+32), _mm256_shuffle_epi8(b, bswap));
+}
+#else
+int des_simd_avx2(int enable) {
+  (void) enable;
+  return 0;
+}
+#endif
+
+#ifdef DES_BMI2
+/* BMI2 key schedule.  The whole of deskey_std() -- PC-1, the rotations,
+   PC-2 and cookey() -- is a fixed bit permutation from the raw key to
+   each cooked word.  Split per word into chains of key bits whose
+   cooked positions rise with their key positions, every chain is one
+   pext (gather its key bits) and one pdep (spread them into place),
+   about eight chains per word.  The chains are found once by running
+   deskey_std() on single-bit keys.
+
+   IP and FP stay on desfunc's swap networks: they take nine chains
+   each, and measured here the pext/pdep form was no faster in latency
+   and about 1.7x slower in throughput than the network.
+
+   AMD parts before Zen 3 (family 19h) run pdep/pext in microcode, tens
+   of cycles each and worse with dense masks, which leaves this slower
+   than deskey_std(); there it stays off. */
+#include <immintrin.h>
+#include <cpuid.h>
+
+#define BMI_CHAINS 16                /* per cooked word */
+
+static unsigned long long bmi_src[32][BMI_CHAINS];
+static unsigned int bmi_dst[32][BMI_CHAINS];
+static unsigned char bmi_n[32];
+static pthread_once_t des_bmi2_once = PTHREAD_ONCE_INIT;
+static int des_bmi2_ok, des_bmi2_on;
+
+static int des_bmi2_microcoded(void) {
+  unsigned int a, b, c, d, family;
+
+  /* vendor "AuthenticAMD" comes back in ebx, edx, ecx */
+  if (!__get_cpuid(0, &a, &b, &c, &d) ||
+      b != 0x68747541 || d != 0x69746e65 || c != 0x444d4163)
+    return 0;
+  if (!__get_cpuid(1, &a, &b, &c, &d))
+    return 1;
+  family = (a >> 8) & 0xf;
+  if (family == 0xf)
+    family += (a >> 20) & 0xff;
+  return family < 0x19;
+}
+
+static void des_bmi2_setup(void) {
+  unsigned long cooked[64][32];
+  unsigned char key[8];
+  int last[BMI_CHAINS], p, w, b, c, best;
+
+  /* key bit p: 0 = LSB of the key read as a big-endian 64-bit word */
+  for (p=0; p<64; p++) {
+    memset(key, 0, sizeof(key));
+    key[7 - p/8] = (unsigned char) (1 << (p % 8));
+    deskey_std(key, EN0, cooked[p]);
+  }
+  des_bmi2_ok = 1;
+  for (w=0; w<32; w++)
+    for (p=0; p<64; p++)
+      for (b=0; b<32; b++) {
+        if (!((cooked[p][w] >> b) & 1))
+          continue;
+        /* the chain ending at the highest position still below b */
+        for (best=-1, c=0; c<bmi_n[w]; c++)
+          if (last[c] < b && (best < 0 || last[c] > last[best]))
+            best = c;
+        if (best < 0) {
+          if (bmi_n[w] == BMI_CHAINS) {
+            des_bmi2_ok = 0;
+            return;
+          }
+          best = bmi_n[w]++;
+        }
+        last[best] = b;
+        bmi_src[w][best] |= 1ULL << p;
+        bmi_dst[w][best] |= 1U << b;
+      }
+  __builtin_cpu_init();
+  des_bmi2_ok = __builtin_cpu_supports("bmi2") && !des_bmi2_microcoded();
+  des_bmi2_on = des_bmi2_ok;
+}
+
+int des_simd_bmi2(int enable) {
+  pthread_once(&des_bmi2_once, des_bmi2_setup);
+  if (enable >= 0)
+    des_bmi2_on = enable && des_bmi2_ok;
+  return des_bmi2_on;
+}
+
+__attribute__((target("bmi2")))
+static void deskey_bmi2(unsigned char *key, short edf, unsigned long *cook) {
+  unsigned long long k;
+  unsigned long v;
+  int w, c;
+
+  for (k=0, w=0; w<8; w++)
+    k = (k << 8) | key[w];
+  for (w=0; w<32; w++) {
+    for (v=0, c=0; c<bmi_n[w]; c++)
+      v |= (unsigned long) _pdep_u64(_pext_u64(k, bmi_src[w][c]),
+                                     bmi_dst[w][c]);
+    /* decryption: the same pairs in reverse round order */
+    cook[edf == DE1 ? (30 - (w & ~1)) + (w & 1) : w] = v;
+  }
+}
+#else
+int des_simd_bmi2(int enable) {
+  (void) enable;
+  return 0;
+}
+#endif
+
+unsigned long long des_enc_u64(des_ctx *dc, unsigned long long block) {
+  return des_fp64(des_rounds64(des_ip64(block), dc->ek));
+}
+
+unsigned long long des_dec_u64(des_ctx *dc, unsigned long long block) {
+  return des_fp64(des_rounds64(des_ip64(block), dc->dk));
+}
+
+/* Wire-order words are the same bytes des_enc() works on, so these take
+   the batched des_ecb() path rather than one des_rounds64() at a time. */
+void des_enc64(des_ctx *dc, unsigned long long *blocks, int n) {
+  des_ecb(dc->ek, (unsigned char *) blocks, n);
+}
+
+void des_dec64(des_ctx *dc, unsigned long long *blocks, int n) {
+  des_ecb(dc->dk, (unsigned char *) blocks, n);
+}
+
+unsigned long long des_chain_u64(unsigned long long block,
+                                 unsigned long *const *keys, int n) {
+  unsigned long long lr = des_ip64(block);
+  int i;
+
+  for (i=0; i<n; i++)
+    lr = des_rounds64(lr, keys[i]);
+  return des_fp64(lr);
+}
+
+/* Batched like des_ecb(): eight blocks per stage through the AVX2
+   kernel (its FP and the next stage's IP cancel, so only the extra
+   permutation work is lost), then DES_INTERLEAVE blocks at a time with
+   IP and FP once per block, then the rest one by one. */
+void des_chain64(unsigned long *const *keys, int n,
+                 unsigned long long *blocks, int count) {
+  unsigned long l[DES_INTERLEAVE], r[DES_INTERLEAVE];
+  unsigned long long lr;
+  int i, j, k;
+
+  i = 0;
+#ifdef DES_AVX2
+  if (count >= 8 && des_simd_avx2(-1))
+    for (; i+8<=count; i+=8)
+      for (k=0; k<n; k++)
+        desfunc_avx2((unsigned char *) (blocks + i), keys[k]);
+#endif
+  if (DES_INTERLEAVE > 1)
+    for (; i+DES_INTERLEAVE<=count; i+=DES_INTERLEAVE) {
+      for (j=0; j<DES_INTERLEAVE; j++) {
+        lr = des_ip64(des_be64(blocks[i+j]));
+        l[j] = (unsigned long) (lr >> 32);
+        r[j] = (unsigned long) lr & 0xffffffffL;
+      }
+      for (k=0; k<n; k++)
+        des_rounds_x(l, r, keys[k]);
+      for (j=0; j<DES_INTERLEAVE; j++)
+        blocks[i+j] = des_be64(des_fp64(((unsigned long long) l[j] << 32)
+                                        | r[j]));
+    }
+  for (; i<count; i++)
+    blocks[i] = des_be64(des_chain_u64(des_be64(blocks[i]), keys, n));
+}
+
+#define XCHECK_MAX 32   /* samples remembered per call */
+
+void des_xcheck_init(des_xcheck *xc, const char *name,
+                     void (*enc)(des_ctx *, unsigned char *, int),
+                     void (*dec)(des_ctx *, unsigned char *, int),
+                     unsigned long rate, int fail_closed) {
+  memset(xc, 0, sizeof(*xc));
+  xc->name = name;
+  xc->enc = enc;
+  xc->dec = dec;
+  xc->rate = rate;
+  xc->fail_closed = fail_closed;
+  xc->rng = 0x9e3779b9L ^ (unsigned long) xc;
+  xc->skip = rate ? xc->rng % rate : 0;
+}
+
+/* Uniform gap in [0, 2*rate-2], so the stride 1+gap averages exactly
+   rate blocks (and rate 1 checks every block) without a fixed stride an
+   engine bug could alias with. */
+static unsigned long xcheck_gap(des_xcheck *xc) {
+  xc->rng ^= xc->rng << 13;
+  xc->rng &= 0xffffffffL;
+  xc->rng ^= xc->rng >> 17;
+  xc->rng ^= xc->rng << 5;
+  xc->rng &= 0xffffffffL;
+  return xc->rng % (2 * xc->rate - 1);
+}
+
+static int xcheck_run(des_xcheck *xc, des_ctx *dc, unsigned char *data,
+                      int blocks, int decrypt) {
+  unsigned char in[XCHECK_MAX][8], ref[8];
+  unsigned long work[2];
+  int pos[XCHECK_MAX], n, bad = 0, i;
+  unsigned long p, end, seg;
+  unsigned char *cp;
+
+  xc->blocks += blocks;
+  if (xc->rate == 0 || xc->skip >= (unsigned long) blocks) {
+    if (xc->rate)
+      xc->skip -= blocks;
+    if (decrypt)
+      xc->dec(dc, data, blocks);
+    else
+      xc->enc(dc, data, blocks);
+    return 0;
+  }
+
+  /* Hand the engine segments holding at most XCHECK_MAX samples each,
+     remembering the sampled inputs before they are overwritten. */
+  for (seg=0; seg<(unsigned long) blocks; seg=end) {
+    n = 0;
+    for (p=seg+xc->skip; p<(unsigned long) blocks && n<XCHECK_MAX;
+         p+=1+xcheck_gap(xc)) {
+      pos[n] = (int) (p - seg);
+      memcpy(in[n++], data + 8*p, 8);
+    }
+    end = n == XCHECK_MAX ? seg + pos[n-1] + 1 : (unsigned long) blocks;
+    xc->skip = p - end;
+
+    cp = data + 8*seg;
+    if (decrypt)
+      xc->dec(dc, cp, (int) (end - seg));
+    else
+      xc->enc(dc, cp, (int) (end - seg));
+
+    for (i=0; i<n; i++) {
+      scrunch(in[i], work);
+      desfunc(work, decrypt ? dc->dk : dc->ek);
+      unscrun(work, ref);
+      if (memcmp(ref, cp + 8*pos[i], 8) != 0)
+        bad++;
+    }
+    xc->checked += n;
+  }
+  xc->mismatches += bad;
+  if (bad && xc->fail_closed)
+    memset(data, 0, 8 * (size_t) blocks);
+  return bad;
+}
+
+int des_xcheck_enc(des_xcheck *xc, des_ctx *dc, unsigned char *data,
+                   int blocks) {
+  return xcheck_run(xc, dc, data, blocks, 0);
+}
+
+int des_xcheck_dec(des_xcheck *xc, des_ctx *dc, unsigned char *data,
+                   int blocks) {
+  return xcheck_run(xc, dc, data, blocks, 1);
+}
+
+/* desfunc() over a 32-bit arena schedule.  step is +2 to walk the
+   schedule forward (encrypt) or -2 to walk it backwards from the last
+   round's pair (decrypt), so one stored schedule serves both. */
+static void desfunc32(unsigned long *block, const unsigned int *keys,
+                      int step) {
+  register unsigned long fval, work, right, leftt;
+  register int round;
+
+  leftt = block[0];
+  right = block[1];
+  work = ((leftt>>4) ^ right) & 0x0f0f0f0fL;
+  right ^= work;
+  leftt ^= (work<<4);
+  work = ((leftt>>16) ^ right) & 0x0000ffffL;
+  right ^= work;
+  leftt ^= (work<<16);
+  work = ((right>>2) ^ leftt) & 0x33333333L;
+  leftt ^= work;
+  right ^= (work<<2);
+  work = ((right>>8) ^ leftt) & 0x00ff00ffL;
+  leftt ^= work;
+  right ^= (work<<8);
+  right = ((right<<1) | ((right>>31) & 1L)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  leftt = ((leftt<<1) | ((leftt>>31) & 1L)) & 0xffffffffL;
+
+  if (step < 0)
+    keys += 30;
+  for (round=0; round<8; round++) {
+    work  = (right<<28) | (right>>4);
+    work ^= keys[0];
+    fval  = SP7[work       & 0x3fL];
+    fval |= SP5[(work>> 8) & 0x3fL];
+    fval |= SP3[(work>>16) & 0x3fL];
+    fval |= SP1[(work>>24) & 0x3fL];
+    work  = right ^ keys[1];
+    fval |= SP8[work       & 0x3fL];
+    fval |= SP6[(work>> 8) & 0x3fL];
+    fval |= SP4[(work>>16) & 0x3fL];
+    fval |= SP2[(work>>24) & 0x3fL];
+    leftt ^= fval;
+    keys += step;
+    work  = (leftt<<28) | (leftt>>4);
+    work ^= keys[0];
+    fval  = SP7[work       & 0x3fL];
+    fval |= SP5[(work>> 8) & 0x3fL];
+    fval |= SP3[(work>>16) & 0x3fL];
+    fval |= SP1[(work>>24) & 0x3fL];
+    work  = leftt ^ keys[1];
+    fval |= SP8[work       & 0x3fL];
+    fval |= SP6[(work>> 8) & 0x3fL];
+    fval |= SP4[(work>>16) & 0x3fL];
+    fval |= SP2[(work>>24) & 0x3fL];
+    right ^= fval;
+    keys += step;
+  }
+
+  right = ((right<<31) | (right>>1)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  leftt = ((leftt<<31) | (leftt>>1)) & 0xffffffffL;
+  work = ((leftt>>8) ^ right) & 0x00ff00ffL;
+  right ^= work;
+  leftt ^= (work<<8);
+  work = ((leftt>>2) ^right) & 0x33333333L;
+  right ^= work;
+  leftt ^= (work<<2);
+  work = ((right>>16) ^ leftt) & 0x0000ffffL;
+  leftt ^= work;
+  right ^= (work<<16);
+  work = ((right>>4) ^ leftt) & 0x0f0f0f0fL;
+  leftt ^= work;
+  right ^= (work<<4);
+  *block++ = right & 0xffffffffL;
+  *block = leftt & 0xffffffffL;
+}
+
+#define ARENA_SLOT(h)  (((h) & 0xffffffU) - 1U)
+#define ARENA_GEN(h)   ((h) >> 24)
+
+int des_arena_init(des_arena *a, unsigned int cap, unsigned int nkeys) {
+  size_t bytes;
+  void *p;
+  unsigned int i;
+
+  memset(a, 0, sizeof(*a));
+  if (cap == 0 || cap > DES_ARENA_MAXCAP || nkeys == 0 || nkeys > 3)
+    return -1;
+  bytes = (size_t) cap * nkeys * DES_ARENA_WORDS * sizeof(unsigned int);
+  /* 200k triple sessions are ~75 MB: 2 MB pages keep them in the TLB.
+     madvise() wants whole pages, so a large arena is 2 MB aligned and
+     rounded up to whole 2 MB pages. */
+  if (bytes >= DES_ARENA_HUGE) {
+    bytes = (bytes + DES_ARENA_HUGE - 1) & ~(size_t) (DES_ARENA_HUGE - 1);
+    if (posix_memalign(&p, DES_ARENA_HUGE, bytes) != 0)
+      return -1;
+#ifdef MADV_HUGEPAGE
+    a->huge = madvise(p, bytes, MADV_HUGEPAGE) == 0;
+#endif
+  } else if (posix_memalign(&p, 64, bytes) != 0) {
+    return -1;
+  }
+  a->ks = p;
+  a->gen = calloc(cap, sizeof(*a->gen));
+  a->next = malloc(cap * sizeof(*a->next));
+  if (a->gen == NULL || a->next == NULL) {
+    des_arena_destroy(a);
+    return -1;
+  }
+  for (i=0; i<cap; i++)
+    a->next[i] = i + 1;
+  a->cap = cap;
+  a->nkeys = nkeys;
+  a->free_head = 0;
+  return 0;
+}
+
+void des_arena_destroy(des_arena *a) {
+  free(a->ks);
+  free(a->gen);
+  free(a->next);
+  memset(a, 0, sizeof(*a));
+}
+
+unsigned int des_arena_alloc(des_arena *a, unsigned int *handles,
+                             unsigned int n) {
+  size_t words = (size_t) a->nkeys * DES_ARENA_WORDS;
+  unsigned int i, s;
+
+  if (n > a->cap - a->live)
+    return 0;
+  for (i=0; i<n; i++) {
+    s = a->free_head;
+    a->free_head = a->next[s];
+    a->gen[s]++;                       /* even (free) -> odd (live) */
+    memset(a->ks + s * words, 0, words * sizeof(unsigned int));
+    handles[i] = ((unsigned int) a->gen[s] << 24) | (s + 1);
+  }
+  a->live += n;
+  return n;
+}
+
+unsigned int *des_arena_lookup(des_arena *a, unsigned int h) {
+  unsigned int s = ARENA_SLOT(h);
+
+  if (s >= a->cap || a->gen[s] != ARENA_GEN(h) || !(a->gen[s] & 1))
+    return NULL;
+  return a->ks + (size_t) s * a->nkeys * DES_ARENA_WORDS;
+}
+
+void des_arena_free(des_arena *a, const unsigned int *handles,
+                    unsigned int n) {
+  unsigned int i, s;
+
+  for (i=0; i<n; i++) {
+    if (des_arena_lookup(a, handles[i]) == NULL)
+      continue;
+    s = ARENA_SLOT(handles[i]);
+    a->gen[s]++;                       /* odd (live) -> even (free) */
+    a->next[s] = a->free_head;
+    a->free_head = s;
+    a->live--;
+  }
+}
+
+int des_arena_key(des_arena *a, unsigned int h, unsigned int k,
+                  unsigned char *key) {
+  unsigned int *ks = des_arena_lookup(a, h);
+  unsigned long cooked[32];
+  int i;
+
+  if (ks == NULL || k >= a->nkeys)
+    return -1;
+  deskey_r(key, EN0, cooked);
+  ks += k * DES_ARENA_WORDS;
+  for (i=0; i<32; i++)
+    ks[i] = (unsigned int) cooked[i];
+  return 0;
+}
+
+static void arena_ecb(const unsigned int *ks, int step, unsigned char *data,
+                      int blocks) {
+  unsigned long work[2];
+  int i;
+
+  for (i=0; i<blocks; i++, data += 8) {
+    scrunch(data, work);
+    desfunc32(work, ks, step);
+    unscrun(work, data);
+  }
+}
+
+int des_arena_enc(des_arena *a, unsigned int h, unsigned int k,
+                  unsigned char *data, int blocks) {
+  unsigned int *ks = des_arena_lookup(a, h);
+
+  if (ks == NULL || k >= a->nkeys)
+    return -1;
+  arena_ecb(ks + k * DES_ARENA_WORDS, 2, data, blocks);
+  return 0;
+}
+
+int des_arena_dec(des_arena *a, unsigned int h, unsigned int k,
+                  unsigned char *data, int blocks) {
+  unsigned int *ks = des_arena_lookup(a, h);
+
+  if (ks == NULL || k >= a->nkeys)
+    return -1;
+  arena_ecb(ks + k * DES_ARENA_WORDS, -2, data, blocks);
+  return 0;
+}
+
+int des_arena_enc3(des_arena *a, unsigned int h, unsigned char *data,
+                   int blocks) {
+  unsigned int *ks = des_arena_lookup(a, h);
+  unsigned long work[2];
+  int i;
+
+  if (ks == NULL || a->nkeys < 3)
+    return -1;
+  for (i=0; i<blocks; i++, data += 8) {
+    scrunch(data, work);
+    desfunc32(work, ks, 2);
+    desfunc32(work, ks + DES_ARENA_WORDS, 2);
+    desfunc32(work, ks + 2*DES_ARENA_WORDS, 2);
+    unscrun(work, data);
+  }
+  return 0;
+}
+
+int des_arena_dec3(des_arena *a, unsigned int h, unsigned char *data,
+                   int blocks) {
+  unsigned int *ks = des_arena_lookup(a, h);
+  unsigned long work[2];
+  int i;
+
+  if (ks == NULL || a->nkeys < 3)
+    return -1;
+  for (i=0; i<blocks; i++, data += 8) {
+    scrunch(data, work);
+    desfunc32(work, ks + 2*DES_ARENA_WORDS, -2);
+    desfunc32(work, ks + DES_ARENA_WORDS, -2);
+    desfunc32(work, ks, -2);
+    unscrun(work, data);
+  }
+  return 0;
+}
+
+/* Key-schedule cache */
+
+static unsigned long long kcache_hash(const unsigned char *key, int len) {
+  unsigned long long h = 0x9e3779b97f4a7c15ULL, w;
+  int i, j;
+
+  for (i=0; i<len; i+=8) {
+    for (j=0, w=0; j<8; j++)
+      w = (w << 8) | key[i+j];
+    h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 31;
+  }
+  return h;
+}
+
+int des_kcache_init(des_kcache *c, size_t max_bytes, int nkeys) {
+  size_t entsize, per_ent, per_shard;
+  unsigned long cap, nb;
+  char *p;
+  int s;
+
+  memset(c, 0, sizeof(*c));
+  if (nkeys != 1 && nkeys != 3)
+    return -1;
+  entsize = sizeof(des_kcache_ent) + (nkeys - 1) * sizeof(des_ctx);
+  entsize = (entsize + 63) & ~(size_t) 63;
+  /* an entry plus, at a load of 1, one bucket pointer */
+  per_ent = entsize + sizeof(des_kcache_ent *);
+  per_shard = max_bytes / DES_KCACHE_SHARDS;
+  cap = (unsigned long) (per_shard / per_ent);
+  if (cap == 0)
+    return -1;
+  for (nb=1; nb<cap; nb<<=1)
+    ;
+  while (cap && cap * entsize + nb * sizeof(des_kcache_ent *) > per_shard)
+    cap--;
+  if (cap == 0)
+    return -1;
+  if (posix_memalign((void **) &p, 64, entsize * cap * DES_KCACHE_SHARDS))
+    return -1;
+  c->pool = p;
+  c->entsize = entsize;
+  c->nkeys = nkeys;
+  for (s=0; s<DES_KCACHE_SHARDS; s++) {
+    des_kcache_shard *sh = &c->shard[s];
+    unsigned long i;
+
+    /* destroy() only tears down shards with buckets, so take the mutex
+       after the buckets: a failed calloc leaves no live mutex behind */
+    sh->bucket = calloc(nb, sizeof(*sh->bucket));
+    if (sh->bucket == NULL) {
+      des_kcache_destroy(c);
+      return -1;
+    }
+    pthread_mutex_init(&sh->lock, NULL);
+    sh->mask = nb - 1;
+    sh->cap = cap;
+    sh->lru.prev = sh->lru.next = &sh->lru;
+    /* thread the shard's slice of the pool onto its spare list */
+    for (i=0; i<cap; i++) {
+      des_kcache_ent *e = (des_kcache_ent *) (p + entsize * (s*cap + i));
+
+      e->next = sh->spare;
+      sh->spare = e;
+    }
+  }
+  return 0;
+}
+
+void des_kcache_destroy(des_kcache *c) {
+  int s;
+
+  for (s=0; s<DES_KCACHE_SHARDS; s++)
+    if (c->shard[s].bucket) {
+      pthread_mutex_destroy(&c->shard[s].lock);
+      free(c->shard[s].bucket);
+    }
+  free(c->pool);
+  memset(c, 0, sizeof(*c));
+}
+
+static void kcache_unlink(des_kcache_ent *e) {
+  e->prev->next = e->next;
+  e->next->prev = e->prev;
+}
+
+static void kcache_push(des_kcache_shard *sh, des_kcache_ent *e) {
+  e->prev = &sh->lru;
+  e->next = sh->lru.next;
+  sh->lru.next->prev = e;
+  sh->lru.next = e;
+}
+
+static des_kcache_ent *kcache_find(des_kcache_shard *sh,
+                                   unsigned long long h,
+                                   const unsigned char *key, int len) {
+  des_kcache_ent *e;
+
+  for (e=sh->bucket[h & sh->mask]; e; e=e->chain)
+    if (e->hash == h && memcmp(e->key, key, len) == 0)
+      return e;
+  return NULL;
+}
+
+int des_kcache_get(des_kcache *c, unsigned char *key, des_ctx *ctx) {
+  int len = 8 * c->nkeys, k;
+  unsigned long long h = kcache_hash(key, len);
+  des_kcache_shard *sh = &c->shard[(h >> 56) % DES_KCACHE_SHARDS];
+  des_kcache_ent *e, **pp;
+  size_t bytes = c->nkeys * sizeof(des_ctx);
+
+  pthread_mutex_lock(&sh->lock);
+  if ((e = kcache_find(sh, h, key, len)) != NULL) {
+    kcache_unlink(e);
+    kcache_push(sh, e);
+    memcpy(ctx, e->ctx, bytes);
+    sh->hits++;
+    pthread_mutex_unlock(&sh->lock);
+    return 1;
+  }
+  sh->misses++;
+  pthread_mutex_unlock(&sh->lock);
+
+  /* expand outside the lock; other shards' users are never held up */
+  for (k=0; k<c->nkeys; k++)
+    des_key(&ctx[k], key + 8*k);
+
+  pthread_mutex_lock(&sh->lock);
+  if (kcache_find(sh, h, key, len) == NULL) {
+    if (sh->spare) {
+      e = sh->spare;
+      sh->spare = e->next;
+      sh->used++;
+    } else {
+      /* recycle the least recently used entry */
+      e = sh->lru.prev;
+      kcache_unlink(e);
+      for (pp=&sh->bucket[e->hash & sh->mask]; *pp!=e; pp=&(*pp)->chain)
+        ;
+      *pp = e->chain;
+      sh->evictions++;
+    }
+    e->hash = h;
+    memcpy(e->key, key, len);
+    memcpy(e->ctx, ctx, bytes);
+    e->chain = sh->bucket[h & sh->mask];
+    sh->bucket[h & sh->mask] = e;
+    kcache_push(sh, e);
+  }
+  pthread_mutex_unlock(&sh->lock);
+  return 0;
+}
+
+void des_kcache_stats(des_kcache *c, unsigned long long *hits,
+                      unsigned long long *misses,
+                      unsigned long long *evictions, unsigned long *entries) {
+  unsigned long long th = 0, tm = 0, te = 0;
+  unsigned long tn = 0;
+  int s;
+
+  for (s=0; s<DES_KCACHE_SHARDS; s++) {
+    pthread_mutex_lock(&c->shard[s].lock);
+    th += c->shard[s].hits;
+    tm += c->shard[s].misses;
+    te += c->shard[s].evictions;
+    tn += c->shard[s].used;
+    pthread_mutex_unlock(&c->shard[s].lock);
+  }
+  if (hits) *hits = th;
+  if (misses) *misses = tm;
+  if (evictions) *evictions = te;
+  if (entries) *entries = tn;
+}
+
 int chartohex(char input)
 {
     int output;
@@ -453,6 +1758,10 @@ void hexify(char input[16], char * output)
     }
 }
 
+/* Tools that link the engine directly (#include "des.c") define
+   DES_NO_MAIN to drop the Key.txt/Plaintextin.txt driver below. */
+#ifndef DES_NO_MAIN
+
 // Note: all uncommented blocks of code are unchanged from the original
 void main (void)
 {
@@ -848,3 +2157,5 @@ void main (void)
   // fclose(keyPointer);
 
 }
+
+#endif /* DES_NO_MAIN */
@@ -1,11 +1,86 @@
+#include <pthread.h>
+#include <sys/uio.h>
+
 #define EN0 0 /* MODE == encrypt */
 #define DE1 1 /* MODE == decrypt */
 
+/* Blocks per interleaved kernel call in ECB, CTR and CBC decryption:
+ * 2, 4 or 8, or 1 for one block at a time through desfunc().  DES_TRACE
+ * builds always use 1 so every round is still traced.
+ */
+#ifndef DES_INTERLEAVE
+#define DES_INTERLEAVE 4
+#endif
+#ifdef DES_TRACE
+#undef DES_INTERLEAVE
+#define DES_INTERLEAVE 1
+#endif
+
+/* ECB, CTR and CBC decryption hand groups of eight blocks to an AVX2
+ * kernel when the CPU has it (checked at run time).  Off for DES_TRACE
+ * builds and with -DDES_NO_AVX2.
+ */
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(DES_TRACE) && \
+    !defined(DES_NO_AVX2)
+#define DES_AVX2 1
+#endif
+
+/* deskey_r() (and so deskey, des_key and every rekey) uses a BMI2
+ * pext/pdep schedule when the CPU has it.  Off with -DDES_NO_BMI2.
+ */
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(DES_NO_BMI2)
+#define DES_BMI2 1
+#endif
+
 typedef struct {
   unsigned long ek[32];
   unsigned long dk[32];
 } des_ctx;
 
+/* Round-level trace capture.  Build with -DDES_TRACE and attach a
+ * des_tracer; desfunc() then appends one record after the initial
+ * permutation (round 0, no subkey) and one after every round 1..16.
+ * Without DES_TRACE the hooks expand to nothing.
+ *
+ * l/r are the standard (un-rotated) 32-bit halves L_i/R_i.  k0/k1 are
+ * the two cooked subkey words used by the round; des_trace_subkey()
+ * turns them back into the 48-bit K_i of the Standard.
+ */
+typedef struct {
+  unsigned int round;
+  unsigned int l, r;
+  unsigned int k0, k1;
+} des_trace_rec;
+
+typedef struct {
+  des_trace_rec *buf;
+  unsigned long cap;       /* records that fit in buf */
+  unsigned long len;       /* records currently in buf */
+  unsigned long dropped;   /* records lost because buf was full */
+  /* Called with the buffer when it fills; may be NULL.  The buffer is
+     reused after it returns. */
+  void (*flush)(des_trace_rec *, unsigned long, void *);
+  void *arg;
+} des_tracer;
+
+#ifdef DES_TRACE
+extern void des_trace_attach(des_tracer *);
+/*                              tracer
+ * Routes the records of every later desfunc() call into tracer, or
+ * stops tracing if tracer is NULL.
+ */
+
+extern void des_trace_flush(void);
+/* Hands any buffered records to the attached tracer's flush callback.
+ */
+#endif
+
+extern unsigned long long des_trace_subkey(unsigned int, unsigned int);
+/*                                          k0            k1
+ * Returns the 48-bit round key K_i (bit 1 of the Standard in bit 47)
+ * from a pair of cooked key words.
+ */
+
 extern void deskey(unsigned char *, short);
 /*                    hexkey[8]      MODE
  * Sets the internal key register according to the hexadecimal
@@ -30,6 +105,249 @@ extern void des(unsigned char *, unsigned char *);
  * into the block at address 'to'. They can be the same.
 */
 
+extern long des_encv(des_ctx *, const struct iovec *, int);
+extern long des_decv(des_ctx *, const struct iovec *, int);
+/*                      dc       iov                   iovcnt
+ * ECB in place over the concatenation of the iov fragments, with no
+ * staging copy.  Fragments may have any length and blocks may straddle
+ * them; only the total must be a multiple of 8.  Returns the number of
+ * blocks, or -1 (nothing written) if the total is not whole blocks.
+ */
+
+extern long des_encv_to(des_ctx *, const struct iovec *, int,
+                        const struct iovec *, int);
+extern long des_decv_to(des_ctx *, const struct iovec *, int,
+                        const struct iovec *, int);
+/*                         dc       src                   nsrc
+ *                                  dst                   ndst
+ * As above, reading src and writing dst, which may be fragmented
+ * differently.  -1 also if dst holds fewer bytes than src.  src and dst
+ * must either be the same vector or not overlap.
+ */
+
+extern unsigned long long des_enc_u64(des_ctx *, unsigned long long);
+extern unsigned long long des_dec_u64(des_ctx *, unsigned long long);
+/*                                       dc        block
+ * One block as a 64-bit value, first byte in the most significant
+ * bits (the same value as the VHDL 64-bit bus).  Returns the result.
+ */
+
+extern void des_enc64(des_ctx *, unsigned long long *, int);
+extern void des_dec64(des_ctx *, unsigned long long *, int);
+/*                      dc        blocks[n]            n
+ * ECB in place on blocks in wire (big-endian) order, i.e. des_enc/
+ * des_dec on the same bytes, with the same batched kernels.
+ */
+
+extern unsigned long long des_chain_u64(unsigned long long,
+                                        unsigned long *const *, int);
+/*                                        block    keys[n]     n
+ * Runs block through n single-DES operations, keys[i] being a dc->ek
+ * (encrypt) or dc->dk (decrypt), with IP only before the first and FP
+ * only after the last; L/R stay in registers in between.  Triple DES
+ * as main() chains it is keys {k1.ek, k2.ek, k3.ek}.
+ */
+
+extern void des_chain64(unsigned long *const *, int,
+                        unsigned long long *, int);
+/*                        keys[n]                n
+ *                                               blocks[count]  count
+ * des_chain_u64 over wire-order blocks in place.
+ */
+
+extern int des_simd_avx2(int);
+/*                        enable
+ * 0 stops ECB/CTR/CBC from using the AVX2 kernel, 1 uses it again if
+ * the CPU has AVX2, -1 leaves it as is.  Returns whether it is in use.
+ * Meant for benchmarks and testing; not synchronised with callers that
+ * are encrypting at the time.
+ */
+
+extern int des_simd_bmi2(int);
+/*                        enable
+ * As des_simd_avx2, for the BMI2 key schedule.  Never on for AMD
+ * before Zen 3, where pdep/pext are microcoded and slower than the
+ * portable schedule.
+ */
+
+/* Differential cross-checker.  Wraps an alternative ECB engine (same
+ * calling convention as des_enc/des_dec) and re-runs a random sample of
+ * its blocks through the reference desfunc(), counting mismatches.  One
+ * des_xcheck per thread: the counters are not atomic.
+ */
+typedef struct {
+  const char *name;
+  void (*enc)(des_ctx *, unsigned char *, int);
+  void (*dec)(des_ctx *, unsigned char *, int);
+  unsigned long rate;            /* check ~1 block in rate; 0 = never */
+  int fail_closed;               /* zero the whole batch on a mismatch */
+  unsigned long skip;            /* blocks left until the next sample */
+  unsigned long rng;
+  unsigned long long blocks;     /* blocks through the engine */
+  unsigned long long checked;    /* blocks re-run through desfunc */
+  unsigned long long mismatches;
+} des_xcheck;
+
+extern void des_xcheck_init(des_xcheck *, const char *,
+                            void (*)(des_ctx *, unsigned char *, int),
+                            void (*)(des_ctx *, unsigned char *, int),
+                            unsigned long, int);
+/*                           xc, name, enc, dec, rate, fail_closed
+ * rate 1000 checks about 0.1% of blocks, rate 1 every block.
+ */
+
+extern int des_xcheck_enc(des_xcheck *, des_ctx *, unsigned char *, int);
+extern int des_xcheck_dec(des_xcheck *, des_ctx *, unsigned char *, int);
+/*                          xc           dc        data[8*blocks]  blocks
+ * Runs the engine over data in place and checks the sampled blocks.
+ * Returns the number of mismatching samples (0 when all agree); with
+ * fail_closed set, data is zeroed before a non-zero return so no
+ * unverified output escapes.
+ */
+
+/* Context arena for many live sessions.  Schedules are kept as arrays
+ * of 32-bit words, one 128-byte (two cache line) encrypt schedule per
+ * key; decryption walks the same schedule backwards, so no dk copy is
+ * stored.  A session of nkeys keys is nkeys*128 bytes, against
+ * nkeys*512 for des_ctx on LP64.  The schedules, generations and free
+ * list links are separate arrays (structure of arrays), so bulk
+ * allocation and lookups only touch the words they need.
+ *
+ * A handle is a 32-bit value: slot index + 1 in the low 24 bits, the
+ * slot's generation in the top 8.  The generation is odd while the slot
+ * is live and is bumped on every alloc and free, so a stale handle is
+ * rejected instead of reaching the slot's next session (for 128 reuses).
+ * Handle 0 (DES_ARENA_NONE) is never valid.  Not thread-safe.
+ */
+#define DES_ARENA_NONE    0U
+#define DES_ARENA_MAXCAP  0xffffffU
+#define DES_ARENA_WORDS   32          /* schedule words per key */
+#define DES_ARENA_HUGE    (2U << 20)  /* huge page size */
+
+typedef struct {
+  unsigned int *ks;        /* cap * nkeys * DES_ARENA_WORDS, 64-byte aligned */
+  unsigned char *gen;      /* generation of each slot */
+  unsigned int *next;      /* free list link of each free slot */
+  unsigned int cap;        /* slots */
+  unsigned int nkeys;      /* keys per session */
+  unsigned int free_head;  /* first free slot, cap when full */
+  unsigned int live;       /* slots handed out */
+  int huge;                /* ks advised onto huge pages (madvise ok) */
+} des_arena;
+
+extern int des_arena_init(des_arena *, unsigned int, unsigned int);
+/*                          arena       cap           nkeys
+ * Allocates room for cap sessions (at most DES_ARENA_MAXCAP) of nkeys
+ * keys each (1 for DES, 3 for triple DES) in one block.  Returns 0, or
+ * -1 if cap/nkeys is out of range or memory is short.  Schedules of
+ * DES_ARENA_HUGE bytes or more are allocated in whole huge pages and
+ * advised with MADV_HUGEPAGE; arena->huge says whether that took.
+ */
+
+extern void des_arena_destroy(des_arena *);
+/* Releases the arena's memory; every handle becomes invalid.
+ */
+
+extern unsigned int des_arena_alloc(des_arena *, unsigned int *,
+                                    unsigned int);
+/*                                    arena      handles[n]     n
+ * Hands out n sessions, all or nothing.  Returns n, or 0 (handles
+ * untouched) if fewer than n slots are free.  Schedules start zeroed.
+ */
+
+extern void des_arena_free(des_arena *, const unsigned int *,
+                           unsigned int);
+/*                           arena      handles[n]           n
+ * Returns n sessions to the arena.  Invalid or stale handles are
+ * skipped.
+ */
+
+extern unsigned int *des_arena_lookup(des_arena *, unsigned int);
+/*                                      arena       handle
+ * Returns the session's first schedule (nkeys follow back to back), or
+ * NULL if the handle is not live.  O(1): a mask and one compare.
+ */
+
+extern int des_arena_key(des_arena *, unsigned int, unsigned int,
+                         unsigned char *);
+/*                         arena       handle        k         key[8]
+ * Expands key into schedule k of the session.  Returns 0 or -1.
+ */
+
+extern int des_arena_enc(des_arena *, unsigned int, unsigned int,
+                         unsigned char *, int);
+extern int des_arena_dec(des_arena *, unsigned int, unsigned int,
+                         unsigned char *, int);
+/*                         arena       handle        k
+ *                         data[8*blocks]   blocks
+ * ECB with schedule k of the session, in place.  Returns 0 or -1.
+ */
+
+extern int des_arena_enc3(des_arena *, unsigned int, unsigned char *, int);
+extern int des_arena_dec3(des_arena *, unsigned int, unsigned char *, int);
+/*                          arena       handle        data[8*blocks] blocks
+ * Triple DES the way main() chains it: encrypt with keys 0, 1, 2;
+ * decrypt with 2, 1, 0.  Needs nkeys >= 3.  Returns 0 or -1.
+ */
+
+/* Key-schedule cache.  Maps a raw key (8 bytes, or a 24-byte triple
+ * when nkeys is 3) to its ready des_ctx schedules, so a hot key skips
+ * deskey() altogether.  The cache is split into DES_KCACHE_SHARDS
+ * shards by key hash.  Each shard has its own mutex, hash table and LRU
+ * list, and a fixed pool of entries sized from the memory cap, so
+ * nothing is allocated after init.  On a miss the key is expanded
+ * outside the lock and the least recently used entry of the shard is
+ * recycled.  Safe to share between threads.
+ */
+#define DES_KCACHE_SHARDS 16
+
+typedef struct des_kcache_ent {
+  struct des_kcache_ent *prev, *next;   /* LRU list, most recent first */
+  struct des_kcache_ent *chain;         /* hash bucket chain */
+  unsigned long long hash;
+  unsigned char key[24];
+  des_ctx ctx[1];                       /* nkeys schedules */
+} des_kcache_ent;
+
+typedef struct {
+  pthread_mutex_t lock;
+  des_kcache_ent **bucket;
+  unsigned long mask;                   /* buckets - 1 */
+  des_kcache_ent lru;                   /* list head; ctx unused */
+  des_kcache_ent *spare;                /* never-used pool entries */
+  unsigned long used, cap;
+  unsigned long long hits, misses, evictions;
+} des_kcache_shard;
+
+typedef struct {
+  des_kcache_shard shard[DES_KCACHE_SHARDS];
+  void *pool;
+  size_t entsize;
+  int nkeys;
+} des_kcache;
+
+extern int des_kcache_init(des_kcache *, size_t, int);
+/*                           cache        max_bytes  nkeys
+ * Sets up a cache for single keys (nkeys 1) or triples (nkeys 3) that
+ * uses at most max_bytes for its entries and buckets.  Returns 0, or -1
+ * if the cap holds fewer than one entry per shard or memory is short.
+ */
+
+extern void des_kcache_destroy(des_kcache *);
+
+extern int des_kcache_get(des_kcache *, unsigned char *, des_ctx *);
+/*                          cache        key[8*nkeys]     ctx[nkeys]
+ * Copies the schedules for key into ctx, expanding and inserting them
+ * on a miss.  Returns 1 on a hit, 0 on a miss.
+ */
+
+extern void des_kcache_stats(des_kcache *, unsigned long long *,
+                             unsigned long long *, unsigned long long *,
+                             unsigned long *);
+/*                             cache  hits  misses  evictions  entries
+ * Totals over all shards; any pointer may be NULL.
+ */
+
 static void scrunch(unsigned char *, unsigned long *);
 static void unscrun(unsigned long *, unsigned char *);
 static void desfunc(unsigned long *, unsigned long *);
@@ -0,0 +1,164 @@
+/* Cycle-accurate model of des_vhdl/des_agile_cipher_top.vhd, the
+ * key-agile core.  Conventions as in desCore.h: one agile_clock() call
+ * is one rising edge, registers update from their pre-edge values, VHDL
+ * bit 0 is the uint64 MSB.
+ *
+ *   input register   data_in/function_select on lddata; data_ready is
+ *                    held until the core takes the block
+ *   key_schedule     K1..K16 of key_in on every edge (held in reset)
+ *   agile banks      capture <= key_valid; a captured expansion goes to
+ *                    the active bank if a block starts on that edge,
+ *                    else to the shadow bank (pending); a starting block
+ *                    swaps a pending shadow bank in
+ *   des_agile_top    des_top without WaitKey: WaitData -> InitialRound
+ *                    when data_ready and a key has been strobed, and
+ *                    FinalRound -> WaitData
+ *
+ * Header-only (static); include after des.c and desCore.h.
+ */
+
+typedef struct {
+  /* inputs, sampled at the next rising edge */
+  uint64_t key_in;
+  int key_valid;
+  uint64_t data_in;
+  int function_select;         /* 1 = encrypt, 0 = decrypt */
+  int lddata;
+  int reset;
+
+  /* outputs (registered) */
+  uint64_t data_out;
+  int core_busy;
+  int des_out_rdy;
+
+  /* des_agile_cipher_top */
+  uint64_t data_in_internal;
+  int func_internal;
+  int data_ready_internal;
+
+  /* key_schedule */
+  unsigned long ks[32];
+  uint64_t ks_key;
+  int ks_valid;
+
+  /* key_schedule_agile */
+  unsigned long active[32];
+  unsigned long shadow[32];
+  int capture, pending, loaded;
+
+  /* des_agile_top */
+  enum core_state state;
+  unsigned int round_counter;  /* 4 bits */
+  unsigned int key_select;     /* 4 bits */
+  int func;                    /* FuncLatched */
+  uint32_t l_in, r_in;
+
+  unsigned long long cycle;
+  unsigned long long swaps;    /* blocks that started on a shadow key */
+} des_agile;
+
+static void agile_init(des_agile *c) {
+  memset(c, 0, sizeof(*c));
+  c->state = WaitData;
+}
+
+/* key_ready of key_schedule_agile. */
+static int agile_key_ready(const des_agile *c) {
+  return c->loaded || c->capture;
+}
+
+static void agile_clock(des_agile *c) {
+  /* combinational paths, from the pre-edge register values */
+  const unsigned long *kout = &c->active[2 * c->key_select];
+  uint32_t l_out = c->r_in;
+  uint32_t r_out = c->l_in ^ core_f(c->r_in, kout);
+  unsigned int step = c->func ? 1 : 15;               /* +1 / -1 mod 16 */
+  int start = c->state == WaitData && c->data_ready_internal &&
+              agile_key_ready(c);                      /* key_swap */
+  uint64_t data = c->data_in_internal;
+  int func = c->func_internal;
+
+  /* input register */
+  if (c->reset) {
+    c->data_ready_internal = 0;
+  } else if (c->lddata) {
+    c->data_in_internal = c->data_in;
+    c->func_internal = c->function_select ? 1 : 0;
+    c->data_ready_internal = 1;
+  } else if (start) {
+    c->data_ready_internal = 0;
+  }
+
+  /* key banks, from key_schedule's pre-edge K1..K16 */
+  if (c->reset) {
+    c->capture = c->pending = c->loaded = 0;
+  } else {
+    if (c->capture) {
+      if (start) {
+        memcpy(c->active, c->ks, sizeof(c->active));
+        c->pending = 0;
+      } else {
+        memcpy(c->shadow, c->ks, sizeof(c->shadow));
+        c->pending = 1;
+      }
+      c->loaded = 1;
+    } else if (start && c->pending) {
+      memcpy(c->active, c->shadow, sizeof(c->active));
+      c->pending = 0;
+      c->swaps++;
+    }
+    c->capture = c->key_valid ? 1 : 0;
+  }
+
+  /* key_schedule */
+  if (!c->reset && (!c->ks_valid || c->ks_key != c->key_in)) {
+    core_expand(c->key_in, c->ks);
+    c->ks_key = c->key_in;
+    c->ks_valid = 1;
+  }
+
+  /* des_agile_top FSM */
+  if (c->reset) {
+    c->state = WaitData;
+    c->round_counter = 0;
+    c->core_busy = 0;
+    c->des_out_rdy = 0;
+  } else {
+    switch (c->state) {
+    case WaitData:
+      if (start) {
+        c->core_busy = 1;
+        core_ip(data, &c->l_in, &c->r_in);
+        c->func = func;
+        c->key_select = func ? 0 : 15;
+        c->state = InitialRound;
+      }
+      break;
+    case InitialRound:
+      c->l_in = l_out;
+      c->r_in = r_out;
+      c->key_select = (c->key_select + step) & 0xf;
+      c->state = RepeatRound;
+      break;
+    case RepeatRound:
+      c->l_in = l_out;
+      c->r_in = r_out;
+      c->key_select = (c->key_select + step) & 0xf;
+      if (c->round_counter == 0xe) {
+        c->data_out = core_fp(l_out, r_out);
+        c->core_busy = 0;
+        c->des_out_rdy = 1;
+        c->state = FinalRound;
+      }
+      c->round_counter = (c->round_counter + 1) & 0xf;
+      break;
+    case FinalRound:
+    default:
+      c->round_counter = 0;
+      c->state = WaitData;
+      c->des_out_rdy = 0;
+      break;
+    }
+  }
+  c->cycle++;
+}
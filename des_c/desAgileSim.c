@@ -0,0 +1,275 @@
+/* Throughput runner for the key-agile core model (desAgile.h) under a
+ * key change on every block.  The default stream is the Key.txt x
+ * Plaintextin.txt fan-out of main() in des.c, walked record-major
+ * (every key for the first record, then every key for the second, ...)
+ * so consecutive blocks never share a key.  Each block's key and data
+ * are strobed together as soon as the core has taken the previous
+ * block, and every output is checked against des_enc/des_dec in order.
+ * The same stream is then run through des_cipher_top (desCore.h) the
+ * way des_cipher_top_tb.vhd drives it, with a reset before every block.
+ *
+ *   gcc -O2 -pthread desAgileSim.c -o desAgileSim
+ *   ./desAgileSim [-k Key.txt] [-p Plaintextin.txt] [-x repeat]
+ *                 [-n blocks] [-r rekey_every] [-M enc|dec|mix]
+ *                 [-s seed] [-o vectors] [-v]
+ *
+ *   -x  run the fan-out N times (default 1)
+ *   -n  random keys and data instead of the fan-out
+ *   -r  with -n: new random key every N blocks (default 1)
+ *   -M  function of each block (default enc; mix = random per block)
+ *   -o  also write the stream as "key func datain dataout" lines, the
+ *       input of des_vhdl/des_agile_cipher_top_tb.vhd
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include "desCore.h"
+#include "desAgile.h"
+#include <unistd.h>
+#include <time.h>
+
+#define SIM_TIMEOUT 64          /* cycles without des_out_rdy = lost */
+
+typedef struct {
+  uint64_t key, data;
+  int func;
+} agile_block;
+
+static unsigned long long sim_state = 0x9e3779b97f4a7c15ULL;
+
+static unsigned long long sim_rand(void) {
+  sim_state ^= sim_state << 13;
+  sim_state ^= sim_state >> 7;
+  sim_state ^= sim_state << 17;
+  return sim_state;
+}
+
+static uint64_t sw_des(uint64_t key, uint64_t data, int encrypt) {
+  unsigned char kb[8], db[8];
+  uint64_t out = 0;
+  des_ctx dc;
+  int i;
+
+  for (i=0; i<8; i++) {
+    kb[i] = (unsigned char) (key >> (56 - 8*i));
+    db[i] = (unsigned char) (data >> (56 - 8*i));
+  }
+  des_key(&dc, kb);
+  if (encrypt)
+    des_enc(&dc, db, 1);
+  else
+    des_dec(&dc, db, 1);
+  for (i=0; i<8; i++)
+    out = (out << 8) | db[i];
+  return out;
+}
+
+static int pick_func(const char *mode) {
+  if (strcmp(mode, "dec") == 0)
+    return 0;
+  if (strcmp(mode, "mix") == 0)
+    return (int) (sim_rand() >> 63);
+  return 1;
+}
+
+/* Records of an input file as big-endian 64-bit words, as main() reads
+   them (first 8 bytes of each line, zero padded). */
+static uint64_t *sim_records(const char *path, long *n) {
+  FILE *fp;
+  char *line = NULL;
+  size_t cap = 0, w, i;
+  uint64_t *out = NULL, r;
+  long alloc = 0;
+
+  if ((fp = fopen(path, "r")) == NULL) {
+    perror(path);
+    exit(1);
+  }
+  *n = 0;
+  while (getline(&line, &cap, fp) != -1) {
+    if (*n == alloc) {
+      alloc = alloc ? 2*alloc : 64;
+      out = realloc(out, alloc * sizeof(*out));
+    }
+    w = strcspn(line, "\r\n");
+    for (i=0, r=0; i<8; i++)
+      r = (r << 8) | (i < w ? (unsigned char) line[i] : 0);
+    out[(*n)++] = r;
+  }
+  free(line);
+  fclose(fp);
+  return out;
+}
+
+/* des_cipher_top_tb.vhd protocol: reset, key and data, wait. */
+static double reset_rekey_cycles(const agile_block *b, long blocks) {
+  des_core c;
+  long v;
+  int i;
+
+  core_init(&c);
+  for (v=0; v<blocks; v++) {
+    c.reset = 1;
+    core_clock(&c);
+    c.reset = 0;
+    c.key_in = b[v].key;
+    c.function_select = b[v].func;
+    c.data_in = b[v].data;
+    c.lddata = 1;
+    for (i=0; !c.des_out_rdy && i<SIM_TIMEOUT; i++)
+      core_clock(&c);
+  }
+  return (double) c.cycle / blocks;
+}
+
+int main(int argc, char **argv) {
+  const char *keyfile = "Key.txt", *textfile = "Plaintextin.txt";
+  const char *mode = "enc", *vecname = NULL;
+  long blocks = -1, rekey = 1, repeat = 1, nkeys, ntext, v, t, i, x;
+  long issued = 0, done = 0, idle;
+  int opt, verbose = 0, busy, free_slot = 1;
+  unsigned long long mismatches = 0, start, lat_sum = 0;
+  unsigned long long *issue_cycle;
+  uint64_t *keys, *text, key = 0, want;
+  agile_block *b;
+  des_agile c;
+  FILE *out = NULL;
+  struct timespec t0, t1;
+  double sec, base, cpb;
+
+  while ((opt = getopt(argc, argv, "k:p:x:n:r:M:s:o:v")) != -1) {
+    switch (opt) {
+    case 'k': keyfile = optarg; break;
+    case 'p': textfile = optarg; break;
+    case 'x': repeat = atol(optarg); break;
+    case 'n': blocks = atol(optarg); break;
+    case 'r': rekey = atol(optarg); break;
+    case 'M': mode = optarg; break;
+    case 's': sim_state = strtoull(optarg, NULL, 0) | 1; break;
+    case 'o': vecname = optarg; break;
+    case 'v': verbose = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-k Key.txt] [-p Plaintextin.txt] "
+                      "[-x repeat] [-n blocks] [-r rekey_every] "
+                      "[-M enc|dec|mix] [-s seed] [-o vectors] [-v]\n",
+                      argv[0]);
+      return 2;
+    }
+  }
+  if (rekey < 1)
+    rekey = 1;
+  if (repeat < 1)
+    repeat = 1;
+
+  /* the stream */
+  if (blocks >= 0) {
+    b = malloc((blocks ? blocks : 1) * sizeof(*b));
+    for (v=0; v<blocks; v++) {
+      if (v % rekey == 0)
+        key = sim_rand();
+      b[v].key = key;
+      b[v].data = sim_rand();
+      b[v].func = pick_func(mode);
+    }
+  } else {
+    keys = sim_records(keyfile, &nkeys);
+    text = sim_records(textfile, &ntext);
+    b = malloc((repeat * nkeys * ntext + 1) * sizeof(*b));
+    blocks = 0;
+    for (x=0; x<repeat; x++)
+      for (i=0; i<ntext; i++)
+        for (t=0; t<nkeys; t++, blocks++) {
+          b[blocks].key = keys[t];
+          b[blocks].data = text[i];
+          b[blocks].func = pick_func(mode);
+        }
+    free(keys);
+    free(text);
+  }
+  if (blocks <= 0) {
+    fprintf(stderr, "nothing to do\n");
+    return 2;
+  }
+  issue_cycle = malloc(blocks * sizeof(*issue_cycle));
+  if (vecname) {
+    if ((out = fopen(vecname, "w")) == NULL) {
+      perror(vecname);
+      return 1;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+    fprintf(out, "# key func datain dataout\n");
+  }
+
+  agile_init(&c);
+  c.reset = 1;
+  agile_clock(&c);
+  c.reset = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  start = c.cycle;
+  idle = 0;
+  while (done < blocks && idle < SIM_TIMEOUT) {
+    /* strobe the next key and block once the previous block was taken */
+    if (free_slot && issued < blocks) {
+      c.key_in = b[issued].key;
+      c.data_in = b[issued].data;
+      c.function_select = b[issued].func;
+      c.key_valid = c.lddata = 1;
+      issue_cycle[issued++] = c.cycle + 1;   /* edge that samples them */
+      free_slot = 0;
+    } else {
+      c.key_valid = c.lddata = 0;
+    }
+    busy = c.core_busy;
+    agile_clock(&c);
+    if (!busy && c.core_busy)
+      free_slot = 1;
+    if (!c.des_out_rdy) {
+      idle++;
+      continue;
+    }
+    idle = 0;
+
+    want = sw_des(b[done].key, b[done].data, b[done].func);
+    lat_sum += c.cycle - issue_cycle[done];
+    if (out)
+      fprintf(out, "%016llx %d %016llx %016llx\n",
+              (unsigned long long) b[done].key, b[done].func,
+              (unsigned long long) b[done].data, (unsigned long long) want);
+    if (verbose)
+      printf("cycle %8llu %s key=%016llx in=%016llx out=%016llx%s\n",
+             c.cycle, b[done].func ? "enc" : "dec",
+             (unsigned long long) b[done].key,
+             (unsigned long long) b[done].data,
+             (unsigned long long) c.data_out,
+             c.data_out == want ? "" : "  MISMATCH");
+    if (c.data_out != want) {
+      if (mismatches < 10)
+        fprintf(stderr, "mismatch: block %ld %s key=%016llx in=%016llx "
+                "hw=%016llx sw=%016llx\n", done, b[done].func ? "enc" : "dec",
+                (unsigned long long) b[done].key,
+                (unsigned long long) b[done].data,
+                (unsigned long long) c.data_out, (unsigned long long) want);
+      mismatches++;
+    }
+    done++;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  if (out)
+    fclose(out);
+
+  cpb = (double) (c.cycle - start) / (done ? done : 1);
+  base = reset_rekey_cycles(b, blocks < 100000 ? blocks : 100000);
+  printf("blocks=%ld cycles=%llu blocks/cycle=%.4f cycles/block=%.2f "
+         "latency=%.2f cycles\n", done, c.cycle - start, 1.0 / cpb, cpb,
+         (double) lat_sum / (done ? done : 1));
+  printf("key changes hidden in the shadow bank: %llu\n", c.swaps);
+  printf("reset-and-rekey (des_cipher_top): %.2f cycles/block -> %.2fx\n",
+         base, base / cpb);
+  printf("lost=%ld mismatches=%llu  (%.2f k blocks/s simulated)\n",
+         blocks - done, mismatches, done / sec / 1e3);
+  free(issue_cycle);
+  free(b);
+  return mismatches || done != blocks ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+/* Session-store benchmark for the des_arena context arena.  Sets up -n
+ * triple-DES sessions twice: as a malloc'd des_ctx per key (ek and dk,
+ * unsigned long) and as one des_arena of 32-bit schedules.  It then
+ * serves -q requests of one block each against randomly chosen sessions,
+ * the access pattern of a gateway with that many live sessions.  Every
+ * arena result is compared with the des_ctx result for the same request,
+ * and a churn pass frees and re-allocates a slice of sessions in bulk,
+ * checking that stale handles are refused.
+ *
+ *   gcc -O2 -pthread desArena.c -o desArena
+ *   ./desArena [-n sessions] [-q requests] [-c churn_percent] [-s seed]
+ *
+ *   -n  live sessions (default 200000)
+ *   -q  requests per measurement (default 2000000)
+ *   -c  sessions freed and re-allocated in the churn pass (default 10)
+ *
+ * Reported per layout: bytes per session, setup time, and requests/s.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+#include <time.h>
+
+static unsigned long long ar_state = 0x853c49e6748fea9bULL;
+
+static unsigned long long ar_rand(void) {
+  ar_state ^= ar_state << 13;
+  ar_state ^= ar_state >> 7;
+  ar_state ^= ar_state << 17;
+  return ar_state;
+}
+
+static void ar_fill(unsigned char *p) {
+  unsigned long long r = ar_rand();
+  int i;
+
+  for (i=0; i<8; i++, r >>= 8)
+    p[i] = (unsigned char) r;
+}
+
+static double ar_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Session keys are a function of the session number, so both layouts
+   (and re-keyed sessions after churn) can be rebuilt from it. */
+static void ar_key(unsigned long s, int k, unsigned char *key) {
+  unsigned long long r = (s + 1) * 0x9e3779b97f4a7c15ULL + k;
+  int i;
+
+  r ^= r >> 29;
+  r *= 0xbf58476d1ce4e5b9ULL;
+  r ^= r >> 32;
+  for (i=0; i<8; i++, r >>= 8)
+    key[i] = (unsigned char) r;
+}
+
+int main(int argc, char **argv) {
+  unsigned long sessions = 200000, requests = 2000000, churn, i, s;
+  int percent = 10, opt, k;
+  unsigned int *handles, *stale;
+  unsigned char key[8], blk[8], ref[8];
+  des_ctx **ctx;
+  des_arena a;
+  unsigned long long mismatches = 0, refused = 0;
+  double t0, t_ctx_setup, t_arena_setup, t_ctx, t_arena;
+
+  while ((opt = getopt(argc, argv, "n:q:c:s:")) != -1) {
+    switch (opt) {
+    case 'n': sessions = strtoul(optarg, NULL, 0); break;
+    case 'q': requests = strtoul(optarg, NULL, 0); break;
+    case 'c': percent = atoi(optarg); break;
+    case 's': ar_state = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-n sessions] [-q requests] "
+                      "[-c churn_percent] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (sessions == 0 || sessions > DES_ARENA_MAXCAP) {
+    fprintf(stderr, "sessions must be 1..%u\n", DES_ARENA_MAXCAP);
+    return 2;
+  }
+  if (percent < 0 || percent > 100)
+    percent = 10;
+
+  /* des_ctx: three separately allocated contexts per session */
+  ctx = malloc(3 * sessions * sizeof(*ctx));
+  t0 = ar_now();
+  for (s=0; s<sessions; s++)
+    for (k=0; k<3; k++) {
+      ctx[3*s+k] = malloc(sizeof(des_ctx));
+      ar_key(s, k, key);
+      des_key(ctx[3*s+k], key);
+    }
+  t_ctx_setup = ar_now() - t0;
+
+  /* arena: one bulk allocation for all sessions */
+  handles = malloc(sessions * sizeof(*handles));
+  t0 = ar_now();
+  if (des_arena_init(&a, (unsigned int) sessions, 3) != 0 ||
+      des_arena_alloc(&a, handles, (unsigned int) sessions) != sessions) {
+    fprintf(stderr, "des_arena: out of memory\n");
+    return 1;
+  }
+  for (s=0; s<sessions; s++)
+    for (k=0; k<3; k++) {
+      ar_key(s, k, key);
+      des_arena_key(&a, handles[s], k, key);
+    }
+  t_arena_setup = ar_now() - t0;
+
+  /* random-session requests, same sequence for both layouts */
+  ar_state |= 1;
+  {
+    unsigned long long seed = ar_state;
+
+    t0 = ar_now();
+    for (i=0; i<requests; i++) {
+      s = ar_rand() % sessions;
+      ar_fill(blk);
+      des_enc(ctx[3*s], blk, 1);
+      des_enc(ctx[3*s+1], blk, 1);
+      des_enc(ctx[3*s+2], blk, 1);
+    }
+    t_ctx = ar_now() - t0;
+
+    ar_state = seed;
+    t0 = ar_now();
+    for (i=0; i<requests; i++) {
+      s = ar_rand() % sessions;
+      ar_fill(blk);
+      des_arena_enc3(&a, handles[s], blk, 1);
+    }
+    t_arena = ar_now() - t0;
+  }
+
+  /* correctness: a sample of requests through both, and back again */
+  for (i=0; i<requests / 64 + 1; i++) {
+    s = ar_rand() % sessions;
+    ar_fill(blk);
+    memcpy(ref, blk, 8);
+    des_enc(ctx[3*s], ref, 1);
+    des_enc(ctx[3*s+1], ref, 1);
+    des_enc(ctx[3*s+2], ref, 1);
+    des_arena_enc3(&a, handles[s], blk, 1);
+    if (memcmp(ref, blk, 8) != 0)
+      mismatches++;
+    des_dec(ctx[3*s+2], ref, 1);
+    des_dec(ctx[3*s+1], ref, 1);
+    des_dec(ctx[3*s], ref, 1);
+    des_arena_dec3(&a, handles[s], blk, 1);
+    if (memcmp(ref, blk, 8) != 0)
+      mismatches++;
+  }
+
+  /* churn: bulk-free a slice, re-allocate it, stale handles must fail */
+  churn = sessions * percent / 100;
+  stale = malloc((churn ? churn : 1) * sizeof(*stale));
+  memcpy(stale, handles, churn * sizeof(*stale));
+  des_arena_free(&a, handles, (unsigned int) churn);
+  if (des_arena_alloc(&a, handles, (unsigned int) churn) != churn) {
+    fprintf(stderr, "des_arena: re-allocation failed\n");
+    return 1;
+  }
+  for (s=0; s<churn; s++) {
+    for (k=0; k<3; k++) {
+      ar_key(s, k, key);
+      des_arena_key(&a, handles[s], k, key);
+    }
+    if (des_arena_enc3(&a, stale[s], blk, 1) != 0)
+      refused++;
+  }
+  for (s=0; s<churn; s++) {
+    ar_fill(blk);
+    memcpy(ref, blk, 8);
+    des_enc(ctx[3*s], ref, 1);
+    des_enc(ctx[3*s+1], ref, 1);
+    des_enc(ctx[3*s+2], ref, 1);
+    des_arena_enc3(&a, handles[s], blk, 1);
+    if (memcmp(ref, blk, 8) != 0)
+      mismatches++;
+  }
+
+  printf("%lu triple-DES sessions, %lu random requests\n", sessions,
+         requests);
+  printf("%-8s %10s %10s %14s\n", "layout", "B/session", "setup s",
+         "requests/s");
+  printf("%-8s %10zu %10.3f %14.0f\n", "des_ctx", 3 * sizeof(des_ctx),
+         t_ctx_setup, requests / t_ctx);
+  printf("%-8s %10zu %10.3f %14.0f\n", "arena",
+         3 * DES_ARENA_WORDS * sizeof(unsigned int), t_arena_setup,
+         requests / t_arena);
+  printf("arena schedules: %s\n", a.huge ? "huge pages (MADV_HUGEPAGE)" :
+         "base pages");
+  printf("churn: %lu sessions freed and re-allocated, %llu/%lu stale "
+         "handles refused\n", churn, refused, churn);
+  printf("mismatches=%llu\n", mismatches);
+
+  des_arena_destroy(&a);
+  for (i=0; i<3*sessions; i++)
+    free(ctx[i]);
+  free(ctx);
+  free(handles);
+  free(stale);
+  return mismatches || refused != churn ? 1 : 0;
+}
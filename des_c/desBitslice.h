@@ -0,0 +1,191 @@
+/* Multi-key bitsliced DES.  Blocks are spread across the bits of wide
+ * words, one block per lane.  The subkeys are sliced the same way, so
+ * every lane runs under its own schedule: its own key and also its own
+ * direction (a lane given dc->dk decrypts while its neighbours
+ * encrypt).  That lets one batch carry many small messages from
+ * different sessions, the way main() walks every triple of Key.txt.
+ *
+ * Three widths share one round function (desBitsliceW.h):
+ *
+ *   des_bs64_*    64 lanes, unsigned long long slices
+ *   des_bs256_*  256 lanes, 32-byte GCC vector slices (AVX2 with -mavx2)
+ *   des_bs512_*  512 lanes, 64-byte GCC vector slices (AVX-512 with
+ *                -mavx512f; otherwise lowered to narrower vectors)
+ *
+ * The S-boxes are not gate circuits.  bs_init() derives them from
+ * SP1..SP8, so the engine computes exactly what desfunc() does.  Each
+ * output bit of S-box n is evaluated as OR_j inner_j & F[tt[j]]:
+ *
+ *   inner_j  the 16 minterms of the middle input bits (b1..b4)
+ *   F[f]     all 16 functions of the outer bits (b0, b5); tt[j] picks
+ *            the one that output needs for column j
+ *
+ * The state is desfunc's rotated leftt/right pair.  IP and FP run per
+ * block in scalar code (desfunc's swap networks), and 64x64 bit
+ * transposes move blocks into and out of slices.
+ *
+ *   des_bsW_keys *ks = aligned to its slice size, e.g. posix_memalign
+ *   des_bsW_key(ks, scheds, n)      scheds[i] = dc_i->ek or dc_i->dk
+ *   des_bsW_rawkey(ks, keys, dec, n)
+ *                                   keys = n raw 8-byte keys, dec[i]
+ *                                   nonzero to decrypt lane i
+ *   des_bsW_crypt(ks, data, n)      data = n blocks, block i in lane i
+ *
+ * des_bsW_rawkey skips deskey() altogether: the key schedule is a fixed
+ * bit permutation, so once the raw keys are transposed every subkey
+ * slice is just a copy of one key slice (bs_keybit, found by bs_init
+ * from deskey itself).  A per-lane direction costs one select.
+ *
+ * Header-only (static); include after des.c.  Call bs_init() once
+ * before the first des_bsW_key.
+ */
+
+/* Output positions of S-box n in desfunc's fval word and, for each,
+   the 2-variable function of the outer input bits for each column. */
+static struct {
+  unsigned char pos[4];
+  unsigned char tt[4][16];
+} bs_sbox[8];
+
+/* Raw key bit (0 = LSB of the big-endian 64-bit key) feeding bit b of
+   cooked word 2r+w of the encrypt schedule, or -1 for unused bits. */
+static signed char bs_keybit[16][2][32];
+
+/* desfunc's SP table for S-box n+1 and where its 6 input bits sit in
+   the work word (k0 for odd S-boxes, k1 for even ones). */
+static unsigned long *const bs_sp[8] = {
+  SP1, SP2, SP3, SP4, SP5, SP6, SP7, SP8};
+static const unsigned char bs_base[8] = {24, 24, 16, 16, 8, 8, 0, 0};
+
+static void bs_init(void) {
+  unsigned long all, cooked[32];
+  unsigned char key[8];
+  unsigned int n, o, j, v, q;
+  int p, r, w, b;
+
+  for (n=0; n<8; n++) {
+    all = 0;
+    for (v=0; v<64; v++)
+      all |= bs_sp[n][v];
+    for (o=0, p=0; p<32; p++)
+      if ((all >> p) & 1)
+        bs_sbox[n].pos[o++] = (unsigned char) p;
+    for (o=0; o<4; o++)
+      for (j=0; j<16; j++) {
+        unsigned char f = 0;
+
+        for (q=0; q<4; q++) {
+          v = ((q >> 1) << 5) | (j << 1) | (q & 1);
+          if ((bs_sp[n][v] >> bs_sbox[n].pos[o]) & 1)
+            f |= (unsigned char) (1 << q);
+        }
+        bs_sbox[n].tt[o][j] = f;
+      }
+  }
+
+  /* the key schedule is a bit permutation: find each bit's source */
+  memset(bs_keybit, -1, sizeof(bs_keybit));
+  for (p=0; p<64; p++) {
+    memset(key, 0, sizeof(key));
+    key[7 - p/8] = (unsigned char) (1 << (p % 8));
+    deskey_r(key, EN0, cooked);
+    for (r=0; r<16; r++)
+      for (w=0; w<2; w++)
+        for (b=0; b<32; b++)
+          if ((cooked[2*r+w] >> b) & 1)
+            bs_keybit[r][w][b] = (signed char) p;
+  }
+}
+
+/* desfunc's initial permutation on one 8-byte block: leftt in the high
+   half, right in the low half, both in desfunc's rotated form. */
+static unsigned long long bs_ip(const unsigned char *in) {
+  unsigned long leftt, right, work;
+
+  leftt = ((unsigned long) in[0] << 24) | ((unsigned long) in[1] << 16) |
+          ((unsigned long) in[2] << 8) | in[3];
+  right = ((unsigned long) in[4] << 24) | ((unsigned long) in[5] << 16) |
+          ((unsigned long) in[6] << 8) | in[7];
+  work = ((leftt>>4) ^ right) & 0x0f0f0f0fL;
+  right ^= work;
+  leftt ^= (work<<4);
+  work = ((leftt>>16) ^ right) & 0x0000ffffL;
+  right ^= work;
+  leftt ^= (work<<16);
+  work = ((right>>2) ^ leftt) & 0x33333333L;
+  leftt ^= work;
+  right ^= (work<<2);
+  work = ((right>>8) ^ leftt) & 0x00ff00ffL;
+  leftt ^= work;
+  right ^= (work<<8);
+  right = ((right<<1) | ((right>>31) & 1L)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  leftt = ((leftt<<1) | ((leftt>>31) & 1L)) & 0xffffffffL;
+  return ((unsigned long long) leftt << 32) | right;
+}
+
+/* desfunc's final permutation back into an 8-byte block. */
+static void bs_fp(unsigned long long lr, unsigned char *out) {
+  unsigned long leftt = (unsigned long) (lr >> 32), work;
+  unsigned long right = (unsigned long) lr & 0xffffffffL;
+
+  right = ((right<<31) | (right>>1)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  leftt = ((leftt<<31) | (leftt>>1)) & 0xffffffffL;
+  work = ((leftt>>8) ^ right) & 0x00ff00ffL;
+  right ^= work;
+  leftt ^= (work<<8);
+  work = ((leftt>>2) ^ right) & 0x33333333L;
+  right ^= work;
+  leftt ^= (work<<2);
+  work = ((right>>16) ^ leftt) & 0x0000ffffL;
+  leftt ^= work;
+  right ^= (work<<16);
+  work = ((right>>4) ^ leftt) & 0x0f0f0f0fL;
+  leftt ^= work;
+  right ^= (work<<4);
+  out[0] = (unsigned char) (right >> 24);
+  out[1] = (unsigned char) (right >> 16);
+  out[2] = (unsigned char) (right >> 8);
+  out[3] = (unsigned char) right;
+  out[4] = (unsigned char) (leftt >> 24);
+  out[5] = (unsigned char) (leftt >> 16);
+  out[6] = (unsigned char) (leftt >> 8);
+  out[7] = (unsigned char) leftt;
+}
+
+/* In-place 64x64 bit transpose: afterwards bit i of x[b] is what bit b
+   of x[i] was.  Its own inverse. */
+static void bs_transpose64(unsigned long long *x) {
+  unsigned long long m = 0x00000000ffffffffULL, t;
+  int j, k;
+
+  for (j=32; j; j>>=1, m ^= m << j)
+    for (k=0; k<64; k=(k+j+1) & ~j) {
+      t = ((x[k] >> j) ^ x[k+j]) & m;
+      x[k+j] ^= t;
+      x[k] ^= t << j;
+    }
+}
+
+typedef unsigned long long bs256_t __attribute__((vector_size(32)));
+typedef unsigned long long bs512_t __attribute__((vector_size(64)));
+
+#define BS_T      unsigned long long
+#define BS_WORDS  1
+#define BS_NAME(x) des_bs64_##x
+#include "desBitsliceW.h"
+
+#define BS_T      bs256_t
+#define BS_WORDS  4
+#define BS_NAME(x) des_bs256_##x
+#include "desBitsliceW.h"
+
+#define BS_T      bs512_t
+#define BS_WORDS  8
+#define BS_NAME(x) des_bs512_##x
+#include "desBitsliceW.h"
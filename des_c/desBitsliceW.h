@@ -0,0 +1,153 @@
+/* One width of the multi-key bitsliced engine; included by desBitslice.h
+ * with BS_T (slice type: lanes = 64 * BS_WORDS bits), BS_WORDS and
+ * BS_NAME(x) (function name prefix) defined.  Not for direct use.
+ */
+
+/* Sliced schedule: k[r][w][b] holds bit b of cooked word 2r+w for all
+   lanes; bits outside the S-box fields stay zero. */
+typedef struct {
+  BS_T k[16][2][32];
+} BS_NAME(keys);
+
+/* Bit g*64+i of a slice, as an addressable 64-bit word (lane group g). */
+#define BS_GROUP(s, g) (((unsigned long long *) &(s))[g])
+
+static void BS_NAME(key)(BS_NAME(keys) *ks, unsigned long *const *sched,
+                         int n) {
+  unsigned long long x[64];
+  int g, r, i, b, lane;
+
+  for (g=0; g<BS_WORDS; g++)
+    for (r=0; r<16; r++) {
+      for (i=0; i<64; i++) {
+        lane = 64*g + i;
+        x[i] = lane < n ? ((unsigned long long) sched[lane][2*r] << 32) |
+                          (sched[lane][2*r+1] & 0xffffffffUL) : 0;
+      }
+      bs_transpose64(x);
+      for (b=0; b<32; b++) {
+        BS_GROUP(ks->k[r][0][b], g) = x[32+b];
+        BS_GROUP(ks->k[r][1][b], g) = x[b];
+      }
+    }
+}
+
+static void BS_NAME(rawkey)(BS_NAME(keys) *ks, const unsigned char *keys,
+                            const int *dec, int n) {
+  BS_T K[64], D, zero = {0};
+  unsigned long long x[64], d;
+  int g, i, j, r, w, b, lane, e, v;
+
+  for (g=0; g<BS_WORDS; g++) {
+    d = 0;
+    for (i=0; i<64; i++) {
+      lane = 64*g + i;
+      x[i] = 0;
+      if (lane < n) {
+        for (j=0; j<8; j++)
+          x[i] = (x[i] << 8) | keys[8*lane + j];
+        if (dec && dec[lane])
+          d |= 1ULL << i;
+      }
+    }
+    bs_transpose64(x);
+    for (b=0; b<64; b++)
+      BS_GROUP(K[b], g) = x[b];
+    BS_GROUP(D, g) = d;
+  }
+  /* decrypt lanes read round r's subkey from encrypt round 15-r */
+  for (r=0; r<16; r++)
+    for (w=0; w<2; w++)
+      for (b=0; b<32; b++) {
+        e = bs_keybit[r][w][b];
+        v = bs_keybit[15-r][w][b];
+        ks->k[r][w][b] = e < 0 ? zero : (K[e] & ~D) | (K[v] & D);
+      }
+}
+
+/* One S-box over all lanes: in[t] is input bit t of the SP index,
+   l[pos] ^= each of its four output bits. */
+static inline void BS_NAME(sbox)(BS_T *l, const BS_T *in, int n) {
+  BS_T m[4], F[16], lo[4], hi[4], p[16], acc, zero = {0};
+  int f, j, o;
+
+  m[0] = ~in[5] & ~in[0];
+  m[1] = ~in[5] & in[0];
+  m[2] = in[5] & ~in[0];
+  m[3] = in[5] & in[0];
+  F[0] = zero;
+  for (f=1; f<16; f++)
+    F[f] = F[f & (f-1)] | m[__builtin_ctz(f)];
+  lo[0] = ~in[1] & ~in[2];
+  lo[1] = in[1] & ~in[2];
+  lo[2] = ~in[1] & in[2];
+  lo[3] = in[1] & in[2];
+  hi[0] = ~in[3] & ~in[4];
+  hi[1] = in[3] & ~in[4];
+  hi[2] = ~in[3] & in[4];
+  hi[3] = in[3] & in[4];
+  for (j=0; j<16; j++)
+    p[j] = lo[j & 3] & hi[j >> 2];
+  for (o=0; o<4; o++) {
+    acc = zero;
+    for (j=0; j<16; j++)
+      acc |= p[j] & F[bs_sbox[n].tt[o][j]];
+    l[bs_sbox[n].pos[o]] ^= acc;
+  }
+}
+
+/* l ^= f(r, K): one desfunc half-round on every lane. */
+static void BS_NAME(round)(BS_T *l, const BS_T *r, BS_T (*k)[32]) {
+  BS_T in[6];
+  int n, t, b, w;
+
+  for (n=0; n<8; n++) {
+    w = n & 1;                    /* SP2/4/6/8 read right ^ k1 */
+    for (t=0; t<6; t++) {
+      b = bs_base[n] + t;
+      in[t] = r[w ? b : (b + 4) & 31] ^ k[w][b];
+    }
+    BS_NAME(sbox)(l, in, n);
+  }
+}
+
+static void BS_NAME(crypt)(BS_NAME(keys) *ks, unsigned char *data, int n) {
+  unsigned long long x[64];
+  BS_T L[32], R[32];
+  int g, i, b, r, lane;
+
+  for (g=0; g<BS_WORDS; g++) {
+    for (i=0; i<64; i++) {
+      lane = 64*g + i;
+      x[i] = lane < n ? bs_ip(data + 8*lane) : 0;
+    }
+    bs_transpose64(x);
+    for (b=0; b<32; b++) {
+      BS_GROUP(L[b], g) = x[32+b];
+      BS_GROUP(R[b], g) = x[b];
+    }
+  }
+
+  for (r=0; r<16; r+=2) {
+    BS_NAME(round)(L, R, ks->k[r]);
+    BS_NAME(round)(R, L, ks->k[r+1]);
+  }
+
+  for (g=0; g<BS_WORDS; g++) {
+    for (b=0; b<32; b++) {
+      x[32+b] = BS_GROUP(L[b], g);
+      x[b] = BS_GROUP(R[b], g);
+    }
+    bs_transpose64(x);
+    for (i=0; i<64; i++) {
+      lane = 64*g + i;
+      if (lane < n)
+        bs_fp(x[i], data + 8*lane);
+    }
+  }
+}
+
+#undef BS_GROUP
+#undef BS_T
+#undef BS_WORDS
+#undef BS_NAME
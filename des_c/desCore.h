@@ -0,0 +1,219 @@
+/* Cycle-accurate model of des_vhdl/des_cipher_top.vhd.
+ *
+ * One core_clock() call is one rising edge of `clock`.  The model keeps
+ * exactly the registers of the RTL and updates them all from their
+ * values before the edge:
+ *
+ *   des_cipher_top  data_in_internal, data_ready_internal (lddata delayed)
+ *   key_schedule    K1..K16, key_ready (K held while reset is high)
+ *   des_top         nextstate, RoundCounter, KeySelect, L_in/R_in,
+ *                   data_out, core_busy, des_out_rdy
+ *
+ * block_top is combinational; it is evaluated with the SP tables from
+ * des.c instead of bit by bit, which is what keeps the model at millions
+ * of blocks per second.  Registers the RTL leaves uninitialised ('U')
+ * start at zero.
+ *
+ * 64-bit buses use VHDL bit 0 as the most significant bit, so
+ * X"0123456789abcdef" on key_in or data_in is 0x0123456789abcdefULL.
+ *
+ * Header-only (static); include after des.c.
+ */
+
+#include <stdint.h>
+
+enum core_state { WaitKey, WaitData, InitialRound, RepeatRound, FinalRound };
+
+typedef struct {
+  /* inputs, sampled at the next rising edge */
+  uint64_t key_in;
+  uint64_t data_in;
+  int function_select;         /* 1 = encrypt, 0 = decrypt */
+  int lddata;
+  int reset;
+
+  /* outputs (registered) */
+  uint64_t data_out;
+  int core_busy;
+  int des_out_rdy;
+
+  /* des_cipher_top */
+  uint64_t data_in_internal;
+  int data_ready_internal;
+
+  /* key_schedule: K1..K16 as cooked pairs, ks[2*i], ks[2*i+1] = K(i+1) */
+  unsigned long ks[32];
+  uint64_t ks_key;             /* key_in the K registers were loaded from */
+  int ks_valid;
+  int key_ready;
+
+  /* des_top */
+  enum core_state state;
+  unsigned int round_counter;  /* 4 bits */
+  unsigned int key_select;     /* 4 bits */
+  uint32_t l_in, r_in;
+
+  unsigned long long cycle;
+} des_core;
+
+static void core_init(des_core *c) {
+  memset(c, 0, sizeof(*c));
+  c->state = WaitKey;
+}
+
+/* desfunc's IP swap network, on a big-endian 64-bit bus value. */
+static void core_ip(uint64_t in, uint32_t *l, uint32_t *r) {
+  unsigned long leftt = (unsigned long) (in >> 32) & 0xffffffffL;
+  unsigned long right = (unsigned long) in & 0xffffffffL;
+  unsigned long work;
+
+  work = ((leftt>>4) ^ right) & 0x0f0f0f0fL;
+  right ^= work;
+  leftt ^= (work<<4);
+  work = ((leftt>>16) ^ right) & 0x0000ffffL;
+  right ^= work;
+  leftt ^= (work<<16);
+  work = ((right>>2) ^ leftt) & 0x33333333L;
+  leftt ^= work;
+  right ^= (work<<2);
+  work = ((right>>8) ^ leftt) & 0x00ff00ffL;
+  leftt ^= work;
+  right ^= (work<<8);
+  right = ((right<<1) | ((right>>31) & 1L)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  /* desfunc would now rotate leftt left by one; undo right's instead */
+  *l = (uint32_t) leftt;
+  *r = (uint32_t) (((right>>1) | (right<<31)) & 0xffffffffL);
+}
+
+/* Inverse IP applied to R16 || L16, as des_top's FinalRound assignment
+   does with R_out/L_out. */
+static uint64_t core_fp(uint32_t l16, uint32_t r16) {
+  unsigned long leftt, right = r16, work;
+
+  /* desfunc's FP, entered after its rotate-right of `right` */
+  leftt = ((l16 << 1) | (l16 >> 31)) & 0xffffffffL;
+  work = (leftt ^ right) & 0xaaaaaaaaL;
+  leftt ^= work;
+  right ^= work;
+  leftt = ((leftt<<31) | (leftt>>1)) & 0xffffffffL;
+  work = ((leftt>>8) ^ right) & 0x00ff00ffL;
+  right ^= work;
+  leftt ^= (work<<8);
+  work = ((leftt>>2) ^ right) & 0x33333333L;
+  right ^= work;
+  leftt ^= (work<<2);
+  work = ((right>>16) ^ leftt) & 0x0000ffffL;
+  leftt ^= work;
+  right ^= (work<<16);
+  work = ((right>>4) ^ leftt) & 0x0f0f0f0fL;
+  leftt ^= work;
+  right ^= (work<<4);
+  return ((uint64_t) (right & 0xffffffffL) << 32) | (leftt & 0xffffffffL);
+}
+
+/* block_top's f(R, K) = P(S(E(R) xor K)) for one cooked key pair. */
+static uint32_t core_f(uint32_t r, const unsigned long *k) {
+  unsigned long rr, work, fval;
+
+  rr = ((r << 1) | (r >> 31)) & 0xffffffffL;
+  work = ((rr << 28) | (rr >> 4)) ^ k[0];
+  fval  = SP7[work       & 0x3fL];
+  fval |= SP5[(work>> 8) & 0x3fL];
+  fval |= SP3[(work>>16) & 0x3fL];
+  fval |= SP1[(work>>24) & 0x3fL];
+  work  = rr ^ k[1];
+  fval |= SP8[work       & 0x3fL];
+  fval |= SP6[(work>> 8) & 0x3fL];
+  fval |= SP4[(work>>16) & 0x3fL];
+  fval |= SP2[(work>>24) & 0x3fL];
+  return (uint32_t) (((fval >> 1) | (fval << 31)) & 0xffffffffL);
+}
+
+/* K1..K16 for key, in the cooked form desfunc uses (deskey EN0). */
+static void core_expand(uint64_t key, unsigned long *ks) {
+  unsigned char kb[8];
+  int i;
+
+  for (i=0; i<8; i++)
+    kb[i] = (unsigned char) (key >> (56 - 8*i));
+  deskey(kb, EN0);
+  cpkey(ks);
+}
+
+static void core_clock(des_core *c) {
+  /* combinational paths, from the pre-edge register values */
+  const unsigned long *kout = &c->ks[2 * c->key_select];
+  uint32_t l_out = c->r_in;
+  uint32_t r_out = c->l_in ^ core_f(c->r_in, kout);
+  int data_ready = c->data_ready_internal;
+  int key_ready = c->key_ready;
+  unsigned int step = c->function_select ? 1 : 15;   /* +1 / -1 mod 16 */
+
+  /* des_cipher_top input register */
+  if (c->lddata)
+    c->data_in_internal = c->data_in;
+  c->data_ready_internal = c->lddata ? 1 : 0;
+
+  /* key_schedule */
+  if (c->reset) {
+    c->key_ready = 0;
+  } else {
+    if (!c->ks_valid || c->ks_key != c->key_in) {
+      core_expand(c->key_in, c->ks);
+      c->ks_key = c->key_in;
+      c->ks_valid = 1;
+    }
+    c->key_ready = 1;
+  }
+
+  /* des_top FSM */
+  if (c->reset) {
+    c->state = WaitKey;
+    c->round_counter = 0;
+    c->core_busy = 0;
+    c->des_out_rdy = 0;
+  } else {
+    switch (c->state) {
+    case WaitKey:
+      c->state = key_ready ? WaitData : WaitKey;
+      c->core_busy = 0;
+      c->des_out_rdy = 0;
+      break;
+    case WaitData:
+      if (data_ready) {
+        c->core_busy = 1;
+        core_ip(c->data_in_internal, &c->l_in, &c->r_in);
+        c->state = InitialRound;
+        c->key_select = c->function_select ? 0 : 15;
+      }
+      break;
+    case InitialRound:
+      c->l_in = l_out;
+      c->r_in = r_out;
+      c->key_select = (c->key_select + step) & 0xf;
+      c->state = RepeatRound;
+      break;
+    case RepeatRound:
+      c->l_in = l_out;
+      c->r_in = r_out;
+      c->key_select = (c->key_select + step) & 0xf;
+      if (c->round_counter == 0xe) {
+        c->data_out = core_fp(l_out, r_out);
+        c->core_busy = 0;
+        c->des_out_rdy = 1;
+        c->state = FinalRound;
+      }
+      c->round_counter = (c->round_counter + 1) & 0xf;
+      break;
+    case FinalRound:
+      c->round_counter = 0;
+      c->state = WaitKey;
+      c->des_out_rdy = 0;
+      break;
+    }
+  }
+  c->cycle++;
+}
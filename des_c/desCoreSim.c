@@ -0,0 +1,239 @@
+/* Vector runner for the cycle-accurate des_cipher_top model (desCore.h).
+ * Every block the model produces is checked against des_enc/des_dec.
+ *
+ *   gcc -O2 -pthread desCoreSim.c -o desCoreSim
+ *   ./desCoreSim [-P tb|stream|pulse] [-n vectors] [-r rekey_every]
+ *                [-D delay] [-s seed] [-v]
+ *
+ *   -P tb      the des_cipher_top_tb.vhd protocol: every DES operation
+ *              is reset, key_in/data_in/lddata, wait for des_out_rdy;
+ *              each vector is triple-encrypted (KEY1, KEY2, KEY3) and
+ *              triple-decrypted again with the tb's 5-cycle gaps
+ *   -P stream  lddata held high, next data_in presented as soon as
+ *              des_out_rdy is seen; reset only to change the key
+ *   -P pulse   like stream, but lddata is a one-cycle strobe issued D
+ *              cycles after des_out_rdy; a strobe the core misses is
+ *              counted as lost and re-issued
+ *   -n  vectors (default 1000000)
+ *   -r  in stream/pulse mode, new random key every N blocks (default 0:
+ *       one key for the whole run)
+ *   -D  strobe delay for -P pulse (default 0)
+ *   -v  print every DES operation
+ *
+ * Reported: blocks, clock cycles, cycles per block, cycles the core was
+ * busy, and simulation speed.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include "desCore.h"
+#include <unistd.h>
+#include <time.h>
+
+#define SIM_TIMEOUT 64          /* cycles without des_out_rdy = lost */
+
+static unsigned long long sim_state = 0x9e3779b97f4a7c15ULL;
+static unsigned long long busy_cycles, mismatches, lost;
+static int verbose;
+
+static unsigned long long sim_rand(void) {
+  sim_state ^= sim_state << 13;
+  sim_state ^= sim_state >> 7;
+  sim_state ^= sim_state << 17;
+  return sim_state;
+}
+
+static void sim_clock(des_core *c) {
+  core_clock(c);
+  busy_cycles += c->core_busy;
+}
+
+/* The tb protocol uses each key twice (encrypt, then decrypt), so a few
+   cached schedules keep key setup off the checker's critical path. */
+#define SW_KEYS 4
+
+static uint64_t sw_des(uint64_t key, uint64_t data, int encrypt) {
+  static des_ctx dc[SW_KEYS];
+  static uint64_t dkey[SW_KEYS];
+  static int dvalid[SW_KEYS], next;
+  unsigned char kb[8], db[8];
+  uint64_t out = 0;
+  int i, k;
+
+  for (k=0; k<SW_KEYS; k++)
+    if (dvalid[k] && dkey[k] == key)
+      break;
+  if (k == SW_KEYS) {
+    k = next;
+    next = (next + 1) % SW_KEYS;
+    for (i=0; i<8; i++)
+      kb[i] = (unsigned char) (key >> (56 - 8*i));
+    des_key(&dc[k], kb);
+    dkey[k] = key;
+    dvalid[k] = 1;
+  }
+  for (i=0; i<8; i++)
+    db[i] = (unsigned char) (data >> (56 - 8*i));
+  if (encrypt)
+    des_enc(&dc[k], db, 1);
+  else
+    des_dec(&dc[k], db, 1);
+  for (i=0; i<8; i++)
+    out = (out << 8) | db[i];
+  return out;
+}
+
+static void sim_check(uint64_t key, uint64_t in, uint64_t got, int encrypt) {
+  uint64_t want = sw_des(key, in, encrypt);
+
+  if (verbose)
+    printf("%s key=%016llx in=%016llx out=%016llx%s\n", encrypt ? "enc" : "dec",
+           (unsigned long long) key, (unsigned long long) in,
+           (unsigned long long) got, got == want ? "" : "  MISMATCH");
+  if (got != want) {
+    if (mismatches < 10)
+      fprintf(stderr, "mismatch: %s key=%016llx in=%016llx hw=%016llx "
+              "sw=%016llx\n", encrypt ? "enc" : "dec",
+              (unsigned long long) key, (unsigned long long) in,
+              (unsigned long long) got, (unsigned long long) want);
+    mismatches++;
+  }
+}
+
+/* One DES operation the way des_cipher_top_tb.vhd drives it. */
+static uint64_t tb_op(des_core *c, uint64_t key, uint64_t data, int encrypt,
+                      int gap) {
+  int i;
+
+  for (i=0; i<gap; i++)
+    sim_clock(c);
+  c->reset = 1;
+  sim_clock(c);
+  c->reset = 0;
+  c->key_in = key;
+  c->function_select = encrypt;
+  c->data_in = data;
+  c->lddata = 1;
+  for (i=0; !c->des_out_rdy; i++) {
+    if (i == SIM_TIMEOUT) {
+      lost++;
+      break;
+    }
+    sim_clock(c);
+  }
+  sim_check(key, data, c->data_out, encrypt);
+  return c->data_out;
+}
+
+static long run_tb(des_core *c, long vectors) {
+  uint64_t k1, k2, k3, d, o1, o2, o3;
+  long v;
+
+  for (v=0; v<vectors; v++) {
+    k1 = sim_rand();
+    k2 = sim_rand();
+    k3 = sim_rand();
+    d = sim_rand();
+    o1 = tb_op(c, k1, d, 1, 0);
+    o2 = tb_op(c, k2, o1, 1, 0);
+    o3 = tb_op(c, k3, o2, 1, 0);
+    o2 = tb_op(c, k3, o3, 0, 5);
+    o1 = tb_op(c, k2, o2, 0, 5);
+    tb_op(c, k1, o1, 0, 5);
+  }
+  return 6 * vectors;
+}
+
+static long run_stream(des_core *c, long vectors, long rekey, int pulse,
+                       int delay) {
+  uint64_t key = sim_rand(), data;
+  long v;
+  int i, wait;
+
+  c->reset = 1;
+  sim_clock(c);
+  c->reset = 0;
+  c->key_in = key;
+  c->function_select = 1;
+  c->lddata = !pulse;
+
+  for (v=0; v<vectors; v++) {
+    if (rekey && v && v % rekey == 0) {
+      key = sim_rand();
+      c->key_in = key;
+      c->reset = 1;
+      sim_clock(c);
+      c->reset = 0;
+    }
+    data = sim_rand();
+    c->data_in = data;
+    for (;;) {
+      if (pulse) {
+        for (i=0; i<delay; i++)
+          sim_clock(c);
+        c->lddata = 1;
+        sim_clock(c);
+        c->lddata = 0;
+      }
+      for (wait=0; !c->des_out_rdy && wait<SIM_TIMEOUT; wait++)
+        sim_clock(c);
+      if (c->des_out_rdy)
+        break;
+      lost++;
+      if (!pulse)
+        break;
+    }
+    sim_check(key, data, c->data_out, 1);
+    /* des_out_rdy is a one-cycle pulse; step past it */
+    sim_clock(c);
+  }
+  return vectors;
+}
+
+int main(int argc, char **argv) {
+  const char *proto = "tb";
+  long vectors = 1000000, rekey = 0, blocks;
+  int delay = 0, opt;
+  des_core c;
+  struct timespec t0, t1;
+  double sec;
+
+  while ((opt = getopt(argc, argv, "P:n:r:D:s:v")) != -1) {
+    switch (opt) {
+    case 'P': proto = optarg; break;
+    case 'n': vectors = atol(optarg); break;
+    case 'r': rekey = atol(optarg); break;
+    case 'D': delay = atoi(optarg); break;
+    case 's': sim_state = strtoull(optarg, NULL, 0) | 1; break;
+    case 'v': verbose = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-P tb|stream|pulse] [-n vectors] "
+                      "[-r rekey_every] [-D delay] [-s seed] [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  core_init(&c);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (strcmp(proto, "tb") == 0)
+    blocks = run_tb(&c, vectors);
+  else if (strcmp(proto, "stream") == 0)
+    blocks = run_stream(&c, vectors, rekey, 0, 0);
+  else if (strcmp(proto, "pulse") == 0)
+    blocks = run_stream(&c, vectors, rekey, 1, delay);
+  else {
+    fprintf(stderr, "unknown protocol %s\n", proto);
+    return 2;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+  printf("protocol=%s blocks=%ld cycles=%llu cycles/block=%.2f "
+         "busy=%.1f%% blocks/cycle=%.4f\n", proto, blocks, c.cycle,
+         (double) c.cycle / blocks, 100.0 * busy_cycles / c.cycle,
+         (double) blocks / c.cycle);
+  printf("lost handshakes=%llu mismatches=%llu  (%.2f M blocks/s simulated)\n",
+         lost, mismatches, blocks / sec / 1e6);
+  /* a missed strobe is an interface finding in pulse mode, not a failure */
+  return mismatches || (lost && strcmp(proto, "pulse") != 0) ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/* Synthetic corpus generator for the file pipeline.  Writes inputs in
+ * the same formats main() in des.c reads, only much larger:
+ *
+ *   <prefix>Key.txt           3 lines per key triple, 8 characters each
+ *   <prefix>Plaintextin.txt   one 8-letter record per line
+ *   <prefix>Plaintextin.bin   the same records as raw 8-byte blocks (-b)
+ *   <prefix>Ciphertextin.txt  16 hex digits per line: the plaintext
+ *                             records triple-encrypted (k1, k2, k3, as in
+ *                             main()) under the first key triple
+ *
+ *   gcc -O2 -pthread desCorpus.c -o desCorpus
+ *   ./desCorpus [-r records] [-k triples] [-b] [-s seed] [-p prefix]
+ *
+ *   -r  plaintext/ciphertext records (default 1000000)
+ *   -k  key triples (default 1000)
+ *   -b  also write the binary plaintext file
+ *   -s  PRNG seed
+ *   -p  output path prefix, e.g. "corpus/" (default "big")
+ *
+ * Records are drawn from a small syllable grammar so the text looks like
+ * the word lists in Plaintextin.txt and Key.txt rather than noise.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+
+static unsigned long long cg_state = 0x853c49e6748fea9bULL;
+
+static unsigned long long cg_rand(void) {
+  cg_state ^= cg_state << 13;
+  cg_state ^= cg_state >> 7;
+  cg_state ^= cg_state << 17;
+  return cg_state;
+}
+
+static const char *cg_onset[] = {
+  "b", "bl", "br", "c", "ch", "cr", "d", "dr", "f", "fl", "g", "gr", "h",
+  "j", "k", "l", "m", "n", "p", "pl", "qu", "r", "s", "sk", "sl", "st",
+  "t", "tr", "v", "w", "z"};
+static const char *cg_vowel[] = {
+  "a", "e", "i", "o", "u", "ai", "ea", "ee", "io", "ou", "y"};
+static const char *cg_coda[] = {
+  "", "ck", "ff", "ll", "n", "nd", "ng", "r", "rd", "s", "ss", "t", "zz"};
+
+#define CG_COUNT(a) ((int) (sizeof(a) / sizeof((a)[0])))
+
+/* Exactly eight lowercase letters. */
+static void cg_word(char *w) {
+  char buf[32];
+  int n = 0;
+  const char *p;
+
+  while (n < 8) {
+    p = cg_onset[cg_rand() % CG_COUNT(cg_onset)];
+    while (*p) buf[n++] = *p++;
+    p = cg_vowel[cg_rand() % CG_COUNT(cg_vowel)];
+    while (*p) buf[n++] = *p++;
+    p = cg_coda[cg_rand() % CG_COUNT(cg_coda)];
+    while (*p) buf[n++] = *p++;
+  }
+  memcpy(w, buf, 8);
+}
+
+static FILE *cg_open(const char *prefix, const char *name, const char *mode) {
+  char path[1024];
+  FILE *fp;
+
+  snprintf(path, sizeof(path), "%s%s", prefix, name);
+  if ((fp = fopen(path, mode)) == NULL) {
+    perror(path);
+    exit(1);
+  }
+  setvbuf(fp, NULL, _IOFBF, 1 << 20);
+  return fp;
+}
+
+int main(int argc, char **argv) {
+  long records = 1000000, triples = 1000, i;
+  int binary = 0, opt, j, p;
+  const char *prefix = "big";
+  static const char hex[] = "0123456789abcdef";
+  char word[8], line[17];
+  unsigned char first[24], block[8];
+  des_ctx dc[3];
+  FILE *fk, *fp, *fb = NULL, *fc;
+
+  while ((opt = getopt(argc, argv, "r:k:bs:p:")) != -1) {
+    switch (opt) {
+    case 'r': records = atol(optarg); break;
+    case 'k': triples = atol(optarg); break;
+    case 'b': binary = 1; break;
+    case 's': cg_state = strtoull(optarg, NULL, 0) | 1; break;
+    case 'p': prefix = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-r records] [-k triples] [-b] [-s seed] "
+                      "[-p prefix]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (triples < 1)
+    triples = 1;
+
+  fk = cg_open(prefix, "Key.txt", "w");
+  for (i=0; i<triples; i++)
+    for (p=0; p<3; p++) {
+      cg_word(word);
+      if (i == 0)
+        memcpy(first + 8*p, word, 8);
+      fprintf(fk, "%.8s\n", word);
+    }
+  fclose(fk);
+
+  for (p=0; p<3; p++)
+    des_key(&dc[p], first + 8*p);
+
+  fp = cg_open(prefix, "Plaintextin.txt", "w");
+  fc = cg_open(prefix, "Ciphertextin.txt", "w");
+  if (binary)
+    fb = cg_open(prefix, "Plaintextin.bin", "wb");
+  line[16] = '\n';
+  for (i=0; i<records; i++) {
+    cg_word(word);
+    fprintf(fp, "%.8s\n", word);
+    if (fb)
+      fwrite(word, 1, 8, fb);
+    memcpy(block, word, 8);
+    for (p=0; p<3; p++)
+      des_enc(&dc[p], block, 1);
+    for (j=0; j<8; j++) {
+      line[2*j]   = hex[block[j] >> 4];
+      line[2*j+1] = hex[block[j] & 0xf];
+    }
+    fwrite(line, 1, 17, fc);
+  }
+  fclose(fp);
+  fclose(fc);
+  if (fb)
+    fclose(fb);
+
+  fprintf(stderr, "%ld key triples, %ld records -> %s{Key,Plaintextin,"
+                  "Ciphertextin}.txt%s\n", triples, records, prefix,
+          binary ? " + Plaintextin.bin" : "");
+  return 0;
+}
@@ -0,0 +1,617 @@
+/* Table generator: every DES constant table the C engines and the VHDL
+ * core use, derived from the definitions in FIPS 46-3 (IP is not needed;
+ * E, P, PC-1, PC-2, the shift schedule and S1..S8 are below, 1-based as
+ * printed in the Standard).
+ *
+ *   gcc -O2 -pthread desGen.c -o desGen
+ *   ./desGen -l layout [-o file]     C tables for one engine layout
+ *   ./desGen -k name=KEY[,KEY2,KEY3] [-k ...] [-o file]
+ *                                    fixed-key engines for desUnroll.h
+ *   ./desGen -V dir                  VHDL key_schedule.vhd, s1..s8_box.vhd
+ *   ./desGen -c                      check the tables in des.h/des.c
+ *
+ * Layouts (all emitted as static const arrays, so the same header works
+ * from C and as constant-initialised tables from C++):
+ *
+ *   key       pc1, totrot, pc2, bytebit, bigbyte as used by deskey()
+ *   sp        SP1..SP8[64]: S-box, P and desfunc's one-bit rotation
+ *             merged, indexed by the 6-bit field of the cooked key word
+ *   merged    SP13, SP57, SP24, SP68[4096]: two SP tables per lookup,
+ *             index (first field << 6) | second field
+ *   compact   SBOX[8][64] 4-bit outputs indexed by the raw 6-bit input
+ *             (row = b1 b6), as s1_box.vhd .. s8_box.vhd, and PBOX[32]
+ *   bitslice  SBOX_TT[8][4]: truth table of each S-box output bit (bit
+ *             v of word j is output bit j, MSB first, of S(v)), the
+ *             input to a gate-level bitsliced S-box
+ *   all       every layout above
+ *
+ * -k bakes keys known at build time into the output: deskey() runs here,
+ * each cooked schedule is emitted as a static const array, and
+ * desUnroll.h's DU_DEFINE_FIXED specialises an encrypt and a decrypt
+ * engine on it, so the subkeys become immediates and there is no key
+ * setup at run time.  KEY is 16 hex digits or 8 literal characters (as
+ * in Key.txt); three keys give an EEE engine, like main() in des.c.
+ *
+ * -c recomputes the key and sp layouts and compares them with the live
+ * tables in des.h/des.c; run it after touching either.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+#include <ctype.h>
+#include <sys/stat.h>
+
+static const unsigned char std_e[48] = {
+  32,  1,  2,  3,  4,  5,  4,  5,  6,  7,  8,  9,
+   8,  9, 10, 11, 12, 13, 12, 13, 14, 15, 16, 17,
+  16, 17, 18, 19, 20, 21, 20, 21, 22, 23, 24, 25,
+  24, 25, 26, 27, 28, 29, 28, 29, 30, 31, 32,  1};
+
+static const unsigned char std_p[32] = {
+  16,  7, 20, 21, 29, 12, 28, 17,  1, 15, 23, 26,  5, 18, 31, 10,
+   2,  8, 24, 14, 32, 27,  3,  9, 19, 13, 30,  6, 22, 11,  4, 25};
+
+static const unsigned char std_pc1[56] = {
+  57, 49, 41, 33, 25, 17,  9,  1, 58, 50, 42, 34, 26, 18,
+  10,  2, 59, 51, 43, 35, 27, 19, 11,  3, 60, 52, 44, 36,
+  63, 55, 47, 39, 31, 23, 15,  7, 62, 54, 46, 38, 30, 22,
+  14,  6, 61, 53, 45, 37, 29, 21, 13,  5, 28, 20, 12,  4};
+
+static const unsigned char std_pc2[48] = {
+  14, 17, 11, 24,  1,  5,  3, 28, 15,  6, 21, 10,
+  23, 19, 12,  4, 26,  8, 16,  7, 27, 20, 13,  2,
+  41, 52, 31, 37, 47, 55, 30, 40, 51, 45, 33, 48,
+  44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32};
+
+static const unsigned char std_shifts[16] = {
+  1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1};
+
+/* S1..S8, four rows of sixteen columns each */
+static const unsigned char std_s[8][64] = {
+  {14,  4, 13,  1,  2, 15, 11,  8,  3, 10,  6, 12,  5,  9,  0,  7,
+    0, 15,  7,  4, 14,  2, 13,  1, 10,  6, 12, 11,  9,  5,  3,  8,
+    4,  1, 14,  8, 13,  6,  2, 11, 15, 12,  9,  7,  3, 10,  5,  0,
+   15, 12,  8,  2,  4,  9,  1,  7,  5, 11,  3, 14, 10,  0,  6, 13},
+  {15,  1,  8, 14,  6, 11,  3,  4,  9,  7,  2, 13, 12,  0,  5, 10,
+    3, 13,  4,  7, 15,  2,  8, 14, 12,  0,  1, 10,  6,  9, 11,  5,
+    0, 14,  7, 11, 10,  4, 13,  1,  5,  8, 12,  6,  9,  3,  2, 15,
+   13,  8, 10,  1,  3, 15,  4,  2, 11,  6,  7, 12,  0,  5, 14,  9},
+  {10,  0,  9, 14,  6,  3, 15,  5,  1, 13, 12,  7, 11,  4,  2,  8,
+   13,  7,  0,  9,  3,  4,  6, 10,  2,  8,  5, 14, 12, 11, 15,  1,
+   13,  6,  4,  9,  8, 15,  3,  0, 11,  1,  2, 12,  5, 10, 14,  7,
+    1, 10, 13,  0,  6,  9,  8,  7,  4, 15, 14,  3, 11,  5,  2, 12},
+  { 7, 13, 14,  3,  0,  6,  9, 10,  1,  2,  8,  5, 11, 12,  4, 15,
+   13,  8, 11,  5,  6, 15,  0,  3,  4,  7,  2, 12,  1, 10, 14,  9,
+   10,  6,  9,  0, 12, 11,  7, 13, 15,  1,  3, 14,  5,  2,  8,  4,
+    3, 15,  0,  6, 10,  1, 13,  8,  9,  4,  5, 11, 12,  7,  2, 14},
+  { 2, 12,  4,  1,  7, 10, 11,  6,  8,  5,  3, 15, 13,  0, 14,  9,
+   14, 11,  2, 12,  4,  7, 13,  1,  5,  0, 15, 10,  3,  9,  8,  6,
+    4,  2,  1, 11, 10, 13,  7,  8, 15,  9, 12,  5,  6,  3,  0, 14,
+   11,  8, 12,  7,  1, 14,  2, 13,  6, 15,  0,  9, 10,  4,  5,  3},
+  {12,  1, 10, 15,  9,  2,  6,  8,  0, 13,  3,  4, 14,  7,  5, 11,
+   10, 15,  4,  2,  7, 12,  9,  5,  6,  1, 13, 14,  0, 11,  3,  8,
+    9, 14, 15,  5,  2,  8, 12,  3,  7,  0,  4, 10,  1, 13, 11,  6,
+    4,  3,  2, 12,  9,  5, 15, 10, 11, 14,  1,  7,  6,  0,  8, 13},
+  { 4, 11,  2, 14, 15,  0,  8, 13,  3, 12,  9,  7,  5, 10,  6,  1,
+   13,  0, 11,  7,  4,  9,  1, 10, 14,  3,  5, 12,  2, 15,  8,  6,
+    1,  4, 11, 13, 12,  3,  7, 14, 10, 15,  6,  8,  0,  5,  9,  2,
+    6, 11, 13,  8,  1,  4, 10,  7,  9,  5,  0, 15, 14,  2,  3, 12},
+  {13,  2,  8,  4,  6, 15, 11,  1, 10,  9,  3, 14,  5,  0, 12,  7,
+    1, 15, 13,  8, 10,  3,  7,  4, 12,  5,  6, 11,  0, 14,  9,  2,
+    7, 11,  4,  1,  9, 12, 14,  2,  0,  6, 10, 13, 15,  3,  5,  8,
+    2,  1, 14,  7,  4, 10,  8, 13, 15, 12,  9,  0,  3,  5,  6, 11}};
+
+/* ---- derived tables ---- */
+
+/* S-box n (0-based) for a raw 6-bit input b1..b6 (b1 = bit 5). */
+static unsigned int gen_sbox(int n, unsigned int v) {
+  unsigned int row = ((v >> 4) & 2) | (v & 1), col = (v >> 1) & 0xf;
+
+  return std_s[n][16*row + col];
+}
+
+/* P on a 32-bit word, bit 1 of the Standard in bit 31. */
+static unsigned long gen_p(unsigned long x) {
+  unsigned long out = 0;
+  int i;
+
+  for (i=0; i<32; i++)
+    if ((x >> (32 - std_p[i])) & 1)
+      out |= 1UL << (31 - i);
+  return out;
+}
+
+/* desfunc's SP table: S-box n, placed at its nibble, through P, rotated
+   left one bit because desfunc keeps both halves rotated. */
+static unsigned long gen_sp(int n, unsigned int v) {
+  unsigned long x = gen_p((unsigned long) gen_sbox(n, v) << (28 - 4*n));
+
+  return ((x << 1) | (x >> 31)) & 0xffffffffUL;
+}
+
+/* Key bit (0-based, bit 0 = MSB of key byte 0) feeding bit j (0-based)
+   of round key K(round+1). */
+static int gen_keybit(int round, int j) {
+  int pos = std_pc2[j] - 1, rot = 0, r, half;
+
+  for (r=0; r<=round; r++)
+    rot += std_shifts[r];
+  half = pos < 28 ? 0 : 28;
+  return std_pc1[half + (pos - half + rot) % 28] - 1;
+}
+
+/* ---- C output ---- */
+
+static void emit_bytes(FILE *fp, const char *name, const unsigned char *v,
+                       int n, int per_line) {
+  int i;
+
+  fprintf(fp, "static const unsigned char %s[%d] = {", name, n);
+  for (i=0; i<n; i++)
+    fprintf(fp, "%s%3d%s", i % per_line ? "" : "\n  ", v[i],
+            i == n-1 ? "};\n\n" : ",");
+}
+
+static void emit_words(FILE *fp, const char *name, const unsigned long *v,
+                       int n) {
+  int i;
+
+  fprintf(fp, "static const unsigned long %s[%d] = {", name, n);
+  for (i=0; i<n; i++)
+    fprintf(fp, "%s0x%08lxL%s", i % 4 ? " " : "\n\t", v[i],
+            i == n-1 ? " };\n\n" : ",");
+}
+
+static void layout_key(FILE *fp) {
+  unsigned char pc1[56], pc2[48], totrot[16], bytebit[8];
+  unsigned long bigbyte[24];
+  int i, rot = 0;
+
+  fprintf(fp, "/* Key schedule (deskey): 0-based PC-1 and PC-2, cumulative "
+              "shifts. */\n\n");
+  for (i=0; i<56; i++)
+    pc1[i] = (unsigned char) (std_pc1[i] - 1);
+  for (i=0; i<16; i++)
+    totrot[i] = (unsigned char) (rot += std_shifts[i]);
+  /* deskey indexes PC-2 by the 56 PC-1 outputs, C then D */
+  for (i=0; i<48; i++)
+    pc2[i] = (unsigned char) (std_pc2[i] - 1);
+  for (i=0; i<8; i++)
+    bytebit[i] = (unsigned char) (0x80 >> i);
+  for (i=0; i<24; i++)
+    bigbyte[i] = 0x800000UL >> i;
+  emit_bytes(fp, "pc1", pc1, 56, 14);
+  emit_bytes(fp, "totrot", totrot, 16, 16);
+  emit_bytes(fp, "pc2", pc2, 48, 12);
+  emit_bytes(fp, "bytebit", bytebit, 8, 8);
+  emit_words(fp, "bigbyte", bigbyte, 24);
+}
+
+static void layout_sp(FILE *fp) {
+  unsigned long t[64];
+  char name[8];
+  int n, v;
+
+  fprintf(fp, "/* desfunc SP tables: P(S(v)) rotated left 1, indexed by "
+              "the cooked 6-bit field. */\n\n");
+  for (n=0; n<8; n++) {
+    for (v=0; v<64; v++)
+      t[v] = gen_sp(n, (unsigned int) v);
+    snprintf(name, sizeof(name), "SP%d", n+1);
+    emit_words(fp, name, t, 64);
+  }
+}
+
+static void layout_merged(FILE *fp) {
+  static const int pairs[4][2] = {{0, 2}, {4, 6}, {1, 3}, {5, 7}};
+  static unsigned long t[4096];
+  char name[32];             /* "SP" and two ints */
+  int p, v;
+
+  fprintf(fp, "/* Merged SP tables: SPab[(field a << 6) | field b] = "
+              "SPa | SPb. */\n\n");
+  for (p=0; p<4; p++) {
+    for (v=0; v<4096; v++)
+      t[v] = gen_sp(pairs[p][0], (unsigned int) v >> 6) |
+             gen_sp(pairs[p][1], (unsigned int) v & 0x3f);
+    snprintf(name, sizeof(name), "SP%d%d", pairs[p][0]+1, pairs[p][1]+1);
+    emit_words(fp, name, t, 4096);
+  }
+}
+
+static void layout_compact(FILE *fp) {
+  int n, v;
+
+  fprintf(fp, "/* Raw S-boxes, indexed by the 6-bit input b1..b6 (row = "
+              "b1 b6), and P (0-based). */\n\n");
+  fprintf(fp, "static const unsigned char SBOX[8][64] = {\n");
+  for (n=0; n<8; n++) {
+    for (v=0; v<64; v++)
+      fprintf(fp, "%s%2u%s", v % 16 ? " " : (v ? "\n   " : "  {"),
+              gen_sbox(n, (unsigned int) v), v == 63 ? "" : ",");
+    fprintf(fp, "}%s\n", n == 7 ? "};\n" : ",");
+  }
+  fprintf(fp, "static const unsigned char PBOX[32] = {");
+  for (v=0; v<32; v++)
+    fprintf(fp, "%s%2d%s", v % 16 ? " " : "\n  ", std_p[v] - 1,
+            v == 31 ? "};\n\n" : ",");
+}
+
+static void layout_bitslice(FILE *fp) {
+  unsigned long long tt;
+  int n, j, v;
+
+  fprintf(fp, "/* S-box truth tables: bit v of SBOX_TT[n][j] is output bit "
+              "j (MSB first) of S(n+1)(v). */\n\n");
+  fprintf(fp, "static const unsigned long long SBOX_TT[8][4] = {\n");
+  for (n=0; n<8; n++) {
+    fprintf(fp, "  {");
+    for (j=0; j<4; j++) {
+      tt = 0;
+      for (v=0; v<64; v++)
+        if ((gen_sbox(n, (unsigned int) v) >> (3 - j)) & 1)
+          tt |= 1ULL << v;
+      fprintf(fp, "0x%016llxULL%s", tt, j == 3 ? "" : ", ");
+    }
+    fprintf(fp, "}%s\n", n == 7 ? "};\n" : ",");
+  }
+}
+
+static int emit_c(const char *layout, const char *outname) {
+  FILE *fp = stdout;
+  int all = strcmp(layout, "all") == 0, any = 0;
+
+  if (outname && (fp = fopen(outname, "w")) == NULL) {
+    perror(outname);
+    return 1;
+  }
+  fprintf(fp, "/* Generated by des_c/desGen.c -l %s from the FIPS 46-3 "
+              "tables; do not edit. */\n\n", layout);
+  if (all || strcmp(layout, "key") == 0)      { layout_key(fp); any = 1; }
+  if (all || strcmp(layout, "sp") == 0)       { layout_sp(fp); any = 1; }
+  if (all || strcmp(layout, "merged") == 0)   { layout_merged(fp); any = 1; }
+  if (all || strcmp(layout, "compact") == 0)  { layout_compact(fp); any = 1; }
+  if (all || strcmp(layout, "bitslice") == 0) { layout_bitslice(fp); any = 1; }
+  if (fp != stdout)
+    fclose(fp);
+  if (!any) {
+    fprintf(stderr, "unknown layout %s\n", layout);
+    return 2;
+  }
+  return 0;
+}
+
+/* ---- fixed-key engines ---- */
+
+#define FK_MAX 32
+
+typedef struct {
+  char name[32];
+  int nkeys;
+  unsigned char key[3][8];
+} fk_spec;
+
+static int fk_hex(int c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* Parse "name=KEY[,KEY2,KEY3]"; 0 on success. */
+static int fk_parse(const char *arg, fk_spec *fk) {
+  const char *eq = strchr(arg, '='), *p;
+  size_t n, len;
+  int i;
+
+  if (eq == NULL || eq == arg || (n = (size_t) (eq - arg)) >= sizeof(fk->name))
+    return -1;
+  for (i=0; i<(int) n; i++)
+    if (!(isalnum((unsigned char) arg[i]) || arg[i] == '_'))
+      return -1;
+  memcpy(fk->name, arg, n);
+  fk->name[n] = '\0';
+
+  for (fk->nkeys=0, p=eq+1; ; fk->nkeys++) {
+    if (fk->nkeys == 3)
+      return -1;
+    len = strcspn(p, ",");
+    if (len == 8) {
+      memcpy(fk->key[fk->nkeys], p, 8);
+    } else if (len == 16) {
+      for (i=0; i<8; i++) {
+        int hi = fk_hex(p[2*i]), lo = fk_hex(p[2*i+1]);
+
+        if (hi < 0 || lo < 0)
+          return -1;
+        fk->key[fk->nkeys][i] = (unsigned char) (hi << 4 | lo);
+      }
+    } else {
+      return -1;
+    }
+    p += len;
+    if (*p == '\0')
+      break;
+    p++;
+  }
+  fk->nkeys++;
+  return fk->nkeys == 2 ? -1 : 0;
+}
+
+static int emit_fixed(const fk_spec *fk, int n, const char *outname) {
+  FILE *fp = stdout;
+  unsigned long cooked[32];
+  char name[64];             /* des_fk_ + 31-char name + _ekN */
+  int i, j, k;
+
+  if (outname && (fp = fopen(outname, "w")) == NULL) {
+    perror(outname);
+    return 1;
+  }
+  fprintf(fp, "/* Generated by des_c/desGen.c -k; do not edit.  Cooked "
+              "schedules for keys\n   fixed at build time and the "
+              "desUnroll.h engines specialised on them. */\n\n");
+  fprintf(fp, "#ifndef DU_DEFINE_FIXED\n"
+              "#error \"include desUnroll.h before this header\"\n"
+              "#endif\n\n");
+  for (i=0; i<n; i++) {
+    for (k=0; k<fk[i].nkeys; k++) {
+      fprintf(fp, "/* %s key %d: ", fk[i].name, k+1);
+      for (j=0; j<8; j++)
+        fprintf(fp, "%02x", fk[i].key[k][j]);
+      fprintf(fp, " */\n");
+      deskey_r((unsigned char *) fk[i].key[k], EN0, cooked);
+      snprintf(name, sizeof(name), "des_fk_%.31s_ek%d", fk[i].name, k+1);
+      emit_words(fp, name, cooked, 32);
+    }
+    if (fk[i].nkeys == 1) {
+      fprintf(fp, "DU_DEFINE_FIXED(des_fk_%s_enc, DU_HALF_SP, EN0, "
+                  "des_fk_%s_ek1)\n", fk[i].name, fk[i].name);
+      fprintf(fp, "DU_DEFINE_FIXED(des_fk_%s_dec, DU_HALF_SP, DE1, "
+                  "des_fk_%s_ek1)\n\n", fk[i].name, fk[i].name);
+    } else {
+      fprintf(fp, "DU_DEFINE3_FIXED(des_fk_%s_enc, DU_HALF_SP,\n"
+                  "                 des_fk_%s_ek1, EN0, des_fk_%s_ek2, EN0, "
+                  "des_fk_%s_ek3, EN0)\n", fk[i].name, fk[i].name,
+                  fk[i].name, fk[i].name);
+      fprintf(fp, "DU_DEFINE3_FIXED(des_fk_%s_dec, DU_HALF_SP,\n"
+                  "                 des_fk_%s_ek3, DE1, des_fk_%s_ek2, DE1, "
+                  "des_fk_%s_ek1, DE1)\n\n", fk[i].name, fk[i].name,
+                  fk[i].name, fk[i].name);
+    }
+  }
+
+  fprintf(fp, "static const struct {\n"
+              "  const char *name;\n"
+              "  int nkeys;\n"
+              "  unsigned char key[24];\n"
+              "  void (*enc)(unsigned char *, int);\n"
+              "  void (*dec)(unsigned char *, int);\n"
+              "} des_fixed[%d] = {\n", n);
+  for (i=0; i<n; i++) {
+    fprintf(fp, "  {\"%s\", %d, {", fk[i].name, fk[i].nkeys);
+    for (k=0; k<fk[i].nkeys; k++)
+      for (j=0; j<8; j++)
+        fprintf(fp, "%s0x%02x", k+j ? (j ? ", " : ",\n    ") : "",
+                fk[i].key[k][j]);
+    fprintf(fp, "},\n   des_fk_%s_enc, des_fk_%s_dec}%s\n", fk[i].name,
+            fk[i].name, i == n-1 ? "" : ",");
+  }
+  fprintf(fp, "};\n");
+  if (fp != stdout)
+    fclose(fp);
+  return 0;
+}
+
+/* ---- VHDL output ---- */
+
+static void vhdl_header(FILE *fp, const char *title) {
+  fprintf(fp,
+    "---------------------------------------------------------------------------------------------------\n"
+    "--\n"
+    "-- Title       : %s\n"
+    "--\n"
+    "-- Generated by des_c/desGen.c -V from the FIPS 46-3 tables; do not edit.\n"
+    "--\n"
+    "---------------------------------------------------------------------------------------------------\n"
+    "\n"
+    "library IEEE;\n"
+    "use IEEE.STD_LOGIC_1164.ALL;\n"
+    "use IEEE.STD_LOGIC_ARITH.ALL;\n"
+    "use IEEE.STD_LOGIC_UNSIGNED.ALL;\n\n", title);
+}
+
+static FILE *vhdl_open(const char *dir, const char *name) {
+  char path[4096];
+  FILE *fp;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  if ((fp = fopen(path, "w")) == NULL)
+    perror(path);
+  return fp;
+}
+
+static int emit_sbox_vhdl(const char *dir, int n) {
+  char name[32], title[16];
+  unsigned int s;
+  FILE *fp;
+  int v, b;
+
+  snprintf(name, sizeof(name), "s%d_box.vhd", n+1);
+  snprintf(title, sizeof(title), "s%d_box", n+1);
+  if ((fp = vhdl_open(dir, name)) == NULL)
+    return 1;
+  vhdl_header(fp, title);
+  fprintf(fp, "ENTITY %s IS\n\tport (\n\tA: IN std_logic_VECTOR(5 downto 0);\n"
+              "\tSPO: OUT std_logic_VECTOR(3 downto 0));\nEND %s;\n\n"
+              "architecture Behavioral of %s is\n\nbegin\n\n",
+              title, title, title);
+  for (v=0; v<64; v++) {
+    s = gen_sbox(n, (unsigned int) v);
+    fprintf(fp, "%s\"", v ? "\t\t\t" : "SPO \t<= ");
+    for (b=3; b>=0; b--)
+      fputc('0' + ((s >> b) & 1), fp);
+    fprintf(fp, "\" when A = x\"%X\" else\n", v);
+  }
+  /* default: the last entry, as the hand-written boxes do */
+  fprintf(fp, "\t\t\t\"");
+  for (b=3; b>=0; b--)
+    fputc('0' + ((s >> b) & 1), fp);
+  fprintf(fp, "\";\n\nEND Behavioral;\n");
+  fclose(fp);
+  return 0;
+}
+
+static int emit_key_schedule_vhdl(const char *dir) {
+  FILE *fp;
+  int k, j;
+
+  if ((fp = vhdl_open(dir, "key_schedule.vhd")) == NULL)
+    return 1;
+  vhdl_header(fp, "key_schedule");
+  fprintf(fp,
+    "entity key_schedule is\n"
+    "port (\n\n"
+    "\t\tkey_in:\t\t\tin std_logic_vector(0 to 63);\t\t-- key to be expanded\n\n"
+    "\t\t-- interface signals for communication with DES\n"
+    "\t\tKeySelect: \t\tin std_logic_vector(3 downto 0);\t-- selector for key\n"
+    "\t\tkey_out: \t\tout std_logic_vector(0 to 47);\t-- expaned key output\n"
+    "\t\tkey_all_out:\tout std_logic_vector(0 to 767);\t-- all expanded keys, K1 first (pipelined core)\n"
+    "\t\tkey_ready: \t\tout std_logic;\t\t\t\t\t\t\t-- signal for DES that key has been expanded\n\n"
+    "\t\treset: \t\t\tin std_logic; \t\t\t\t\t\t\t-- reset\n"
+    "\t\tclock: \t\t\tin std_logic  \t\t\t\t\t\t\t-- master clock\n"
+    "\t\t);\n"
+    "end key_schedule;\n\n"
+    "architecture Behavioral of key_schedule is\n\n"
+    "--\n-- Storage for expanded key\n--\n");
+  for (k=1; k<=16; k++)
+    fprintf(fp, "signal K%d: std_logic_vector(0 to 47);\n", k);
+  fprintf(fp, "\nbegin\n\n--\n-- Selector for expaned key\n--\n");
+  for (k=1; k<=16; k++)
+    if (k < 16)
+      fprintf(fp, "%sK%d \twhen \tKeySelect = x\"%X\" else\n",
+              k == 1 ? "key_out <= \t" : "\t\t\t\t", k, k-1);
+    else
+      fprintf(fp, "\t\t\t\tK16;\n\n");
+  fprintf(fp, "--\n-- All sixteen expanded keys at once, one per stage of the "
+              "pipelined core\n--\nkey_all_out <= K1");
+  for (k=2; k<=16; k++)
+    fprintf(fp, " & K%d", k);
+  fprintf(fp, ";\n\nprocess (clock)\nbegin\n\nif rising_edge(clock) then\n\n"
+              "\tif reset = '1' then\n\t\tkey_ready <= '0';\n\telse\n\n"
+              "\t\t--\n\t\t-- key expansion from the input key: K(i) bit j is "
+              "PC-2 of PC-1 rotated by the\n\t\t-- cumulative shift of round i\n"
+              "\t\t--\n");
+  for (k=0; k<16; k++) {
+    fprintf(fp, "\t\tK%d <= ", k+1);
+    for (j=0; j<48; j++)
+      fprintf(fp, "%skey_in(%d)%s", j && j % 8 == 0 ? "\t\t\t\t" : "",
+              gen_keybit(k, j),
+              j == 47 ? ";\n\n" : (j % 8 == 7 ? " &\n" : " & "));
+  }
+  fprintf(fp, "\t\tkey_ready <= '1';\n\n\tend if;\n\nend if;\nend process;\n\n"
+              "end Behavioral;\n");
+  fclose(fp);
+  return 0;
+}
+
+static int emit_vhdl(const char *dir) {
+  int n, rc = 0;
+
+  mkdir(dir, 0777);
+  rc |= emit_key_schedule_vhdl(dir);
+  for (n=0; n<8; n++)
+    rc |= emit_sbox_vhdl(dir, n);
+  if (rc == 0)
+    fprintf(stderr, "key_schedule.vhd s1_box.vhd..s8_box.vhd -> %s\n", dir);
+  return rc;
+}
+
+/* ---- self-check against the live tables ---- */
+
+static int check(void) {
+  static unsigned long *sp[8] = {SP1, SP2, SP3, SP4, SP5, SP6, SP7, SP8};
+  unsigned char key[8] = {0x13, 0x34, 0x57, 0x79, 0x9b, 0xbc, 0xdf, 0xf1};
+  unsigned long cooked[32];
+  unsigned long long kn;
+  int i, n, v, j, rot = 0, bad = 0, bit;
+
+  for (i=0; i<56; i++)
+    bad += pc1[i] != std_pc1[i] - 1;
+  for (i=0; i<16; i++)
+    bad += totrot[i] != (rot += std_shifts[i]);
+  for (i=0; i<48; i++)
+    bad += pc2[i] != std_pc2[i] - 1;
+  for (n=0; n<8; n++)
+    for (v=0; v<64; v++)
+      if (sp[n][v] != gen_sp(n, (unsigned int) v)) {
+        if (bad < 10)
+          fprintf(stderr, "SP%d[%d] = %08lx, generated %08lx\n", n+1, v,
+                  sp[n][v], gen_sp(n, (unsigned int) v));
+        bad++;
+      }
+
+  /* the VHDL key-bit selections against deskey's round keys */
+  deskey(key, EN0);
+  cpkey(cooked);
+  for (i=0; i<16; i++) {
+    kn = des_trace_subkey((unsigned int) cooked[2*i],
+                          (unsigned int) cooked[2*i+1]);
+    for (j=0; j<48; j++) {
+      bit = gen_keybit(i, j);
+      if (((kn >> (47 - j)) & 1) != ((key[bit >> 3] >> (7 - (bit & 7))) & 1))
+        bad++;
+    }
+  }
+  /* and E, which desfunc never spells out: field n of E(R) is bits
+     4n-1 .. 4n+4 of R (1-based, wrapping) */
+  for (i=0; i<48; i++)
+    bad += std_e[i] != (unsigned char) ((4*(i/6) + i%6 + 31) % 32 + 1);
+
+  printf("%s: %d differences\n", bad ? "FAIL" : "ok", bad);
+  return bad ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  const char *layout = NULL, *outname = NULL, *vdir = NULL;
+  static fk_spec fixed[FK_MAX];
+  int opt, do_check = 0, nfixed = 0;
+
+  while ((opt = getopt(argc, argv, "l:k:o:V:c")) != -1) {
+    switch (opt) {
+    case 'l': layout = optarg; break;
+    case 'k':
+      if (nfixed == FK_MAX || fk_parse(optarg, &fixed[nfixed]) != 0) {
+        fprintf(stderr, "bad -k %s (name=KEY[,KEY2,KEY3], KEY 16 hex "
+                        "digits or 8 characters)\n", optarg);
+        return 2;
+      }
+      nfixed++;
+      break;
+    case 'o': outname = optarg; break;
+    case 'V': vdir = optarg; break;
+    case 'c': do_check = 1; break;
+    default:
+      layout = vdir = NULL;
+      do_check = 0;
+      optind = argc;
+      break;
+    }
+  }
+  if ((!layout && !nfixed && !vdir && !do_check) || (layout && nfixed)) {
+    fprintf(stderr, "usage: %s [-l key|sp|merged|compact|bitslice|all "
+                    "[-o file]] [-k name=KEY[,KEY2,KEY3] ... [-o file]] "
+                    "[-V dir] [-c]\n", argv[0]);
+    return 2;
+  }
+  if (do_check && check())
+    return 1;
+  if (layout && emit_c(layout, outname))
+    return 1;
+  if (nfixed && emit_fixed(fixed, nfixed, outname))
+    return 1;
+  if (vdir && emit_vhdl(vdir))
+    return 1;
+  return 0;
+}
@@ -0,0 +1,101 @@
+/* Log-linear ("HDR-style") latency histogram.
+ *
+ * Values are nanoseconds.  Anything below 2^HIST_SUB_BITS is counted
+ * exactly; above that every power of two is split into 2^(HIST_SUB_BITS-1)
+ * equal buckets, so a reported percentile is never more than ~1.6% off
+ * the true value, all the way up to 2^63 ns.  Recording is a clz, two
+ * shifts and an increment, cheap enough to wrap a single des_enc() call.
+ *
+ * Header-only (static), like the tables in des.h: include it in exactly
+ * one translation unit.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define HIST_SUB_BITS 7
+#define HIST_SUB      (1 << HIST_SUB_BITS)           /* 128 exact buckets */
+#define HIST_HALF     (HIST_SUB >> 1)                /* 64 per octave */
+#define HIST_BUCKETS  (HIST_SUB + (64 - HIST_SUB_BITS) * HIST_HALF)
+
+typedef struct {
+  uint64_t count[HIST_BUCKETS];
+  uint64_t total;
+  uint64_t min;
+  uint64_t max;
+  double   sum;
+} des_hist;
+
+static void hist_init(des_hist *h) {
+  memset(h, 0, sizeof(*h));
+  h->min = UINT64_MAX;
+}
+
+static int hist_index(uint64_t v) {
+  int msb, shift;
+
+  if (v < HIST_SUB)
+    return (int) v;
+  msb = 63 - __builtin_clzll(v);
+  shift = msb - (HIST_SUB_BITS - 1);
+  return HIST_SUB + (shift - 1) * HIST_HALF + (int) ((v >> shift) - HIST_HALF);
+}
+
+/* Highest value that lands in bucket idx, so percentiles never
+   under-report. */
+static uint64_t hist_value(int idx) {
+  int shift;
+
+  if (idx < HIST_SUB)
+    return (uint64_t) idx;
+  idx -= HIST_SUB;
+  shift = idx / HIST_HALF + 1;
+  return ((uint64_t) (HIST_HALF + idx % HIST_HALF + 1) << shift) - 1;
+}
+
+static void hist_record(des_hist *h, uint64_t v) {
+  h->count[hist_index(v)]++;
+  h->total++;
+  h->sum += (double) v;
+  if (v < h->min) h->min = v;
+  if (v > h->max) h->max = v;
+}
+
+/* p in [0,100]. */
+static uint64_t hist_percentile(const des_hist *h, double p) {
+  uint64_t want, seen;
+  int i;
+
+  if (h->total == 0)
+    return 0;
+  want = (uint64_t) (p / 100.0 * (double) h->total + 0.5);
+  if (want < 1) want = 1;
+  if (want > h->total) want = h->total;
+  seen = 0;
+  for (i=0; i<HIST_BUCKETS; i++) {
+    seen += h->count[i];
+    if (seen >= want)
+      return hist_value(i) < h->max ? hist_value(i) : h->max;
+  }
+  return h->max;
+}
+
+static void hist_print(FILE *fp, const char *label, const des_hist *h) {
+  fprintf(fp, "%-14s n=%-10llu min=%-7llu p50=%-7llu p99=%-7llu "
+              "p99.9=%-7llu max=%-9llu mean=%.1f (ns)\n",
+          label, (unsigned long long) h->total,
+          (unsigned long long) (h->total ? h->min : 0),
+          (unsigned long long) hist_percentile(h, 50.0),
+          (unsigned long long) hist_percentile(h, 99.0),
+          (unsigned long long) hist_percentile(h, 99.9),
+          (unsigned long long) h->max,
+          h->total ? h->sum / (double) h->total : 0.0);
+}
+
+static inline uint64_t hist_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
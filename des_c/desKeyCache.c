@@ -0,0 +1,165 @@
+/* Benchmark for the des_kcache key-schedule cache on a skewed key
+ * stream: -H hot keys take -p percent of the requests, the rest are
+ * spread over a universe of -u cold keys.  Each of -t threads serves
+ * -q requests of one block each.  Every request is run twice: once
+ * through des_key() (two deskey() calls) and once through the cache.
+ * A sample of cached schedules is compared with a fresh des_key().
+ *
+ *   gcc -O2 -pthread desKeyCache.c -o desKeyCache
+ *   ./desKeyCache [-t threads] [-q requests] [-H hot] [-u universe]
+ *                 [-p hot_percent] [-m MB] [-3] [-s seed]
+ *
+ *   -H  hot keys (default 4000)
+ *   -u  cold key universe (default 4000000)
+ *   -p  percentage of requests for a hot key (default 95)
+ *   -m  cache memory cap in MB (default 8)
+ *   -3  cache 24-byte triples and run triple DES per request
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+#include <time.h>
+
+typedef struct {
+  pthread_t tid;
+  unsigned long long seed;
+  int cached;
+  unsigned long long checked, bad;
+} kc_thread;
+
+static des_kcache cache;
+static unsigned long requests = 1000000, hot = 4000, universe = 4000000;
+static int hot_percent = 95, nkeys = 1;
+
+static unsigned long long kc_rand(unsigned long long *s) {
+  *s ^= *s << 13;
+  *s ^= *s >> 7;
+  *s ^= *s << 17;
+  return *s;
+}
+
+/* Key bytes of key number n (hot keys are 0..hot-1). */
+static void kc_key(unsigned long long n, unsigned char *key) {
+  unsigned long long r;
+  int k, i;
+
+  for (k=0; k<nkeys; k++) {
+    r = (n * 3 + k + 1) * 0x9e3779b97f4a7c15ULL;
+    r ^= r >> 31;
+    r *= 0xbf58476d1ce4e5b9ULL;
+    r ^= r >> 29;
+    for (i=0; i<8; i++, r >>= 8)
+      key[8*k+i] = (unsigned char) r;
+  }
+}
+
+static void *kc_run(void *arg) {
+  kc_thread *t = arg;
+  unsigned char key[24], blk[8];
+  des_ctx ctx[3], ref;
+  unsigned long i, n;
+  int k;
+
+  for (i=0; i<requests; i++) {
+    if (kc_rand(&t->seed) % 100 < (unsigned long long) hot_percent)
+      n = kc_rand(&t->seed) % hot;
+    else
+      n = hot + kc_rand(&t->seed) % universe;
+    kc_key(n, key);
+    if (t->cached) {
+      des_kcache_get(&cache, key, ctx);
+      if ((i & 1023) == 0) {
+        for (k=0; k<nkeys; k++) {
+          des_key(&ref, key + 8*k);
+          if (memcmp(&ref, &ctx[k], sizeof(ref)) != 0)
+            t->bad++;
+        }
+        t->checked++;
+      }
+    } else {
+      for (k=0; k<nkeys; k++)
+        des_key(&ctx[k], key + 8*k);
+    }
+    memcpy(blk, &i, sizeof(blk) < sizeof(i) ? sizeof(blk) : sizeof(i));
+    for (k=0; k<nkeys; k++)
+      des_enc(&ctx[k], blk, 1);
+  }
+  return NULL;
+}
+
+static double kc_pass(kc_thread *th, int threads, int cached,
+                      unsigned long long seed) {
+  struct timespec t0, t1;
+  int i;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i=0; i<threads; i++) {
+    th[i].seed = seed + 0x632be59bd9b4e019ULL * (i + 1);
+    th[i].cached = cached;
+    pthread_create(&th[i].tid, NULL, kc_run, &th[i]);
+  }
+  for (i=0; i<threads; i++)
+    pthread_join(th[i].tid, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  unsigned long long seed = 0x2545f4914f6cdd1dULL, hits, misses, evictions;
+  unsigned long long checked = 0, bad = 0;
+  unsigned long entries;
+  double mb = 8, t_key, t_cache, total;
+  int threads = 1, opt, i;
+  kc_thread *th;
+
+  while ((opt = getopt(argc, argv, "t:q:H:u:p:m:3s:")) != -1) {
+    switch (opt) {
+    case 't': threads = atoi(optarg); break;
+    case 'q': requests = strtoul(optarg, NULL, 0); break;
+    case 'H': hot = strtoul(optarg, NULL, 0); break;
+    case 'u': universe = strtoul(optarg, NULL, 0); break;
+    case 'p': hot_percent = atoi(optarg); break;
+    case 'm': mb = atof(optarg); break;
+    case '3': nkeys = 3; break;
+    case 's': seed = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-t threads] [-q requests] [-H hot] "
+                      "[-u universe] [-p hot_percent] [-m MB] [-3] "
+                      "[-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (threads < 1 || hot == 0 || universe == 0) {
+    fprintf(stderr, "nothing to do\n");
+    return 2;
+  }
+  if (des_kcache_init(&cache, (size_t) (mb * (1 << 20)), nkeys) != 0) {
+    fprintf(stderr, "des_kcache: %.1f MB is too small\n", mb);
+    return 1;
+  }
+  th = calloc(threads, sizeof(*th));
+
+  t_key = kc_pass(th, threads, 0, seed);
+  t_cache = kc_pass(th, threads, 1, seed);
+  for (i=0; i<threads; i++) {
+    checked += th[i].checked;
+    bad += th[i].bad;
+  }
+  des_kcache_stats(&cache, &hits, &misses, &evictions, &entries);
+  total = (double) requests * threads;
+
+  printf("%d threads, %lu requests each, %lu hot keys (%d%%), %lu cold, "
+         "%s keys\n", threads, requests, hot, hot_percent, universe,
+         nkeys == 3 ? "24-byte" : "8-byte");
+  printf("cache: %.1f MB cap, %lu entries, hits=%llu misses=%llu "
+         "evictions=%llu hit rate=%.1f%%\n", mb, entries, hits, misses,
+         evictions, 100.0 * hits / (hits + misses));
+  printf("des_key per request: %12.0f requests/s\n", total / t_key);
+  printf("des_kcache_get:      %12.0f requests/s -> %.2fx\n",
+         total / t_cache, t_key / t_cache);
+  printf("checked=%llu mismatches=%llu\n", checked, bad);
+  des_kcache_destroy(&cache);
+  free(th);
+  return bad ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+/* Load generator for the small-message path: one request is des_key()
+ * plus des_enc()/des_dec() over 1..4 blocks, the way the online path
+ * (and main() in des.c) drives the engine.  Every request is timed and
+ * recorded in log-linear histograms (desHist.h); p50/p99/p99.9 are
+ * reported per phase.
+ *
+ *   gcc -O2 -pthread desLatency.c -o desLatency
+ *   ./desLatency [-n requests] [-b maxblocks] [-k keypool] [-3] [-d]
+ *                [-c evict_every] [-w warmup]
+ *
+ *   -n  number of timed requests (default 1000000)
+ *   -b  blocks per request, uniformly 1..b (default 4, max 4)
+ *   -k  size of the key pool; each request picks a key at random and
+ *       re-runs des_key() (default 1000).  -k 0 keys once up front so
+ *       only des_enc/des_dec are on the clock.
+ *   -3  triple DES (key1/key2/key3 chained as in main())
+ *   -d  also decrypt every request and check the round trip
+ *   -c  stream a 32MB buffer through the caches every N requests so the
+ *       next request sees cold SP tables and key schedule (default off)
+ *   -w  untimed warm-up requests (default 10000)
+ *   -x  route des_enc/des_dec through the differential cross-checker,
+ *       re-checking ~1 block in N against desfunc (e.g. -x 1000)
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include "desHist.h"
+#include <unistd.h>
+
+#define MAX_BLOCKS  4
+#define EVICT_BYTES (32 << 20)
+
+static uint64_t lat_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t lat_rand(void) {
+  lat_state ^= lat_state << 13;
+  lat_state ^= lat_state >> 7;
+  lat_state ^= lat_state << 17;
+  return lat_state;
+}
+
+static void lat_fill(unsigned char *p, int n) {
+  uint64_t r = 0;
+  int i;
+
+  for (i=0; i<n; i++) {
+    if ((i & 7) == 0)
+      r = lat_rand();
+    p[i] = (unsigned char) r;
+    r >>= 8;
+  }
+}
+
+static void lat_evict(unsigned char *buf) {
+  size_t i;
+
+  for (i=0; i<EVICT_BYTES; i+=64)
+    buf[i]++;
+}
+
+int main(int argc, char **argv) {
+  long requests = 1000000, warmup = 10000, evict = 0;
+  int maxblocks = MAX_BLOCKS, keypool = 1000, triple = 0, decrypt = 0;
+  unsigned long xrate = 0;
+  int opt, nkeys, passes, blocks, k, p;
+  long i, failures = 0;
+  unsigned char *keys, *evictbuf = NULL;
+  unsigned char data[8*MAX_BLOCKS], orig[8*MAX_BLOCKS];
+  des_ctx dc[3];
+  des_hist h_key, h_enc, h_dec, h_req;
+  des_xcheck xc;
+  uint64_t t0, t1, t2, t3;
+
+  while ((opt = getopt(argc, argv, "n:b:k:3dc:w:x:")) != -1) {
+    switch (opt) {
+    case 'n': requests = atol(optarg); break;
+    case 'b': maxblocks = atoi(optarg); break;
+    case 'k': keypool = atoi(optarg); break;
+    case '3': triple = 1; break;
+    case 'd': decrypt = 1; break;
+    case 'c': evict = atol(optarg); break;
+    case 'w': warmup = atol(optarg); break;
+    case 'x': xrate = strtoul(optarg, NULL, 0); break;
+    default:
+      fprintf(stderr, "usage: %s [-n requests] [-b maxblocks] [-k keypool] "
+                      "[-3] [-d] [-c evict_every] [-w warmup] [-x rate]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (maxblocks < 1 || maxblocks > MAX_BLOCKS) {
+    fprintf(stderr, "-b must be 1..%d\n", MAX_BLOCKS);
+    return 2;
+  }
+
+  passes = triple ? 3 : 1;
+  nkeys = keypool > 0 ? keypool : 1;
+  keys = malloc((size_t) nkeys * 8 * passes);
+  if (keys == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  lat_fill(keys, nkeys * 8 * passes);
+  if (evict) {
+    evictbuf = calloc(1, EVICT_BYTES);
+    if (evictbuf == NULL) {
+      perror("calloc");
+      return 1;
+    }
+  }
+  if (keypool == 0)
+    for (p=0; p<passes; p++)
+      des_key(&dc[p], keys + 8*p);
+
+  des_xcheck_init(&xc, "des_enc", des_enc, des_dec, xrate, 1);
+  hist_init(&h_key);
+  hist_init(&h_enc);
+  hist_init(&h_dec);
+  hist_init(&h_req);
+
+  for (i=-warmup; i<requests; i++) {
+    blocks = 1 + (int) (lat_rand() % (uint64_t) maxblocks);
+    k = keypool > 0 ? (int) (lat_rand() % (uint64_t) keypool) : 0;
+    lat_fill(data, 8*blocks);
+    memcpy(orig, data, 8*blocks);
+    if (evict && i >= 0 && i % evict == 0)
+      lat_evict(evictbuf);
+
+    t0 = hist_now();
+    if (keypool > 0)
+      for (p=0; p<passes; p++)
+        des_key(&dc[p], keys + 8*(k*passes + p));
+    t1 = hist_now();
+    for (p=0; p<passes; p++)
+      if (xrate)
+        des_xcheck_enc(&xc, &dc[p], data, blocks);
+      else
+        des_enc(&dc[p], data, blocks);
+    t2 = hist_now();
+    if (decrypt) {
+      for (p=passes-1; p>=0; p--)
+        if (xrate)
+          des_xcheck_dec(&xc, &dc[p], data, blocks);
+        else
+          des_dec(&dc[p], data, blocks);
+    }
+    t3 = hist_now();
+
+    if (decrypt && memcmp(data, orig, 8*blocks) != 0)
+      failures++;
+    if (i < 0)
+      continue;
+    if (keypool > 0)
+      hist_record(&h_key, t1 - t0);
+    hist_record(&h_enc, t2 - t1);
+    if (decrypt)
+      hist_record(&h_dec, t3 - t2);
+    hist_record(&h_req, t3 - t0);
+  }
+
+  printf("requests=%ld blocks=1..%d keypool=%d %s%s%s\n", requests, maxblocks,
+         keypool, triple ? "3DES" : "DES", decrypt ? " +dec" : "",
+         evict ? " cold-cache" : "");
+  if (keypool > 0)
+    hist_print(stdout, "des_key", &h_key);
+  hist_print(stdout, "des_enc", &h_enc);
+  if (decrypt)
+    hist_print(stdout, "des_dec", &h_dec);
+  hist_print(stdout, "request", &h_req);
+  if (decrypt)
+    printf("round-trip failures: %ld\n", failures);
+  if (xrate)
+    printf("cross-check: %llu blocks, %llu checked, %llu mismatches\n",
+           xc.blocks, xc.checked, xc.mismatches);
+
+  free(keys);
+  free(evictbuf);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/* Check the batched modes against the one-block reference
+ * (scrunch/desfunc/unscrun per block, in the order the mode defines):
+ *
+ *   ecb     des_enc, des_dec
+ *   ctr     des_ctr, counters that carry across bytes included
+ *   cbc     des_cbc_enc, des_cbc_dec
+ *
+ * for every length up to a few DES_CHUNKs (so every tail modulo the
+ * AVX2 group and DES_INTERLEAVE) plus random long ones, each message
+ * also split across two calls to check that CTR and CBC carry their
+ * state.  Everything runs with the AVX2 kernel off, then on if the CPU
+ * has it.  Then each mode is timed against its reference.
+ *
+ *   gcc -O2 -pthread desModes.c -o desModes
+ *   gcc -O2 -pthread -DDES_INTERLEAVE=8 desModes.c -o desModes
+ *   ./desModes [-b blocks] [-r trials] [-n passes] [-s seed]
+ *
+ *   -b  blocks per timed buffer and longest random message (default 4096)
+ *   -r  random long messages per mode (default 200)
+ *   -n  timed passes over the buffer (default 200)
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+#include <time.h>
+
+#define MD_SHORT (3*DES_CHUNK + 8 + DES_INTERLEAVE)  /* every length up to */
+
+static unsigned long long md_state = 0x1f83d9abfb41bd6bULL;
+
+static unsigned long long md_rand(void) {
+  md_state ^= md_state << 13;
+  md_state ^= md_state >> 7;
+  md_state ^= md_state << 17;
+  return md_state;
+}
+
+static double md_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void md_block(unsigned long *keys, unsigned char *cp) {
+  unsigned long work[2];
+
+  scrunch(cp, work);
+  desfunc(work, keys);
+  unscrun(work, cp);
+}
+
+static void ref_enc(des_ctx *dc, unsigned char *iv, unsigned char *d, int n) {
+  (void) iv;
+  for (; n>0; n--, d+=8)
+    md_block(dc->ek, d);
+}
+
+static void ref_dec(des_ctx *dc, unsigned char *iv, unsigned char *d, int n) {
+  (void) iv;
+  for (; n>0; n--, d+=8)
+    md_block(dc->dk, d);
+}
+
+static void ref_ctr(des_ctx *dc, unsigned char *ctr, unsigned char *d,
+                    int n) {
+  unsigned char ks[8];
+  int j;
+
+  for (; n>0; n--, d+=8) {
+    memcpy(ks, ctr, 8);
+    md_block(dc->ek, ks);
+    for (j=0; j<8; j++)
+      d[j] ^= ks[j];
+    for (j=7; j>=0; j--)
+      if (++ctr[j] != 0)
+        break;
+  }
+}
+
+static void ref_cbc_enc(des_ctx *dc, unsigned char *iv, unsigned char *d,
+                        int n) {
+  int j;
+
+  for (; n>0; n--, d+=8) {
+    for (j=0; j<8; j++)
+      d[j] ^= iv[j];
+    md_block(dc->ek, d);
+    memcpy(iv, d, 8);
+  }
+}
+
+static void ref_cbc_dec(des_ctx *dc, unsigned char *iv, unsigned char *d,
+                        int n) {
+  unsigned char c[8];
+  int j;
+
+  for (; n>0; n--, d+=8) {
+    memcpy(c, d, 8);
+    md_block(dc->dk, d);
+    for (j=0; j<8; j++)
+      d[j] ^= iv[j];
+    memcpy(iv, c, 8);
+  }
+}
+
+/* the ECB entry points take no iv */
+static void md_enc(des_ctx *dc, unsigned char *iv, unsigned char *d, int n) {
+  (void) iv;
+  des_enc(dc, d, n);
+}
+
+static void md_dec(des_ctx *dc, unsigned char *iv, unsigned char *d, int n) {
+  (void) iv;
+  des_dec(dc, d, n);
+}
+
+typedef void (*md_fn)(des_ctx *, unsigned char *, unsigned char *, int);
+
+static const struct {
+  const char *name;
+  md_fn fn, ref;
+} modes[] = {
+  {"ecb enc",  md_enc,      ref_enc},
+  {"ecb dec",  md_dec,      ref_dec},
+  {"ctr",      des_ctr,     ref_ctr},
+  {"cbc enc",  des_cbc_enc, ref_cbc_enc},
+  {"cbc dec",  des_cbc_dec, ref_cbc_dec},
+};
+
+/* One message of n blocks: whole, then split at a random block into two
+   calls.  Returns the number of mismatches (output or final iv). */
+static int md_check(int m, des_ctx *dc, const unsigned char *in,
+                    unsigned char *want, unsigned char *buf, int n) {
+  unsigned char iv0[8], ivw[8], ivb[8];
+  int j, cut, bad = 0;
+
+  for (j=0; j<8; j++)
+    iv0[j] = (unsigned char) md_rand();
+  if (md_rand() % 4 == 0)                 /* make the counter carry */
+    memset(iv0 + 4, 0xff, 4);
+  memcpy(want, in, 8 * (size_t) n);
+  memcpy(ivw, iv0, 8);
+  modes[m].ref(dc, ivw, want, n);
+
+  memcpy(buf, in, 8 * (size_t) n);
+  memcpy(ivb, iv0, 8);
+  modes[m].fn(dc, ivb, buf, n);
+  bad += memcmp(buf, want, 8 * (size_t) n) != 0 || memcmp(ivb, ivw, 8) != 0;
+
+  cut = n ? (int) (md_rand() % (unsigned) (n + 1)) : 0;
+  memcpy(buf, in, 8 * (size_t) n);
+  memcpy(ivb, iv0, 8);
+  modes[m].fn(dc, ivb, buf, cut);
+  modes[m].fn(dc, ivb, buf + 8*cut, n - cut);
+  bad += memcmp(buf, want, 8 * (size_t) n) != 0 || memcmp(ivb, ivw, 8) != 0;
+  return bad;
+}
+
+static double md_rate(md_fn fn, des_ctx *dc, unsigned char *buf, int blocks,
+                      long passes) {
+  unsigned char iv[8] = {0};
+  double t0 = md_now();
+  long p;
+
+  for (p=0; p<passes; p++)
+    fn(dc, iv, buf, blocks);
+  return (double) passes * blocks / (md_now() - t0);
+}
+
+int main(int argc, char **argv) {
+  int blocks = 4096, trials = 200, opt, i, j, m, simd, max;
+  long passes = 200;
+  unsigned long mismatches = 0;
+  unsigned char key[8], *in, *want, *buf;
+  des_ctx dc;
+  double base, rate;
+
+  while ((opt = getopt(argc, argv, "b:r:n:s:")) != -1) {
+    switch (opt) {
+    case 'b': blocks = atoi(optarg); break;
+    case 'r': trials = atoi(optarg); break;
+    case 'n': passes = atol(optarg); break;
+    case 's': md_state = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-b blocks] [-r trials] [-n passes] [-s seed]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (blocks < 1)
+    blocks = 1;
+  max = blocks > MD_SHORT ? blocks : MD_SHORT;
+  in = malloc(8 * (size_t) max);
+  want = malloc(8 * (size_t) max);
+  buf = malloc(8 * (size_t) max);
+  if (in == NULL || want == NULL || buf == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  for (i=0; i<8; i++)
+    key[i] = (unsigned char) md_rand();
+  des_key(&dc, key);
+  for (i=0; i<8*max; i++)
+    in[i] = (unsigned char) md_rand();
+
+  printf("DES_INTERLEAVE %d, lengths 0..%d and %d up to %d blocks\n\n",
+         DES_INTERLEAVE, MD_SHORT, trials, max);
+  printf("%-8s %8s %8s\n", "mode", "scalar", "avx2");
+  for (m=0; m<(int) (sizeof(modes)/sizeof(modes[0])); m++) {
+    printf("%-8s", modes[m].name);
+    for (simd=0; simd<2; simd++) {
+      int bad = 0;
+
+      if (!des_simd_avx2(simd) && simd) {
+        printf(" %8s", "-");
+        continue;
+      }
+      for (i=0; i<=MD_SHORT; i++)
+        bad += md_check(m, &dc, in, want, buf, i);
+      for (j=0; j<trials; j++)
+        bad += md_check(m, &dc, in, want, buf,
+                        1 + (int) (md_rand() % (unsigned) max));
+      printf(" %8s", bad ? "MISMATCH" : "ok");
+      mismatches += bad;
+    }
+    printf("\n");
+  }
+
+  printf("\n%-8s %14s %14s %8s\n", "mode", "ref blk/s", "blk/s", "speedup");
+  des_simd_avx2(1);
+  for (m=0; m<(int) (sizeof(modes)/sizeof(modes[0])); m++) {
+    memcpy(buf, in, 8 * (size_t) blocks);
+    base = md_rate(modes[m].ref, &dc, buf, blocks, passes);
+    rate = md_rate(modes[m].fn, &dc, buf, blocks, passes);
+    printf("%-8s %14.0f %14.0f %7.2fx\n", modes[m].name, base, rate,
+           rate / base);
+  }
+  free(in);
+  free(want);
+  free(buf);
+  return mismatches != 0;
+}
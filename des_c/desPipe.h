@@ -0,0 +1,89 @@
+/* Cycle-accurate model of des_vhdl/des_pipe_top.vhd, the 16-stage
+ * pipelined core.  Like desCore.h, one pipe_clock() call is one rising
+ * edge and every register is updated from its pre-edge value:
+ *
+ *   key_schedule  K1..K16 (loaded from key_in on every non-reset edge)
+ *   stage 0       IP(data_in), valid = lddata, func = function_select
+ *   stage 1..15   L/R after that round, valid/func shifted along
+ *   output        data_out = FP(round 16), des_out_rdy = valid(15)
+ *
+ * Stage i uses K(i) for encryption and K(17-i) for decryption, chosen by
+ * the func bit that travels with the block.
+ *
+ * Header-only (static); include after des.c and desCore.h.
+ */
+
+#define PIPE_STAGES 16
+
+typedef struct {
+  /* inputs, sampled at the next rising edge */
+  uint64_t key_in;
+  uint64_t data_in;
+  int function_select;         /* 1 = encrypt, 0 = decrypt */
+  int lddata;
+  int reset;
+
+  /* outputs (registered, except core_busy) */
+  uint64_t data_out;
+  int des_out_rdy;
+  int core_busy;               /* any stage valid */
+
+  /* key_schedule */
+  unsigned long ks[32];
+  uint64_t ks_key;
+  int ks_valid;
+
+  /* stage registers */
+  uint32_t l[PIPE_STAGES], r[PIPE_STAGES];
+  int valid[PIPE_STAGES], func[PIPE_STAGES];
+
+  unsigned long long cycle;
+} des_pipe;
+
+static void pipe_init(des_pipe *p) {
+  memset(p, 0, sizeof(*p));
+}
+
+static void pipe_clock(des_pipe *p) {
+  uint32_t l_new, r_new, lr;
+  const unsigned long *k;
+  int i, busy = 0;
+
+  /* round 16 and FP, from the pre-edge stage 15 and K registers */
+  k = &p->ks[p->func[15] ? 30 : 0];
+  l_new = p->r[15];
+  r_new = p->l[15] ^ core_f(p->r[15], k);
+
+  if (p->reset) {
+    memset(p->valid, 0, sizeof(p->valid));
+    p->des_out_rdy = 0;
+  } else {
+    p->data_out = core_fp(l_new, r_new);
+    p->des_out_rdy = p->valid[15];
+
+    /* rounds 15..1, back to front so each stage reads its pre-edge input */
+    for (i=PIPE_STAGES-1; i>0; i--) {
+      k = &p->ks[p->func[i-1] ? 2*(i-1) : 2*(16-i)];
+      lr = p->l[i-1] ^ core_f(p->r[i-1], k);
+      p->l[i] = p->r[i-1];
+      p->r[i] = lr;
+      p->valid[i] = p->valid[i-1];
+      p->func[i] = p->func[i-1];
+    }
+    core_ip(p->data_in, &p->l[0], &p->r[0]);
+    p->valid[0] = p->lddata ? 1 : 0;
+    p->func[0] = p->function_select ? 1 : 0;
+
+    /* key_schedule loads after the rounds above used the old K */
+    if (!p->ks_valid || p->ks_key != p->key_in) {
+      core_expand(p->key_in, p->ks);
+      p->ks_key = p->key_in;
+      p->ks_valid = 1;
+    }
+  }
+
+  for (i=0; i<PIPE_STAGES; i++)
+    busy |= p->valid[i];
+  p->core_busy = busy;
+  p->cycle++;
+}
@@ -0,0 +1,244 @@
+/* Throughput runner for the pipelined core model (desPipe.h).  Streams
+ * blocks into the pipeline one per clock, checks every output against
+ * des_enc/des_dec in order, and compares with the iterative des_top
+ * (desCore.h) driven back to back.
+ *
+ *   gcc -O2 -pthread desPipeSim.c -o desPipeSim
+ *   ./desPipeSim [-n blocks] [-r rekey_every] [-g idle_percent]
+ *                [-M enc|dec|mix] [-s seed] [-o vectors] [-v]
+ *
+ *   -r  new random key every N blocks (default 0: one key); the pipeline
+ *       is drained before each key change, as des_pipe_top requires
+ *   -g  percentage of cycles on which no block is offered (default 0)
+ *   -M  function of each block (default enc; mix = random per block)
+ *   -o  also write the stream as "key func datain dataout" lines, the
+ *       input of des_vhdl/des_pipe_top_tb.vhd
+ *
+ * Reported: blocks, cycles, blocks/cycle, latency, cycles lost to key
+ * changes, and the speedup over the iterative core.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include "desCore.h"
+#include "desPipe.h"
+#include <unistd.h>
+#include <time.h>
+
+static unsigned long long sim_state = 0x9e3779b97f4a7c15ULL;
+static unsigned long long mismatches;
+static int verbose;
+
+static unsigned long long sim_rand(void) {
+  sim_state ^= sim_state << 13;
+  sim_state ^= sim_state >> 7;
+  sim_state ^= sim_state << 17;
+  return sim_state;
+}
+
+static uint64_t sw_des(uint64_t key, uint64_t data, int encrypt) {
+  static des_ctx dc;
+  static uint64_t dkey;
+  static int dvalid;
+  unsigned char kb[8], db[8];
+  uint64_t out = 0;
+  int i;
+
+  if (!dvalid || dkey != key) {
+    for (i=0; i<8; i++)
+      kb[i] = (unsigned char) (key >> (56 - 8*i));
+    des_key(&dc, kb);
+    dkey = key;
+    dvalid = 1;
+  }
+  for (i=0; i<8; i++)
+    db[i] = (unsigned char) (data >> (56 - 8*i));
+  if (encrypt)
+    des_enc(&dc, db, 1);
+  else
+    des_dec(&dc, db, 1);
+  for (i=0; i<8; i++)
+    out = (out << 8) | db[i];
+  return out;
+}
+
+/* Blocks in flight, oldest first; the pipeline never reorders. */
+typedef struct {
+  uint64_t key, data;
+  int func;
+  unsigned long long issued;
+} pipe_req;
+
+static pipe_req fifo[PIPE_STAGES + 2];
+static int fifo_head, fifo_len;
+static unsigned long long lat_sum, lat_min = ~0ULL, lat_max, done;
+static FILE *vec_out;
+
+static void pipe_step(des_pipe *p) {
+  pipe_req *q;
+  uint64_t want;
+  unsigned long long lat;
+
+  pipe_clock(p);
+  if (!p->des_out_rdy)
+    return;
+  if (fifo_len == 0) {
+    fprintf(stderr, "des_out_rdy with no block in flight at cycle %llu\n",
+            p->cycle);
+    mismatches++;
+    return;
+  }
+  q = &fifo[fifo_head];
+  fifo_head = (fifo_head + 1) % (PIPE_STAGES + 2);
+  fifo_len--;
+  want = sw_des(q->key, q->data, q->func);
+  lat = p->cycle - q->issued;
+  lat_sum += lat;
+  if (lat < lat_min) lat_min = lat;
+  if (lat > lat_max) lat_max = lat;
+  done++;
+  if (vec_out)
+    fprintf(vec_out, "%016llx %d %016llx %016llx\n",
+            (unsigned long long) q->key, q->func,
+            (unsigned long long) q->data, (unsigned long long) want);
+  if (verbose)
+    printf("cycle %8llu %s key=%016llx in=%016llx out=%016llx lat=%llu%s\n",
+           p->cycle, q->func ? "enc" : "dec", (unsigned long long) q->key,
+           (unsigned long long) q->data, (unsigned long long) p->data_out,
+           lat, p->data_out == want ? "" : "  MISMATCH");
+  if (p->data_out != want) {
+    if (mismatches < 10)
+      fprintf(stderr, "mismatch: %s key=%016llx in=%016llx hw=%016llx "
+              "sw=%016llx\n", q->func ? "enc" : "dec",
+              (unsigned long long) q->key, (unsigned long long) q->data,
+              (unsigned long long) p->data_out, (unsigned long long) want);
+    mismatches++;
+  }
+}
+
+static int pick_func(const char *mode) {
+  if (strcmp(mode, "dec") == 0)
+    return 0;
+  if (strcmp(mode, "mix") == 0)
+    return (int) (sim_rand() >> 63);
+  return 1;
+}
+
+/* Iterative core fed back to back (lddata held, next block as soon as
+   des_out_rdy is seen): cycles per block for the same kind of stream. */
+static double iterative_cycles(long blocks) {
+  des_core c;
+  long v;
+
+  core_init(&c);
+  c.reset = 1;
+  core_clock(&c);
+  c.reset = 0;
+  c.key_in = 0x133457799bbcdff1ULL;
+  c.function_select = 1;
+  c.lddata = 1;
+  for (v=0; v<blocks; v++) {
+    c.data_in = (uint64_t) v;
+    while (!c.des_out_rdy)
+      core_clock(&c);
+    core_clock(&c);
+  }
+  return (double) c.cycle / blocks;
+}
+
+int main(int argc, char **argv) {
+  const char *mode = "enc", *vecname = NULL;
+  long blocks = 1000000, rekey = 0, v;
+  int idle = 0, opt;
+  unsigned long long drain = 0, start;
+  uint64_t key;
+  des_pipe p;
+  pipe_req *q;
+  struct timespec t0, t1;
+  double sec, iter;
+
+  while ((opt = getopt(argc, argv, "n:r:g:M:s:o:v")) != -1) {
+    switch (opt) {
+    case 'n': blocks = atol(optarg); break;
+    case 'r': rekey = atol(optarg); break;
+    case 'g': idle = atoi(optarg); break;
+    case 'M': mode = optarg; break;
+    case 's': sim_state = strtoull(optarg, NULL, 0) | 1; break;
+    case 'o': vecname = optarg; break;
+    case 'v': verbose = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-n blocks] [-r rekey_every] "
+                      "[-g idle_percent] [-M enc|dec|mix] [-s seed] "
+                      "[-o vectors] [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (blocks <= 0) {
+    fprintf(stderr, "nothing to do\n");
+    return 2;
+  }
+  if (vecname) {
+    if ((vec_out = fopen(vecname, "w")) == NULL) {
+      perror(vecname);
+      return 1;
+    }
+    setvbuf(vec_out, NULL, _IOFBF, 1 << 20);
+    fprintf(vec_out, "# key func datain dataout\n");
+  }
+
+  pipe_init(&p);
+  p.reset = 1;
+  pipe_clock(&p);
+  p.reset = 0;
+  key = sim_rand();
+  p.key_in = key;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  start = p.cycle;
+  for (v=0; v<blocks; v++) {
+    if (rekey && v && v % rekey == 0) {
+      /* drain under the old key, then switch on the next block's edge */
+      p.lddata = 0;
+      while (p.core_busy) {
+        pipe_step(&p);
+        drain++;
+      }
+      key = sim_rand();
+      p.key_in = key;
+    }
+    while (idle && (int) (sim_rand() % 100) < idle) {
+      p.lddata = 0;
+      pipe_step(&p);
+    }
+    q = &fifo[(fifo_head + fifo_len) % (PIPE_STAGES + 2)];
+    q->key = key;
+    q->data = sim_rand();
+    q->func = pick_func(mode);
+    q->issued = p.cycle + 1;           /* edge that samples lddata */
+    fifo_len++;
+    p.data_in = q->data;
+    p.function_select = q->func;
+    p.lddata = 1;
+    pipe_step(&p);
+  }
+  p.lddata = 0;
+  while (p.core_busy || p.des_out_rdy)
+    pipe_step(&p);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  if (vec_out)
+    fclose(vec_out);
+
+  iter = iterative_cycles(blocks < 100000 ? blocks : 100000);
+  printf("blocks=%llu cycles=%llu blocks/cycle=%.4f cycles/block=%.3f\n",
+         done, p.cycle - start, (double) done / (p.cycle - start),
+         (double) (p.cycle - start) / done);
+  printf("latency min=%llu avg=%.2f max=%llu cycles, %llu cycles draining "
+         "for key changes\n", lat_min, (double) lat_sum / done, lat_max,
+         drain);
+  printf("iterative core: %.2f cycles/block -> speedup %.1fx\n", iter,
+         iter * done / (p.cycle - start));
+  printf("mismatches=%llu  (%.2f M blocks/s simulated)\n", mismatches,
+         done / sec / 1e6);
+  return mismatches || done != (unsigned long long) blocks ? 1 : 0;
+}
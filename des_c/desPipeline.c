@@ -0,0 +1,431 @@
+/* End-to-end file pipeline benchmark: read -> parse -> 3DES -> format ->
+ * write, over the files desCorpus.c generates (or the small ones in this
+ * directory).  It does what main() in des.c does for every key triple:
+ * encrypt Plaintextin.txt to hex lines in Ciphertextout<n>.txt, then
+ * decrypt the hex lines of Ciphertextin.txt into Plaintextout<n>.txt.
+ *
+ *   gcc -O2 -pthread desPipeline.c -o desPipeline
+ *   ./desPipeline [-p inprefix] [-o outprefix] [-k triples] [-B] [-L]
+ *
+ *   -p  input prefix, e.g. "big" for bigKey.txt etc. (default "")
+ *   -o  output prefix (default: discard output into /dev/null)
+ *   -k  only use the first N key triples (default all)
+ *   -B  read binary plaintext (<prefix>Plaintextin.bin, no text parsing)
+ *   -L  legacy loop: the getline/des_key-per-line/fprintf-per-byte
+ *       structure of main(), minus its console printing, for comparison
+ *
+ * The default path reads each file with one fread, parses with table
+ * lookups into a block array, keys each triple once, encrypts in
+ * cache-sized chunks, formats into one buffer and writes it with one
+ * fwrite.  Time is charged to each stage separately so the breakdown
+ * shows how much of the wall clock is the cipher.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+#include <time.h>
+
+#define PIPE_CHUNK 2048          /* blocks per cipher pass: 16KB, stays in L1/L2 */
+
+enum { ST_READ, ST_PARSE, ST_KEY, ST_CIPHER, ST_FORMAT, ST_WRITE, ST_COUNT };
+static const char *stage_name[ST_COUNT] = {
+  "read", "parse", "key setup", "3des", "format", "write"};
+static double stage_sec[ST_COUNT];
+
+static signed char hexval[256];
+static unsigned short hexpair[256];
+
+static double now_sec(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void pipe_tables(void) {
+  static const char hex[] = "0123456789abcdef";
+  int i;
+
+  memset(hexval, -1, sizeof(hexval));
+  for (i=0; i<10; i++)
+    hexval['0'+i] = i;
+  for (i=0; i<6; i++)
+    hexval['a'+i] = hexval['A'+i] = 10 + i;
+  /* two output characters per byte, in memory order */
+  for (i=0; i<256; i++)
+    hexpair[i] = (unsigned short) (hex[i >> 4] | (hex[i & 0xf] << 8));
+}
+
+static char *slurp(const char *path, size_t *len) {
+  FILE *fp;
+  char *buf;
+  long n;
+
+  if ((fp = fopen(path, "rb")) == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fseek(fp, 0, SEEK_END);
+  n = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  buf = malloc(n + 1);
+  if (buf == NULL || fread(buf, 1, n, fp) != (size_t) n) {
+    perror(path);
+    exit(1);
+  }
+  buf[n] = '\0';
+  fclose(fp);
+  *len = (size_t) n;
+  return buf;
+}
+
+static void spill(const char *path, const char *buf, size_t len) {
+  FILE *fp;
+
+  if ((fp = fopen(path, "wb")) == NULL) {
+    perror(path);
+    exit(1);
+  }
+  if (fwrite(buf, 1, len, fp) != len) {
+    perror(path);
+    exit(1);
+  }
+  fclose(fp);
+}
+
+/* Text records: up to 8 bytes before each newline, zero padded. */
+static long parse_text(const char *p, size_t len, unsigned char *out) {
+  const char *end = p + len, *nl;
+  long n = 0;
+  size_t w;
+
+  while (p < end) {
+    nl = memchr(p, '\n', end - p);
+    if (nl == NULL)
+      nl = end;
+    w = (size_t) (nl - p);
+    if (w > 8) w = 8;
+    memset(out + 8*n, 0, 8);
+    memcpy(out + 8*n, p, w);
+    n++;
+    p = nl + 1;
+  }
+  return n;
+}
+
+/* Hex records: 16 hex digits per line.  A record with anything else in
+   it is an error: reported against name, and -1 returned. */
+static long parse_hex(const char *p, size_t len, unsigned char *out,
+                      const char *name) {
+  const char *end = p + len;
+  long n = 0;
+  int j, hi, lo;
+
+  while (end - p >= 16) {
+    for (j=0; j<8; j++) {
+      hi = hexval[(unsigned char) p[2*j]];
+      lo = hexval[(unsigned char) p[2*j+1]];
+      if (hi < 0 || lo < 0) {
+        fprintf(stderr, "%s: record %ld: invalid hex digit\n", name, n+1);
+        return -1;
+      }
+      out[8*n+j] = (unsigned char) ((hi << 4) | lo);
+    }
+    n++;
+    p += 16;
+    while (p < end && (*p == '\n' || *p == '\r'))
+      p++;
+  }
+  return n;
+}
+
+static size_t format_hex(const unsigned char *blk, long n, char *out) {
+  char *o = out;
+  long i;
+  int j;
+
+  for (i=0; i<n; i++) {
+    for (j=0; j<8; j++, o+=2)
+      memcpy(o, &hexpair[blk[8*i+j]], 2);
+    *o++ = '\n';
+  }
+  return (size_t) (o - out);
+}
+
+static size_t format_text(const unsigned char *blk, long n, char *out) {
+  char *o = out;
+  long i;
+
+  for (i=0; i<n; i++) {
+    memcpy(o, blk + 8*i, 8);
+    o[8] = '\n';
+    o += 9;
+  }
+  return (size_t) (o - out);
+}
+
+static long count_lines(const char *p, size_t len) {
+  const char *end = p + len;
+  long n = 1;
+
+  while ((p = memchr(p, '\n', end - p)) != NULL) {
+    n++;
+    p++;
+  }
+  return n;
+}
+
+static void *grow(void *buf, size_t *cap, size_t need) {
+  if (need <= *cap)
+    return buf;
+  *cap = need + need / 2;
+  if ((buf = realloc(buf, *cap)) == NULL) {
+    perror("realloc");
+    exit(1);
+  }
+  return buf;
+}
+
+static void cipher3(des_ctx *dc, unsigned char *blk, long n, int decrypt) {
+  long off;
+  int c;
+
+  for (off=0; off<n; off+=PIPE_CHUNK) {
+    c = n - off < PIPE_CHUNK ? (int) (n - off) : PIPE_CHUNK;
+    if (decrypt) {
+      des_dec(&dc[2], blk + 8*off, c);
+      des_dec(&dc[1], blk + 8*off, c);
+      des_dec(&dc[0], blk + 8*off, c);
+    } else {
+      des_enc(&dc[0], blk + 8*off, c);
+      des_enc(&dc[1], blk + 8*off, c);
+      des_enc(&dc[2], blk + 8*off, c);
+    }
+  }
+}
+
+static void out_path(char *path, size_t sz, const char *prefix,
+                     const char *name, long n) {
+  if (prefix)
+    snprintf(path, sz, "%s%s%ld.txt", prefix, name, n);
+  else
+    snprintf(path, sz, "/dev/null");
+}
+
+static void run_fast(const char *inprefix, const char *outprefix,
+                     unsigned char (*keys)[24], long ntriples, int binary,
+                     long *nrec) {
+  char path[1024], *in, *out = NULL;
+  unsigned char *blk = NULL;
+  size_t len, olen, blkcap = 0, outcap = 0;
+  long t, n;
+  double t0;
+  des_ctx dc[3];
+  int p;
+
+  *nrec = 0;
+  for (t=0; t<ntriples; t++) {
+    t0 = now_sec();
+    for (p=0; p<3; p++)
+      des_key(&dc[p], keys[t] + 8*p);
+    stage_sec[ST_KEY] += now_sec() - t0;
+
+    /* encrypt */
+    t0 = now_sec();
+    snprintf(path, sizeof(path), "%sPlaintextin.%s", inprefix,
+             binary ? "bin" : "txt");
+    in = slurp(path, &len);
+    stage_sec[ST_READ] += now_sec() - t0;
+
+    t0 = now_sec();
+    n = binary ? (long) (len / 8) : count_lines(in, len);
+    blk = grow(blk, &blkcap, 8 * (size_t) n);
+    out = grow(out, &outcap, 17 * (size_t) n);
+    if (binary) {
+      n = (long) (len / 8);
+      memcpy(blk, in, 8*n);
+    } else {
+      n = parse_text(in, len, blk);
+    }
+    stage_sec[ST_PARSE] += now_sec() - t0;
+
+    t0 = now_sec();
+    cipher3(dc, blk, n, 0);
+    stage_sec[ST_CIPHER] += now_sec() - t0;
+
+    t0 = now_sec();
+    olen = format_hex(blk, n, out);
+    stage_sec[ST_FORMAT] += now_sec() - t0;
+
+    t0 = now_sec();
+    out_path(path, sizeof(path), outprefix, "Ciphertextout", t+1);
+    spill(path, out, olen);
+    stage_sec[ST_WRITE] += now_sec() - t0;
+    *nrec += n;
+    free(in);
+
+    /* decrypt */
+    t0 = now_sec();
+    snprintf(path, sizeof(path), "%sCiphertextin.txt", inprefix);
+    in = slurp(path, &len);
+    stage_sec[ST_READ] += now_sec() - t0;
+
+    t0 = now_sec();
+    n = count_lines(in, len);
+    blk = grow(blk, &blkcap, 8 * (size_t) n);
+    out = grow(out, &outcap, 17 * (size_t) n);
+    n = parse_hex(in, len, blk, path);
+    if (n < 0)
+      exit(1);
+    stage_sec[ST_PARSE] += now_sec() - t0;
+
+    t0 = now_sec();
+    cipher3(dc, blk, n, 1);
+    stage_sec[ST_CIPHER] += now_sec() - t0;
+
+    t0 = now_sec();
+    olen = format_text(blk, n, out);
+    stage_sec[ST_FORMAT] += now_sec() - t0;
+
+    t0 = now_sec();
+    out_path(path, sizeof(path), outprefix, "Plaintextout", t+1);
+    spill(path, out, olen);
+    stage_sec[ST_WRITE] += now_sec() - t0;
+    *nrec += n;
+    free(in);
+  }
+  free(blk);
+  free(out);
+}
+
+/* The loop structure of main(): line-at-a-time I/O, the whole key
+   schedule rebuilt for every block and every output byte formatted with
+   its own fprintf. */
+static void run_legacy(const char *inprefix, const char *outprefix,
+                       unsigned char (*keys)[24], long ntriples, long *nrec) {
+  char path[1024], *line = NULL;
+  unsigned char x[8];
+  size_t cap = 0;
+  ssize_t got;
+  FILE *in, *out;
+  des_ctx dc;
+  long t;
+  int i;
+
+  *nrec = 0;
+  for (t=0; t<ntriples; t++) {
+    snprintf(path, sizeof(path), "%sPlaintextin.txt", inprefix);
+    in = fopen(path, "r");
+    out_path(path, sizeof(path), outprefix, "Ciphertextout", t+1);
+    out = fopen(path, "w");
+    if (in == NULL || out == NULL) {
+      perror(path);
+      exit(1);
+    }
+    while ((got = getline(&line, &cap, in)) != -1) {
+      memcpy(x, line, sizeof(x));
+      for (i=0; i<3; i++) {
+        des_key(&dc, keys[t] + 8*i);
+        des_enc(&dc, x, 1);
+      }
+      for (i=0; i<8; i++)
+        fprintf(out, "%02x", x[i]);
+      fprintf(out, "\n");
+      (*nrec)++;
+    }
+    fclose(in);
+    fclose(out);
+
+    snprintf(path, sizeof(path), "%sCiphertextin.txt", inprefix);
+    in = fopen(path, "r");
+    out_path(path, sizeof(path), outprefix, "Plaintextout", t+1);
+    out = fopen(path, "w");
+    if (in == NULL || out == NULL) {
+      perror(path);
+      exit(1);
+    }
+    while ((got = getline(&line, &cap, in)) != -1) {
+      hexify(line, (char *) x);
+      for (i=2; i>=0; i--) {
+        des_key(&dc, keys[t] + 8*i);
+        des_dec(&dc, x, 1);
+      }
+      for (i=0; i<8; i++)
+        fprintf(out, "%c", x[i]);
+      fprintf(out, "\n");
+      (*nrec)++;
+    }
+    fclose(in);
+    fclose(out);
+  }
+  free(line);
+}
+
+int main(int argc, char **argv) {
+  const char *inprefix = "", *outprefix = NULL;
+  char path[1024], *line = NULL;
+  size_t cap = 0;
+  long maxtriples = -1, ntriples = 0, alloc = 0, nrec, i;
+  int binary = 0, legacy = 0, opt, p;
+  unsigned char (*keys)[24] = NULL;
+  double t0, wall, sum = 0;
+  FILE *fk;
+
+  while ((opt = getopt(argc, argv, "p:o:k:BL")) != -1) {
+    switch (opt) {
+    case 'p': inprefix = optarg; break;
+    case 'o': outprefix = optarg; break;
+    case 'k': maxtriples = atol(optarg); break;
+    case 'B': binary = 1; break;
+    case 'L': legacy = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-p inprefix] [-o outprefix] [-k triples] "
+                      "[-B] [-L]\n", argv[0]);
+      return 2;
+    }
+  }
+  pipe_tables();
+
+  snprintf(path, sizeof(path), "%sKey.txt", inprefix);
+  if ((fk = fopen(path, "r")) == NULL) {
+    perror(path);
+    return 1;
+  }
+  for (p=0; getline(&line, &cap, fk) != -1; p = (p + 1) % 3) {
+    if (p == 0) {
+      if (maxtriples >= 0 && ntriples == maxtriples)
+        break;
+      if (ntriples == alloc) {
+        alloc = alloc ? 2*alloc : 64;
+        keys = realloc(keys, alloc * sizeof(*keys));
+      }
+      memset(keys[ntriples++], 0, 24);
+    }
+    memcpy(keys[ntriples-1] + 8*p, line, strlen(line) < 8 ? strlen(line) : 8);
+  }
+  fclose(fk);
+  free(line);
+
+  t0 = now_sec();
+  if (legacy)
+    run_legacy(inprefix, outprefix, keys, ntriples, &nrec);
+  else
+    run_fast(inprefix, outprefix, keys, ntriples, binary, &nrec);
+  wall = now_sec() - t0;
+
+  printf("%s pipeline: %ld key triples, %ld records, %.3f s wall, "
+         "%.0f records/s\n", legacy ? "legacy" : "batched", ntriples, nrec,
+         wall, nrec / wall);
+  if (!legacy) {
+    for (i=0; i<ST_COUNT; i++) {
+      printf("  %-10s %9.3f s  %5.1f%%\n", stage_name[i], stage_sec[i],
+             100.0 * stage_sec[i] / wall);
+      sum += stage_sec[i];
+    }
+    printf("  %-10s %9.3f s  %5.1f%%\n", "other", wall - sum,
+           100.0 * (wall - sum) / wall);
+  }
+  free(keys);
+  return 0;
+}
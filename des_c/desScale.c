@@ -0,0 +1,296 @@
+/* Thread-scaling benchmark for the bulk ECB (des_enc) and CTR (des_ctr)
+ * paths.  For 1..N threads, each pinned to its own physical core, every
+ * thread streams over a private buffer for a fixed time.  Each thread
+ * count is run twice: once on a small cache-resident buffer (pure
+ * desfunc cost) and once on a large buffer that has to come from DRAM.
+ * When the DRAM figure falls behind the cache figure, the run has become
+ * memory-bandwidth bound rather than desfunc bound.  The "~membw" column
+ * is an estimate, not a measurement: twice the DRAM throughput, since
+ * the in-place pass reads and writes every byte once.
+ *
+ *   gcc -O2 -pthread desScale.c -o desScale
+ *   ./desScale [-t maxthreads] [-m MB_per_thread] [-s seconds] [-M ecb|ctr]
+ *              [-S]
+ *
+ *   -t  highest thread count (default: number of physical cores)
+ *   -m  streaming buffer per thread in MB (default 64)
+ *   -s  seconds per measurement (default 1.0)
+ *   -M  ecb or ctr (default ecb)
+ *   -S  spread threads across sockets instead of filling socket 0 first
+ *
+ * Topology comes from /sys/devices/system/cpu; one logical CPU is kept
+ * per (package, core) pair, so SMT siblings are never both used.
+ * Buffers are first touched by their (already pinned) thread so they are
+ * allocated on that thread's NUMA node.
+ */
+
+#define _GNU_SOURCE
+#define DES_NO_MAIN
+#include "des.c"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <ctype.h>
+
+#define MAX_CPUS    1024
+#define CACHE_BYTES (32 << 10)
+
+typedef struct {
+  int cpu;
+  int package;
+  int core;
+  int node;
+} scale_cpu;
+
+typedef struct {
+  int id;
+  int cpu;
+  size_t bytes;
+  int ctr;
+  double seconds;
+  des_ctx *dc;
+  pthread_barrier_t *start;
+  double done;             /* bytes processed */
+} scale_job;
+
+static scale_cpu cpus[MAX_CPUS];
+static int ncpus;
+
+static int read_int(const char *path) {
+  FILE *fp;
+  int v = -1;
+
+  if ((fp = fopen(path, "r")) == NULL)
+    return -1;
+  if (fscanf(fp, "%d", &v) != 1)
+    v = -1;
+  fclose(fp);
+  return v;
+}
+
+static int cpu_node(int cpu) {
+  char path[128];
+  DIR *d;
+  struct dirent *e;
+  int node = 0;
+
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+  if ((d = opendir(path)) == NULL)
+    return 0;
+  while ((e = readdir(d)) != NULL)
+    if (strncmp(e->d_name, "node", 4) == 0 && isdigit(e->d_name[4])) {
+      node = atoi(e->d_name + 4);
+      break;
+    }
+  closedir(d);
+  return node;
+}
+
+static int cmp_compact(const void *a, const void *b) {
+  const scale_cpu *x = a, *y = b;
+
+  if (x->package != y->package)
+    return x->package - y->package;
+  return x->core - y->core;
+}
+
+/* Collect one logical CPU per physical core, in the order threads will
+   be placed. */
+static void scan_topology(int spread) {
+  scale_cpu all[MAX_CPUS], tmp[MAX_CPUS];
+  cpu_set_t allowed;
+  char path[128];
+  int i, j, n = 0, npk = 0, dup;
+
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+  for (i=0; i<MAX_CPUS; i++) {
+    if (!CPU_ISSET(i, &allowed))
+      continue;
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", i);
+    all[n].package = read_int(path);
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/core_id", i);
+    all[n].core = read_int(path);
+    if (all[n].package < 0) all[n].package = 0;
+    if (all[n].core < 0) all[n].core = i;
+    all[n].cpu = i;
+    all[n].node = cpu_node(i);
+    dup = 0;
+    for (j=0; j<n; j++)
+      if (all[j].package == all[n].package && all[j].core == all[n].core)
+        dup = 1;
+    if (!dup)
+      n++;
+  }
+  qsort(all, n, sizeof(all[0]), cmp_compact);
+  ncpus = n;
+  if (!spread) {
+    memcpy(cpus, all, n * sizeof(all[0]));
+    return;
+  }
+
+  /* round-robin over packages */
+  for (i=0; i<n; i++)
+    if (i == 0 || all[i].package != all[i-1].package)
+      npk++;
+  memcpy(tmp, all, n * sizeof(all[0]));
+  for (i=0, j=0; j<n; i++) {
+    int pk, k, want = i % npk, seen = -1;
+
+    for (k=0, pk=-1; k<n; k++) {
+      if (k == 0 || tmp[k].package != tmp[k-1].package)
+        seen++;
+      if (seen == want && tmp[k].cpu >= 0) {
+        pk = k;
+        break;
+      }
+    }
+    if (pk < 0)
+      continue;
+    cpus[j++] = tmp[pk];
+    tmp[pk].cpu = -1;
+  }
+}
+
+static double now_sec(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *scale_worker(void *arg) {
+  scale_job *job = arg;
+  cpu_set_t set;
+  unsigned char *buf, ctr[8];
+  int blocks = (int) (job->bytes / 8), chunk = 4096, off;
+  double t0, bytes = 0;
+
+  CPU_ZERO(&set);
+  CPU_SET(job->cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+  /* first touch after pinning: pages land on this core's node */
+  buf = malloc(job->bytes);
+  if (buf == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  memset(buf, job->id, job->bytes);
+  memset(ctr, 0, sizeof(ctr));
+  ctr[0] = (unsigned char) job->id;
+  if (chunk > blocks)
+    chunk = blocks;
+
+  pthread_barrier_wait(job->start);
+  t0 = now_sec();
+  do {
+    for (off=0; off+chunk<=blocks; off+=chunk) {
+      if (job->ctr)
+        des_ctr(job->dc, ctr, buf + 8L*off, chunk);
+      else
+        des_enc(job->dc, buf + 8L*off, chunk);
+      bytes += 8.0 * chunk;
+    }
+  } while (now_sec() - t0 < job->seconds);
+  job->done = bytes / (now_sec() - t0);
+  free(buf);
+  return NULL;
+}
+
+/* Returns aggregate bytes/s; per-package bytes/s go to bypkg. */
+static double run_point(int nthreads, size_t bytes, int ctr, double seconds,
+                        des_ctx *dc, double *bypkg) {
+  pthread_t tid[MAX_CPUS];
+  scale_job job[MAX_CPUS];
+  pthread_barrier_t start;
+  double total = 0;
+  int i;
+
+  pthread_barrier_init(&start, NULL, nthreads);
+  for (i=0; i<nthreads; i++) {
+    job[i].id = i;
+    job[i].cpu = cpus[i].cpu;
+    job[i].bytes = bytes;
+    job[i].ctr = ctr;
+    job[i].seconds = seconds;
+    job[i].dc = dc;
+    job[i].start = &start;
+    job[i].done = 0;
+    pthread_create(&tid[i], NULL, scale_worker, &job[i]);
+  }
+  for (i=0; i<nthreads; i++) {
+    pthread_join(tid[i], NULL);
+    total += job[i].done;
+    bypkg[cpus[i].package] += job[i].done;
+  }
+  pthread_barrier_destroy(&start);
+  return total;
+}
+
+int main(int argc, char **argv) {
+  int maxthreads = 0, ctr = 0, spread = 0, opt, n, i, maxpkg = 0;
+  size_t mbytes = 64;
+  double seconds = 1.0, base_mem = 0;
+  double cache, mem, bypkg[MAX_CPUS], dummy[MAX_CPUS];
+  unsigned char key[8] = {0x62, 0x6c, 0x69, 0x7a, 0x7a, 0x61, 0x72, 0x64};
+  des_ctx dc;
+
+  while ((opt = getopt(argc, argv, "t:m:s:M:S")) != -1) {
+    switch (opt) {
+    case 't': maxthreads = atoi(optarg); break;
+    case 'm':
+      if (atol(optarg) < 1) {
+        fprintf(stderr, "-m needs at least 1 MB per thread\n");
+        return 2;
+      }
+      mbytes = (size_t) atol(optarg);
+      break;
+    case 's': seconds = atof(optarg); break;
+    case 'M': ctr = strcmp(optarg, "ctr") == 0; break;
+    case 'S': spread = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-t maxthreads] [-m MB_per_thread] "
+                      "[-s seconds] [-M ecb|ctr] [-S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  scan_topology(spread);
+  if (maxthreads <= 0 || maxthreads > ncpus)
+    maxthreads = ncpus;
+  for (i=0; i<ncpus; i++)
+    if (cpus[i].package > maxpkg)
+      maxpkg = cpus[i].package;
+  des_key(&dc, key);
+
+  printf("%d physical cores, mode=%s, %zu MB/thread streaming, %d KB/thread "
+         "cached, %s placement\n", ncpus, ctr ? "ctr" : "ecb", mbytes,
+         CACHE_BYTES >> 10, spread ? "spread" : "compact");
+  printf("  cpu list:");
+  for (i=0; i<maxthreads; i++)
+    printf(" %d(pkg%d/node%d)", cpus[i].cpu, cpus[i].package, cpus[i].node);
+  printf("\n\n%7s %12s %12s %8s %8s %12s %s\n", "threads", "cache MB/s",
+         "dram MB/s", "eff", "dram/c", "~membw MB/s", "per-socket MB/s");
+
+  for (n=1; n<=maxthreads; n++) {
+    memset(dummy, 0, sizeof(dummy));
+    memset(bypkg, 0, sizeof(bypkg));
+    cache = run_point(n, CACHE_BYTES, ctr, seconds, &dc, dummy) / 1e6;
+    mem = run_point(n, mbytes << 20, ctr, seconds, &dc, bypkg) / 1e6;
+    if (n == 1)
+      base_mem = mem;
+    /* not measured: in-place, every byte is read once and written once,
+       so the DRAM traffic is estimated as twice the throughput */
+    printf("%7d %12.1f %12.1f %7.1f%% %7.1f%% %12.1f ", n, cache, mem,
+           100.0 * mem / (n * base_mem), 100.0 * mem / cache, 2.0 * mem);
+    for (i=0; i<=maxpkg; i++)
+      printf(" s%d=%.1f", i, bypkg[i] / 1e6);
+    printf("%s\n", mem < 0.9 * cache ? "  <- bandwidth-bound" : "");
+  }
+  return 0;
+}
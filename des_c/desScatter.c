@@ -0,0 +1,216 @@
+/* Check and time the scatter/gather API against contiguous des_enc.
+ * Each trial cuts a random-length message into random fragments (empty
+ * ones included, blocks straddling fragment edges), with guard bytes
+ * between fragments, and checks
+ *
+ *   encv, decv         in place       vs  des_enc / the plaintext
+ *   encv_to, decv_to   src != dst, each cut differently
+ *   -1 returns         a total that is not whole blocks, a short dst
+ *
+ * and that no guard byte was written.  Then des_encv is timed on one
+ * fragment and on random fragments against des_enc on the same bytes.
+ *
+ *   gcc -O2 -pthread desScatter.c -o desScatter
+ *   ./desScatter [-b blocks] [-r trials] [-n passes] [-s seed]
+ *
+ *   -b  largest message in blocks (default 4096)
+ *   -r  random fragmentations checked (default 2000)
+ *   -n  timed passes over a -b block message (default 200)
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+#include <time.h>
+
+#define SC_GUARD 0xa5                    /* fill between fragments */
+#define SC_GAP   7                       /* most guard bytes per gap */
+
+static unsigned long long sc_state = 0x510e527fade682d1ULL;
+
+static unsigned long long sc_rand(void) {
+  sc_state ^= sc_state << 13;
+  sc_state ^= sc_state >> 7;
+  sc_state ^= sc_state << 17;
+  return sc_state;
+}
+
+static double sc_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Cut len bytes into at most max fragments laid out in pool (guard-
+   filled, len + max*SC_GAP bytes) with a random gap before each.  Mostly
+   short fragments so blocks straddle edges; now and then a long one so
+   the whole-block runs are exercised too.  Returns the fragment count. */
+static int sc_cut(struct iovec *v, int max, unsigned char *pool,
+                  size_t len) {
+  size_t off = 0, k;
+  int n = 0;
+
+  while (len > 0) {
+    off += sc_rand() % (SC_GAP + 1);
+    switch (sc_rand() % 4) {
+    case 0:  k = 0; break;
+    case 1:  k = sc_rand() % (len + 1); break;
+    default: k = 1 + sc_rand() % 20; break;
+    }
+    if (k > len || n == max - 1)
+      k = len;
+    v[n].iov_base = pool + off;
+    v[n].iov_len = k;
+    n++;
+    off += k;
+    len -= k;
+  }
+  return n;
+}
+
+static void sc_fill(struct iovec *v, int n, const unsigned char *from) {
+  for (; n>0; n--, v++) {
+    memcpy(v->iov_base, from, v->iov_len);
+    from += v->iov_len;
+  }
+}
+
+/* 1 unless the fragments hold want and the pool outside them is guard */
+static int sc_check(const struct iovec *v, int n, const unsigned char *pool,
+                    size_t poolsize, const unsigned char *want) {
+  const unsigned char *p = pool;
+  size_t i;
+
+  for (; n>0; n--, v++) {
+    for (; p<(const unsigned char *) v->iov_base; p++)
+      if (*p != SC_GUARD)
+        return 1;
+    if (memcmp(v->iov_base, want, v->iov_len) != 0)
+      return 1;
+    want += v->iov_len;
+    p += v->iov_len;
+  }
+  for (i=p-pool; i<poolsize; i++)
+    if (pool[i] != SC_GUARD)
+      return 1;
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int blocks = 4096, trials = 2000, opt, i, t, ns, nd, max, bad;
+  long passes = 200, p;
+  unsigned long mismatches = 0;
+  unsigned char key[8], *in, *want, *src, *dst;
+  struct iovec *vs, *vd;
+  size_t len, poolsize;
+  des_ctx dc;
+  double t0, base, rate;
+
+  while ((opt = getopt(argc, argv, "b:r:n:s:")) != -1) {
+    switch (opt) {
+    case 'b': blocks = atoi(optarg); break;
+    case 'r': trials = atoi(optarg); break;
+    case 'n': passes = atol(optarg); break;
+    case 's': sc_state = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-b blocks] [-r trials] [-n passes] [-s seed]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (blocks < 1)
+    blocks = 1;
+  max = 8 * blocks + 8;
+  poolsize = (size_t) max * (1 + SC_GAP);
+  in = malloc(max);
+  want = malloc(max);
+  src = malloc(poolsize);
+  dst = malloc(poolsize);
+  vs = malloc(max * sizeof(*vs));
+  vd = malloc(max * sizeof(*vd));
+  if (in == NULL || want == NULL || src == NULL || dst == NULL ||
+      vs == NULL || vd == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  for (i=0; i<8; i++)
+    key[i] = (unsigned char) sc_rand();
+  des_key(&dc, key);
+  for (i=0; i<max; i++)
+    in[i] = (unsigned char) sc_rand();
+
+  for (bad=0, t=0; t<trials; t++) {
+    int n = 1 + (int) (sc_rand() % (unsigned) blocks);
+
+    len = 8 * (size_t) n;
+    memcpy(want, in, len);
+    des_enc(&dc, want, n);
+
+    /* in place */
+    memset(src, SC_GUARD, poolsize);
+    ns = sc_cut(vs, max, src, len);
+    sc_fill(vs, ns, in);
+    bad += des_encv(&dc, vs, ns) != n;
+    bad += sc_check(vs, ns, src, poolsize, want);
+    bad += des_decv(&dc, vs, ns) != n;
+    bad += sc_check(vs, ns, src, poolsize, in);
+
+    /* src to dst, cut differently */
+    memset(dst, SC_GUARD, poolsize);
+    nd = sc_cut(vd, max, dst, len);
+    bad += des_encv_to(&dc, vs, ns, vd, nd) != n;
+    bad += sc_check(vs, ns, src, poolsize, in);
+    bad += sc_check(vd, nd, dst, poolsize, want);
+    bad += des_decv_to(&dc, vd, nd, vs, ns) != n;
+    bad += sc_check(vs, ns, src, poolsize, in);
+
+    /* rejected: a ragged total, and a dst one byte short */
+    memset(dst, SC_GUARD, poolsize);
+    nd = sc_cut(vd, max, dst, len + 1 + sc_rand() % 7);
+    bad += des_encv(&dc, vd, nd) != -1;
+    nd = sc_cut(vd, max, dst, len - 1);
+    bad += des_encv_to(&dc, vs, ns, vd, nd) != -1;
+    bad += sc_check(vd, 0, dst, poolsize, NULL);
+  }
+  printf("%d fragmentations: %s\n\n", trials, bad ? "MISMATCH" : "ok");
+  mismatches += bad;
+
+  /* one fragment, then a random cut, against des_enc on the same bytes */
+  len = 8 * (size_t) blocks;
+  printf("%-8s %14s %14s %8s\n", "iov", "des_enc blk/s", "encv blk/s",
+         "speedup");
+  for (t=0; t<2; t++) {
+    memset(src, SC_GUARD, poolsize);
+    if (t == 0) {
+      vs[0].iov_base = src;
+      vs[0].iov_len = len;
+      ns = 1;
+    } else
+      ns = sc_cut(vs, max, src, len);
+    sc_fill(vs, ns, in);
+    memcpy(want, in, len);
+    t0 = sc_now();
+    for (p=0; p<passes; p++)
+      des_enc(&dc, want, blocks);
+    base = (double) passes * blocks / (sc_now() - t0);
+    t0 = sc_now();
+    for (p=0; p<passes; p++)
+      des_encv(&dc, vs, ns);
+    rate = (double) passes * blocks / (sc_now() - t0);
+    bad = sc_check(vs, ns, src, poolsize, want);
+    printf("%-8s %14.0f %14.0f %7.2fx %s\n", t == 0 ? "1 frag" : "random",
+           base, rate, rate / base, bad ? "MISMATCH" : "ok");
+    mismatches += bad;
+  }
+  printf("(random: %d fragments)\n", ns);
+
+  free(in);
+  free(want);
+  free(src);
+  free(dst);
+  free(vs);
+  free(vd);
+  return mismatches != 0;
+}
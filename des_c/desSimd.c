@@ -0,0 +1,257 @@
+/* Batch-size sweep for the AVX2 kernel behind des_enc/des_dec.  Each
+ * batch size is timed with the AVX2 path on and off (off = the
+ * interleaved scalar kernel, DES_INTERLEAVE blocks per call), over
+ * many separate batches so small sizes pay their real call overhead.
+ * Both paths must match the one-block reference (scrunch, desfunc,
+ * unscrun per block).  des_ctr and des_cbc_dec, which batch through the
+ * same kernel, are checked against one-block references the same way
+ * and timed on and off.  Then des_key is timed with the BMI2 key
+ * schedule on and off, and the schedules compared.
+ *
+ *   gcc -O2 -pthread desSimd.c -o desSimd
+ *   ./desSimd [-t total_blocks] [-d] [-s seed]
+ *
+ *   -t  blocks per measurement (default 1 << 20)
+ *   -d  time des_dec instead of des_enc
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+#include <time.h>
+
+#define SIMD_BUF (1 << 16)               /* blocks in the work buffer */
+
+static unsigned long long sd_state = 0x3c6ef372fe94f82bULL;
+
+static unsigned long long sd_rand(void) {
+  sd_state ^= sd_state << 13;
+  sd_state ^= sd_state >> 7;
+  sd_state ^= sd_state << 17;
+  return sd_state;
+}
+
+static double sd_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* One block at a time through desfunc(), the reference for ECB. */
+static void sd_ref(unsigned long *keys, unsigned char *cp, int n) {
+  unsigned long work[2];
+
+  for (; n>0; n--, cp+=8) {
+    scrunch(cp, work);
+    desfunc(work, keys);
+    unscrun(work, cp);
+  }
+}
+
+static void sd_ref_ctr(des_ctx *dc, unsigned char *ctr, unsigned char *cp,
+                       int n) {
+  unsigned char ks[8];
+  int j;
+
+  for (; n>0; n--, cp+=8) {
+    memcpy(ks, ctr, 8);
+    sd_ref(dc->ek, ks, 1);
+    for (j=0; j<8; j++)
+      cp[j] ^= ks[j];
+    for (j=7; j>=0; j--)
+      if (++ctr[j] != 0)
+        break;
+  }
+}
+
+static void sd_ref_cbc_dec(des_ctx *dc, unsigned char *iv, unsigned char *cp,
+                           int n) {
+  unsigned char c[8];
+  int j;
+
+  for (; n>0; n--, cp+=8) {
+    memcpy(c, cp, 8);
+    sd_ref(dc->dk, cp, 1);
+    for (j=0; j<8; j++)
+      cp[j] ^= iv[j];
+    memcpy(iv, c, 8);
+  }
+}
+
+typedef void (*sd_mode)(des_ctx *, unsigned char *, unsigned char *, int);
+
+/* A mode with the AVX2 kernel off and on against its reference, for each
+   batch size; then both timed over 4096-block batches. */
+static unsigned long sd_modes(const char *name, sd_mode fn, sd_mode ref,
+                              des_ctx *dc, unsigned char *buf,
+                              unsigned char *a, unsigned char *b,
+                              unsigned char *r, const int *batches,
+                              int nbatches, long total) {
+  unsigned char iv0[8], iva[8], ivb[8], ivr[8];
+  unsigned long bad = 0;
+  double t0, off, on;
+  long done;
+  int i, k, n;
+
+  for (i=0; i<nbatches; i++) {
+    n = batches[i];
+    for (k=0; k<8; k++)
+      iv0[k] = (unsigned char) sd_rand();
+    iv0[7] = (unsigned char) (0xff - n/2);   /* counter carries mid-batch */
+    memcpy(a, buf, 8 * (size_t) n);
+    memcpy(b, buf, 8 * (size_t) n);
+    memcpy(r, buf, 8 * (size_t) n);
+    memcpy(iva, iv0, 8);
+    memcpy(ivb, iv0, 8);
+    memcpy(ivr, iv0, 8);
+    ref(dc, ivr, r, n);
+    des_simd_avx2(0);
+    fn(dc, iva, a, n);
+    des_simd_avx2(1);
+    fn(dc, ivb, b, n);
+    bad += memcmp(a, r, 8 * (size_t) n) != 0 || memcmp(iva, ivr, 8) != 0;
+    bad += memcmp(b, r, 8 * (size_t) n) != 0 || memcmp(ivb, ivr, 8) != 0;
+  }
+  memcpy(iva, iv0, 8);
+  des_simd_avx2(0);
+  t0 = sd_now();
+  for (done=0; done<total; done+=4096)
+    fn(dc, iva, a, 4096);
+  off = done / (sd_now() - t0);
+  des_simd_avx2(1);
+  t0 = sd_now();
+  for (done=0; done<total; done+=4096)
+    fn(dc, iva, a, 4096);
+  on = done / (sd_now() - t0);
+  printf("%6s %14.0f %14.0f %7.2fx %s\n", name, off, on, on / off,
+         bad ? "MISMATCH" : "ok");
+  return bad;
+}
+
+static double sd_rate(des_ctx *dc, int decrypt, unsigned char *buf,
+                      int batch, long total) {
+  double t0 = sd_now();
+  long done;
+  int off = 0;
+
+  for (done=0; done<total; done+=batch) {
+    if (off + batch > SIMD_BUF)
+      off = 0;
+    if (decrypt)
+      des_dec(dc, buf + 8*off, batch);
+    else
+      des_enc(dc, buf + 8*off, batch);
+    off += batch;
+  }
+  return (double) done / (sd_now() - t0);
+}
+
+int main(int argc, char **argv) {
+  static const int batches[] = {1, 4, 8, 12, 16, 24, 32, 64, 256, 4096};
+  long total = 1L << 20;
+  int decrypt = 0, opt, i, bad;
+  unsigned long mismatches = 0;
+  unsigned char key[8], *buf, *a, *b, *r;
+  des_ctx dc;
+  double off, on;
+
+  while ((opt = getopt(argc, argv, "t:ds:")) != -1) {
+    switch (opt) {
+    case 't': total = atol(optarg); break;
+    case 'd': decrypt = 1; break;
+    case 's': sd_state = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-t total_blocks] [-d] [-s seed]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (!des_simd_avx2(-1)) {
+    fprintf(stderr, "no AVX2 on this CPU or in this build\n");
+    return 1;
+  }
+  buf = malloc(8 * (size_t) SIMD_BUF);
+  a = malloc(8 * 4096);
+  b = malloc(8 * 4096);
+  r = malloc(8 * 4096);
+  if (buf == NULL || a == NULL || b == NULL || r == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  for (i=0; i<8; i++)
+    key[i] = (unsigned char) sd_rand();
+  des_key(&dc, key);
+  for (i=0; i<8*SIMD_BUF; i++)
+    buf[i] = (unsigned char) sd_rand();
+
+  printf("%6s %14s %14s %8s\n", "batch", "scalar blk/s", "avx2 blk/s",
+         "speedup");
+  for (i=0; i<(int) (sizeof(batches)/sizeof(batches[0])); i++) {
+    int n = batches[i];
+
+    memcpy(a, buf, 8 * (size_t) n);
+    memcpy(b, buf, 8 * (size_t) n);
+    memcpy(r, buf, 8 * (size_t) n);
+    sd_ref(decrypt ? dc.dk : dc.ek, r, n);
+    des_simd_avx2(0);
+    (decrypt ? des_dec : des_enc)(&dc, a, n);
+    off = sd_rate(&dc, decrypt, buf, n, total);
+    des_simd_avx2(1);
+    (decrypt ? des_dec : des_enc)(&dc, b, n);
+    on = sd_rate(&dc, decrypt, buf, n, total);
+    bad = memcmp(a, r, 8 * (size_t) n) != 0 ||
+          memcmp(b, r, 8 * (size_t) n) != 0;
+    printf("%6d %14.0f %14.0f %7.2fx %s\n", n, off, on, on / off,
+           bad ? "MISMATCH" : "ok");
+    mismatches += bad;
+  }
+
+  printf("\n%6s %14s %14s %8s\n", "mode", "scalar blk/s", "avx2 blk/s",
+         "speedup");
+  mismatches += sd_modes("ctr", des_ctr, sd_ref_ctr, &dc, buf, a, b, r,
+                         batches, sizeof(batches)/sizeof(batches[0]), total);
+  mismatches += sd_modes("cbcdec", des_cbc_dec, sd_ref_cbc_dec, &dc, buf,
+                         a, b, r, batches,
+                         sizeof(batches)/sizeof(batches[0]), total);
+
+  /* rekeying: BMI2 schedule against deskey_std */
+  if (des_simd_bmi2(-1)) {
+    des_ctx ref;
+    long k, keys = total / 8;
+
+    for (bad=0, k=0; k<4096; k++) {
+      for (i=0; i<8; i++)
+        key[i] = (unsigned char) sd_rand();
+      des_simd_bmi2(0);
+      des_key(&ref, key);
+      des_simd_bmi2(1);
+      des_key(&dc, key);
+      bad += memcmp(&ref, &dc, sizeof(dc)) != 0;
+    }
+    des_simd_bmi2(0);
+    on = sd_now();
+    for (k=0; k<keys; k++) {
+      key[k & 7] ^= (unsigned char) k;
+      des_key(&dc, key);
+    }
+    off = keys / (sd_now() - on);
+    des_simd_bmi2(1);
+    on = sd_now();
+    for (k=0; k<keys; k++) {
+      key[k & 7] ^= (unsigned char) k;
+      des_key(&dc, key);
+    }
+    on = keys / (sd_now() - on);
+    printf("\n%6s %14s %14s %8s\n", "", "std keys/s", "bmi2 keys/s",
+           "speedup");
+    printf("%6s %14.0f %14.0f %7.2fx %s\n", "rekey", off, on, on / off,
+           bad ? "MISMATCH" : "ok");
+    mismatches += bad;
+  }
+  free(buf);
+  free(a);
+  free(b);
+  free(r);
+  return mismatches != 0;
+}
@@ -0,0 +1,146 @@
+/* Cycle-accurate model of des_vhdl/tdes_cipher_top.vhd (tdes_top with
+ * three key_schedule instances).  Conventions as in desCore.h: one
+ * tdes_clock() call is one rising edge, registers update from their
+ * pre-edge values, VHDL bit 0 is the uint64 MSB.
+ *
+ *   WaitData    IP(data_in_internal), latch function_select
+ *   Rounds      48 clocks; after round 16 of stages 1 and 2 the halves
+ *               are swapped into the next stage (FP and IP cancel)
+ *   FinalRound  des_out_rdy pulse, then straight back to WaitData
+ *
+ * ede selects TDES_EDE: encrypt E(K1) D(K2) E(K3), decrypt D(K3) E(K2)
+ * D(K1); otherwise every stage runs in the direction of function_select.
+ *
+ * Header-only (static); include after des.c and desCore.h.
+ */
+
+enum tdes_state { TWaitKey, TWaitData, TRounds, TFinalRound };
+
+typedef struct {
+  /* inputs, sampled at the next rising edge */
+  uint64_t key_in[3];
+  uint64_t data_in;
+  int function_select;         /* 1 = encrypt, 0 = decrypt */
+  int lddata;
+  int reset;
+  int ede;                     /* generic TDES_EDE */
+
+  /* outputs (registered) */
+  uint64_t data_out;
+  int core_busy;
+  int des_out_rdy;
+
+  /* tdes_cipher_top */
+  uint64_t data_in_internal;
+  int data_ready_internal;
+
+  /* three key_schedules */
+  unsigned long ks[3][32];
+  uint64_t ks_key[3];
+  int ks_valid[3];
+  int key_ready;
+
+  /* tdes_top */
+  enum tdes_state state;
+  unsigned int round_counter;  /* 4 bits */
+  unsigned int stage_counter;  /* 0..2 */
+  unsigned int key_select;     /* 4 bits */
+  int func;                    /* FuncLatched */
+  uint32_t l_in, r_in;
+
+  unsigned long long cycle;
+} tdes_core;
+
+static void tdes_init(tdes_core *c, int ede) {
+  memset(c, 0, sizeof(*c));
+  c->state = TWaitKey;
+  c->ede = ede;
+}
+
+/* Direction of stage s for the block in flight. */
+static int tdes_stage_func(const tdes_core *c, unsigned int s) {
+  return c->func ^ (c->ede && s == 1);
+}
+
+static void tdes_clock(tdes_core *c) {
+  /* combinational paths, from the pre-edge register values */
+  unsigned int s = c->stage_counter;
+  int kn = s == 1 ? 1 : ((s == 0) == (c->func != 0) ? 0 : 2);
+  const unsigned long *kout = &c->ks[kn][2 * c->key_select];
+  uint32_t l_out = c->r_in;
+  uint32_t r_out = c->l_in ^ core_f(c->r_in, kout);
+  int data_ready = c->data_ready_internal;
+  int key_ready = c->key_ready;
+  int i;
+
+  /* input register */
+  if (c->lddata)
+    c->data_in_internal = c->data_in;
+  c->data_ready_internal = c->lddata ? 1 : 0;
+
+  /* key_schedules */
+  if (c->reset) {
+    c->key_ready = 0;
+  } else {
+    for (i=0; i<3; i++)
+      if (!c->ks_valid[i] || c->ks_key[i] != c->key_in[i]) {
+        core_expand(c->key_in[i], c->ks[i]);
+        c->ks_key[i] = c->key_in[i];
+        c->ks_valid[i] = 1;
+      }
+    c->key_ready = 1;
+  }
+
+  /* tdes_top FSM */
+  if (c->reset) {
+    c->state = TWaitKey;
+    c->round_counter = 0;
+    c->stage_counter = 0;
+    c->core_busy = 0;
+    c->des_out_rdy = 0;
+  } else {
+    switch (c->state) {
+    case TWaitKey:
+      c->state = key_ready ? TWaitData : TWaitKey;
+      c->core_busy = 0;
+      c->des_out_rdy = 0;
+      break;
+    case TWaitData:
+      if (data_ready) {
+        c->core_busy = 1;
+        core_ip(c->data_in_internal, &c->l_in, &c->r_in);
+        c->func = c->function_select ? 1 : 0;
+        c->stage_counter = 0;
+        c->round_counter = 0;
+        c->key_select = c->function_select ? 0 : 15;
+        c->state = TRounds;
+      }
+      break;
+    case TRounds:
+      if (c->round_counter != 0xf) {
+        c->l_in = l_out;
+        c->r_in = r_out;
+        c->key_select = (c->key_select + (tdes_stage_func(c, s) ? 1 : 15)) & 0xf;
+      } else if (s != 2) {
+        c->l_in = r_out;
+        c->r_in = l_out;
+        c->stage_counter = s + 1;
+        c->key_select = tdes_stage_func(c, s + 1) ? 0 : 15;
+      } else {
+        c->data_out = core_fp(l_out, r_out);
+        c->core_busy = 0;
+        c->des_out_rdy = 1;
+        c->state = TFinalRound;
+      }
+      c->round_counter = (c->round_counter + 1) & 0xf;
+      break;
+    case TFinalRound:
+      c->round_counter = 0;
+      c->stage_counter = 0;
+      c->state = TWaitData;
+      c->des_out_rdy = 0;
+      break;
+    }
+  }
+  c->cycle++;
+}
@@ -0,0 +1,198 @@
+/* Vector generator and runner for the triple-DES top (desTdes.h model of
+ * des_vhdl/tdes_cipher_top.vhd).  Every block the model produces is
+ * checked against des_enc/des_dec chained in software, and the cycle
+ * count is compared with three reset-and-rekey des_cipher_top operations
+ * per block, the way des_cipher_top_tb.vhd drives triple DES.
+ *
+ *   gcc -O2 -pthread desTdesSim.c -o desTdesSim
+ *   ./desTdesSim [-n blocks] [-m ede|eee] [-M enc|dec|mix]
+ *                [-r rekey_every] [-s seed] [-o vectors] [-v]
+ *
+ *   -m  stage order, the TDES_EDE generic (default ede)
+ *   -M  function of each block (default mix: random per block)
+ *   -r  new random key triple every N blocks (default 1: every block);
+ *       keys change between blocks with no reset
+ *   -o  write "key1 key2 key3 func datain dataout" lines, the input of
+ *       des_vhdl/tdes_cipher_top_tb.vhd
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include "desCore.h"
+#include "desTdes.h"
+#include <unistd.h>
+#include <time.h>
+
+#define SIM_TIMEOUT 128         /* cycles without des_out_rdy = lost */
+
+static unsigned long long sim_state = 0x9e3779b97f4a7c15ULL;
+
+static unsigned long long sim_rand(void) {
+  sim_state ^= sim_state << 13;
+  sim_state ^= sim_state >> 7;
+  sim_state ^= sim_state << 17;
+  return sim_state;
+}
+
+static uint64_t sw_des(uint64_t key, uint64_t data, int encrypt) {
+  unsigned char kb[8], db[8];
+  uint64_t out = 0;
+  des_ctx dc;
+  int i;
+
+  for (i=0; i<8; i++) {
+    kb[i] = (unsigned char) (key >> (56 - 8*i));
+    db[i] = (unsigned char) (data >> (56 - 8*i));
+  }
+  des_key(&dc, kb);
+  if (encrypt)
+    des_enc(&dc, db, 1);
+  else
+    des_dec(&dc, db, 1);
+  for (i=0; i<8; i++)
+    out = (out << 8) | db[i];
+  return out;
+}
+
+/* Reference: stage s uses key k[s] encrypting, k[2-s] decrypting. */
+static uint64_t sw_tdes(const uint64_t *k, uint64_t data, int encrypt,
+                        int ede) {
+  int s;
+
+  for (s=0; s<3; s++)
+    data = sw_des(encrypt ? k[s] : k[2-s], data,
+                  encrypt ^ (ede && s == 1));
+  return data;
+}
+
+/* Cycles for one block as three des_cipher_top_tb.vhd operations. */
+static double reset_rekey_cycles(long blocks) {
+  des_core c;
+  long v;
+  int op, i;
+
+  core_init(&c);
+  for (v=0; v<blocks; v++)
+    for (op=0; op<3; op++) {
+      c.reset = 1;
+      core_clock(&c);
+      c.reset = 0;
+      c.key_in = sim_rand();
+      c.function_select = 1;
+      c.data_in = sim_rand();
+      c.lddata = 1;
+      for (i=0; !c.des_out_rdy && i<SIM_TIMEOUT; i++)
+        core_clock(&c);
+    }
+  return (double) c.cycle / blocks;
+}
+
+int main(int argc, char **argv) {
+  const char *mode = "mix", *vecname = NULL;
+  long blocks = 100000, rekey = 1, v;
+  int ede = 1, opt, verbose = 0, wait, enc;
+  unsigned long long mismatches = 0, lost = 0, start, lat, lat_sum = 0;
+  uint64_t k[3], data, want;
+  tdes_core c;
+  FILE *out = NULL;
+  struct timespec t0, t1;
+  double sec, base;
+
+  while ((opt = getopt(argc, argv, "n:m:M:r:s:o:v")) != -1) {
+    switch (opt) {
+    case 'n': blocks = atol(optarg); break;
+    case 'm': ede = strcmp(optarg, "eee") != 0; break;
+    case 'M': mode = optarg; break;
+    case 'r': rekey = atol(optarg); break;
+    case 's': sim_state = strtoull(optarg, NULL, 0) | 1; break;
+    case 'o': vecname = optarg; break;
+    case 'v': verbose = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-n blocks] [-m ede|eee] [-M enc|dec|mix] "
+                      "[-r rekey_every] [-s seed] [-o vectors] [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (blocks <= 0) {
+    fprintf(stderr, "nothing to do\n");
+    return 2;
+  }
+  if (vecname) {
+    if ((out = fopen(vecname, "w")) == NULL) {
+      perror(vecname);
+      return 1;
+    }
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+    fprintf(out, "# %s: key1 key2 key3 func datain dataout\n",
+            ede ? "ede" : "eee");
+  }
+
+  tdes_init(&c, ede);
+  c.reset = 1;
+  tdes_clock(&c);
+  c.reset = 0;
+  c.lddata = 1;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  start = c.cycle;
+  for (v=0; v<blocks; v++) {
+    if (v == 0 || (rekey && v % rekey == 0)) {
+      k[0] = sim_rand();
+      k[1] = sim_rand();
+      k[2] = sim_rand();
+    }
+    data = sim_rand();
+    enc = strcmp(mode, "enc") == 0 ? 1 :
+          strcmp(mode, "dec") == 0 ? 0 : (int) (sim_rand() >> 63);
+    memcpy(c.key_in, k, sizeof(k));
+    c.data_in = data;
+    c.function_select = enc;
+
+    lat = c.cycle;
+    for (wait=0; !c.des_out_rdy && wait<SIM_TIMEOUT; wait++)
+      tdes_clock(&c);
+    if (!c.des_out_rdy) {
+      lost++;
+      break;
+    }
+    lat = c.cycle - lat;
+    lat_sum += lat;
+
+    want = sw_tdes(k, data, enc, ede);
+    if (out)
+      fprintf(out, "%016llx %016llx %016llx %d %016llx %016llx\n",
+              (unsigned long long) k[0], (unsigned long long) k[1],
+              (unsigned long long) k[2], enc, (unsigned long long) data,
+              (unsigned long long) want);
+    if (verbose)
+      printf("%s in=%016llx out=%016llx cycles=%llu%s\n", enc ? "enc" : "dec",
+             (unsigned long long) data, (unsigned long long) c.data_out, lat,
+             c.data_out == want ? "" : "  MISMATCH");
+    if (c.data_out != want) {
+      if (mismatches < 10)
+        fprintf(stderr, "mismatch: %s k1=%016llx k2=%016llx k3=%016llx "
+                "in=%016llx hw=%016llx sw=%016llx\n", enc ? "enc" : "dec",
+                (unsigned long long) k[0], (unsigned long long) k[1],
+                (unsigned long long) k[2], (unsigned long long) data,
+                (unsigned long long) c.data_out, (unsigned long long) want);
+      mismatches++;
+    }
+    /* des_out_rdy is a one-cycle pulse; step past it */
+    tdes_clock(&c);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  if (out)
+    fclose(out);
+
+  base = reset_rekey_cycles(blocks < 10000 ? blocks : 10000);
+  printf("mode=%s blocks=%ld cycles=%llu cycles/block=%.2f "
+         "latency=%.2f cycles\n", ede ? "ede" : "eee", v, c.cycle - start,
+         (double) (c.cycle - start) / (v ? v : 1),
+         (double) lat_sum / (v ? v : 1));
+  printf("reset-and-rekey per stage: %.2f cycles/block -> %.2fx\n", base,
+         base * v / (c.cycle - start));
+  printf("lost=%llu mismatches=%llu  (%.2f k blocks/s simulated)\n", lost,
+         mismatches, v / sec / 1e3);
+  return mismatches || lost ? 1 : 0;
+}
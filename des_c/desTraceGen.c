@@ -0,0 +1,177 @@
+/* Round-accurate test-vector generator built on the DES_TRACE hooks in
+ * desfunc().  Replaces the printf/encodeSteps.txt/scratch.py path:
+ * every vector carries the key, input and output blocks plus the
+ * L/R halves after the initial permutation and after each of the 16
+ * rounds, together with the subkey each round used.
+ *
+ *   gcc -O2 -pthread -DDES_TRACE desTraceGen.c -o desTraceGen
+ *   ./desTraceGen [-n vectors] [-r rekey_every] [-d] [-s seed] [-x | -b]
+ *                 [-o file]
+ *
+ *   -n  number of vectors (default 1000000)
+ *   -r  draw a fresh random key every N vectors (default 1)
+ *   -d  trace decryption (des_dec) instead of encryption
+ *   -s  PRNG seed, so a failing vector can be regenerated
+ *   -x  write text instead of binary (one line per round)
+ *   -b  write block_top vectors for des_vhdl/block_top_tb.vhd, one line
+ *       per round: "round L_in R_in K L_out R_out" in hex (round in
+ *       decimal), i.e. L/R before and after the round and its subkey
+ *   -o  output file (default stdout)
+ *
+ * Binary layout: the 8-byte magic "DESTRC1\n", then back-to-back
+ * trace_vector structs in host byte order (see below).
+ */
+
+#ifndef DES_TRACE
+#error "build with -DDES_TRACE"
+#endif
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+
+#define TRACE_ROUNDS 17            /* after IP, then rounds 1..16 */
+#define TRACE_BATCH  4096
+
+typedef struct {
+  unsigned char key[8];
+  unsigned char in[8];
+  unsigned char out[8];
+  unsigned int  decrypt;
+  des_trace_rec rounds[TRACE_ROUNDS];
+} trace_vector;
+
+static unsigned long long tg_state;
+
+static unsigned long long tg_rand(void) {
+  tg_state ^= tg_state << 13;
+  tg_state ^= tg_state >> 7;
+  tg_state ^= tg_state << 17;
+  return tg_state;
+}
+
+static void tg_fill(unsigned char *p) {
+  unsigned long long r = tg_rand();
+  int i;
+
+  for (i=0; i<8; i++, r >>= 8)
+    p[i] = (unsigned char) r;
+}
+
+static void tg_text(FILE *fp, const trace_vector *v) {
+  int i;
+
+  fprintf(fp, "%s key=", v->decrypt ? "dec" : "enc");
+  for (i=0; i<8; i++) fprintf(fp, "%02x", v->key[i]);
+  fprintf(fp, " in=");
+  for (i=0; i<8; i++) fprintf(fp, "%02x", v->in[i]);
+  fprintf(fp, " out=");
+  for (i=0; i<8; i++) fprintf(fp, "%02x", v->out[i]);
+  fprintf(fp, "\n");
+  for (i=0; i<TRACE_ROUNDS; i++)
+    fprintf(fp, "  %2u L=%08x R=%08x K=%012llx\n", v->rounds[i].round,
+            v->rounds[i].l, v->rounds[i].r,
+            des_trace_subkey(v->rounds[i].k0, v->rounds[i].k1));
+}
+
+/* One block_top stimulus/response line per round: round i maps
+   (L(i-1), R(i-1), K(i)) to (L(i), R(i)). */
+static void tg_block_top(FILE *fp, const trace_vector *v) {
+  int i;
+
+  for (i=1; i<TRACE_ROUNDS; i++)
+    fprintf(fp, "%2u %08x %08x %012llx %08x %08x\n", v->rounds[i].round,
+            v->rounds[i-1].l, v->rounds[i-1].r,
+            des_trace_subkey(v->rounds[i].k0, v->rounds[i].k1),
+            v->rounds[i].l, v->rounds[i].r);
+}
+
+int main(int argc, char **argv) {
+  long vectors = 1000000, rekey = 1, i;
+  int decrypt = 0, text = 0, blocktop = 0, opt, n = 0, k;
+  const char *outname = NULL;
+  FILE *out = stdout;
+  trace_vector *batch;
+  unsigned char key[8];
+  des_ctx dc;
+  des_tracer tr;
+
+  tg_state = 0x2545f4914f6cdd1dULL;
+  while ((opt = getopt(argc, argv, "n:r:ds:xbo:")) != -1) {
+    switch (opt) {
+    case 'n': vectors = atol(optarg); break;
+    case 'r': rekey = atol(optarg); break;
+    case 'd': decrypt = 1; break;
+    case 's': tg_state = strtoull(optarg, NULL, 0) | 1; break;
+    case 'x': text = 1; break;
+    case 'b': text = blocktop = 1; break;
+    case 'o': outname = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-n vectors] [-r rekey_every] [-d] "
+                      "[-s seed] [-x | -b] [-o file]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (rekey < 1)
+    rekey = 1;
+  if (outname && (out = fopen(outname, text ? "w" : "wb")) == NULL) {
+    perror(outname);
+    return 1;
+  }
+  batch = malloc(TRACE_BATCH * sizeof(*batch));
+  if (batch == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  if (blocktop)
+    fprintf(out, "# round L_in R_in key L_out R_out\n");
+  else if (!text)
+    fwrite("DESTRC1\n", 1, 8, out);
+
+  memset(&tr, 0, sizeof(tr));
+  tr.cap = TRACE_ROUNDS;
+  des_trace_attach(&tr);
+
+  for (i=0; i<vectors; i++) {
+    trace_vector *v = &batch[n];
+
+    if (i % rekey == 0) {
+      tg_fill(key);
+      des_key(&dc, key);
+    }
+    memcpy(v->key, key, 8);
+    tg_fill(v->in);
+    memcpy(v->out, v->in, 8);
+    v->decrypt = decrypt;
+
+    /* trace straight into the vector */
+    tr.buf = v->rounds;
+    tr.len = 0;
+    if (decrypt)
+      des_dec(&dc, v->out, 1);
+    else
+      des_enc(&dc, v->out, 1);
+
+    if (++n == TRACE_BATCH || i == vectors-1) {
+      if (blocktop) {
+        for (k=0; k<n; k++)
+          tg_block_top(out, &batch[k]);
+      } else if (text) {
+        for (k=0; k<n; k++)
+          tg_text(out, &batch[k]);
+      } else if (fwrite(batch, sizeof(*batch), n, out) != (size_t) n) {
+        perror("fwrite");
+        return 1;
+      }
+      n = 0;
+    }
+  }
+
+  des_trace_attach(NULL);
+  if (tr.dropped)
+    fprintf(stderr, "warning: %lu trace records dropped\n", tr.dropped);
+  free(batch);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
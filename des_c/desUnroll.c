@@ -0,0 +1,206 @@
+/* Check and time the specialised engines in desUnroll.h against
+ * des_enc/des_dec.  The reference for a triple engine is three des_enc/
+ * des_dec passes in the engine's stage order.
+ *
+ *   gcc -O3 -pthread desUnroll.c -o desUnroll
+ *   ./desUnroll [-b blocks] [-n passes] [-s seed]
+ *
+ * For the merged-table engines as well:
+ *
+ *   gcc -O2 -pthread desGen.c -o desGen && ./desGen -l merged -o desSPMerged.h
+ *   gcc -O3 -pthread -DDES_UNROLL_MERGED desUnroll.c -o desUnroll
+ *
+ * and for fixed-key engines (checked against des_key on the same keys,
+ * and timed for a single block from cold: des_key plus one block versus
+ * the fixed engine alone):
+ *
+ *   ./desGen -k demo=0123456789abcdef -k tri=blizzard,skipjack,jumpoffs \
+ *            -o desFixedKeys.h
+ *   gcc -O3 -pthread -DDES_UNROLL_FIXED desUnroll.c -o desUnroll
+ *
+ *   -b  blocks per buffer (default 4096)
+ *   -n  timed passes over the buffer (default 200)
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include "desUnroll.h"
+#ifdef DES_UNROLL_FIXED
+#include "desFixedKeys.h"
+#endif
+#include <unistd.h>
+#include <time.h>
+
+typedef void (*du_fn)(des_ctx *, unsigned char *, int);
+
+static unsigned long long du_state = 0x6a09e667f3bcc908ULL;
+
+static unsigned long long du_rand(void) {
+  du_state ^= du_state << 13;
+  du_state ^= du_state >> 7;
+  du_state ^= du_state << 17;
+  return du_state;
+}
+
+static double du_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void ref_eee_enc(des_ctx *dc, unsigned char *d, int n) {
+  des_enc(&dc[0], d, n); des_enc(&dc[1], d, n); des_enc(&dc[2], d, n);
+}
+static void ref_eee_dec(des_ctx *dc, unsigned char *d, int n) {
+  des_dec(&dc[2], d, n); des_dec(&dc[1], d, n); des_dec(&dc[0], d, n);
+}
+static void ref_ede_enc(des_ctx *dc, unsigned char *d, int n) {
+  des_enc(&dc[0], d, n); des_dec(&dc[1], d, n); des_enc(&dc[2], d, n);
+}
+static void ref_ede_dec(des_ctx *dc, unsigned char *d, int n) {
+  des_dec(&dc[2], d, n); des_enc(&dc[1], d, n); des_dec(&dc[0], d, n);
+}
+
+static const struct {
+  const char *name;
+  du_fn fn, ref;
+} engines[] = {
+  {"sp enc",      du_sp_enc,     des_enc},
+  {"sp dec",      du_sp_dec,     des_dec},
+  {"sp eee enc",  du_sp_eee_enc, ref_eee_enc},
+  {"sp eee dec",  du_sp_eee_dec, ref_eee_dec},
+  {"sp ede enc",  du_sp_ede_enc, ref_ede_enc},
+  {"sp ede dec",  du_sp_ede_dec, ref_ede_dec},
+#ifdef DES_UNROLL_MERGED
+  {"mg enc",      du_mg_enc,     des_enc},
+  {"mg dec",      du_mg_dec,     des_dec},
+  {"mg eee enc",  du_mg_eee_enc, ref_eee_enc},
+  {"mg eee dec",  du_mg_eee_dec, ref_eee_dec},
+  {"mg ede enc",  du_mg_ede_enc, ref_ede_enc},
+  {"mg ede dec",  du_mg_ede_dec, ref_ede_dec},
+#endif
+};
+
+#ifdef DES_UNROLL_FIXED
+/* Fixed-key engines: same output as des_key on the same key(s), and the
+   rate for one-block requests that each start from the raw key. */
+static unsigned long du_fixed(const unsigned char *in, unsigned char *want,
+                              unsigned char *buf, int blocks, long passes) {
+  unsigned long mismatches = 0;
+  des_ctx dc[3];
+  double t0, base, rate;
+  long p, reqs = 64 * passes;
+  int i, j, k, bad;
+
+  printf("\n%-12s %14s %14s %8s\n", "fixed key", "keyed req/s", "req/s",
+         "speedup");
+  for (i=0; i<(int) (sizeof(des_fixed)/sizeof(des_fixed[0])); i++) {
+    int nk = des_fixed[i].nkeys;
+
+    for (k=0; k<nk; k++)
+      des_key(&dc[k], (unsigned char *) des_fixed[i].key + 8*k);
+    bad = 0;
+    memcpy(want, in, 8 * (size_t) blocks);
+    (nk == 3 ? ref_eee_enc : des_enc)(dc, want, blocks);
+    memcpy(buf, in, 8 * (size_t) blocks);
+    des_fixed[i].enc(buf, blocks);
+    for (j=0; j<blocks; j++)
+      if (memcmp(buf + 8*j, want + 8*j, 8) != 0)
+        bad++;
+    des_fixed[i].dec(buf, blocks);
+    for (j=0; j<blocks; j++)
+      if (memcmp(buf + 8*j, in + 8*j, 8) != 0)
+        bad++;
+
+    t0 = du_now();
+    for (p=0; p<reqs; p++) {
+      for (k=0; k<nk; k++)
+        des_key(&dc[k], (unsigned char *) des_fixed[i].key + 8*k);
+      (nk == 3 ? ref_eee_enc : des_enc)(dc, buf, 1);
+    }
+    base = (double) reqs / (du_now() - t0);
+    t0 = du_now();
+    for (p=0; p<reqs; p++)
+      des_fixed[i].enc(buf, 1);
+    rate = (double) reqs / (du_now() - t0);
+    printf("%-12s %14.0f %14.0f %7.2fx %s\n", des_fixed[i].name, base, rate,
+           rate / base, bad ? "MISMATCH" : "ok");
+    mismatches += bad;
+  }
+  return mismatches;
+}
+#endif
+
+static double du_rate(du_fn fn, des_ctx *dc, unsigned char *buf, int blocks,
+                      long passes) {
+  double t0 = du_now();
+  long p;
+
+  for (p=0; p<passes; p++)
+    fn(dc, buf, blocks);
+  return (double) passes * blocks / (du_now() - t0);
+}
+
+int main(int argc, char **argv) {
+  int blocks = 4096, opt, i, j;
+  long passes = 200;
+  unsigned long mismatches = 0;
+  unsigned char key[8], *in, *want, *buf;
+  des_ctx dc[3];
+  double base, rate;
+
+  while ((opt = getopt(argc, argv, "b:n:s:")) != -1) {
+    switch (opt) {
+    case 'b': blocks = atoi(optarg); break;
+    case 'n': passes = atol(optarg); break;
+    case 's': du_state = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-b blocks] [-n passes] [-s seed]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (blocks < 1)
+    blocks = 1;
+  in = malloc(8 * (size_t) blocks);
+  want = malloc(8 * (size_t) blocks);
+  buf = malloc(8 * (size_t) blocks);
+  if (in == NULL || want == NULL || buf == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  for (i=0; i<3; i++) {
+    for (j=0; j<8; j++)
+      key[j] = (unsigned char) du_rand();
+    des_key(&dc[i], key);
+  }
+  for (i=0; i<8*blocks; i++)
+    in[i] = (unsigned char) du_rand();
+
+  printf("%-12s %14s %14s %8s\n", "engine", "ref blk/s", "blk/s", "speedup");
+  for (i=0; i<(int) (sizeof(engines)/sizeof(engines[0])); i++) {
+    int bad = 0;
+
+    memcpy(want, in, 8 * (size_t) blocks);
+    engines[i].ref(dc, want, blocks);
+    memcpy(buf, in, 8 * (size_t) blocks);
+    engines[i].fn(dc, buf, blocks);
+    for (j=0; j<blocks; j++)
+      if (memcmp(buf + 8*j, want + 8*j, 8) != 0)
+        bad++;
+
+    base = du_rate(engines[i].ref, dc, buf, blocks, passes);
+    rate = du_rate(engines[i].fn, dc, buf, blocks, passes);
+    printf("%-12s %14.0f %14.0f %7.2fx %s\n", engines[i].name, base, rate,
+           rate / base, bad ? "MISMATCH" : "ok");
+    mismatches += bad;
+  }
+#ifdef DES_UNROLL_FIXED
+  mismatches += du_fixed(in, want, buf, blocks, passes);
+#endif
+  free(in);
+  free(want);
+  free(buf);
+  return mismatches != 0;
+}
@@ -0,0 +1,234 @@
+/* Compile-time specialised DES engines.  desfunc() loops over rounds and
+ * takes its direction from the schedule deskey() built; here the
+ * direction, single/triple structure and SP table layout are fixed per
+ * engine by macros.  Each engine is 16 (or 48) straight-line rounds
+ * whose key offsets are integer constants:
+ *
+ *   DU_KI(dir, i, w)   cooked word w of round i: forward through ek for
+ *                      encryption, backwards through the same ek for
+ *                      decryption, so no dk is read
+ *   DU_HALF_SP         desfunc's eight SP1..SP8 lookups per round
+ *   DU_HALF_MERGED     four lookups in desGen's merged SP13/SP57/SP24/
+ *                      SP68 tables (two S-boxes per lookup); build with
+ *                      -DDES_UNROLL_MERGED after
+ *                          ./desGen -l merged -o desSPMerged.h
+ *
+ * Triple engines run IP once and FP once.  Between stages FP and IP
+ * cancel, leaving only the swap of the halves, as in tdes_top.vhd.
+ * EEE chains like main() in des.c (decrypt: D(k3) D(k2) D(k1)); EDE is
+ * E(k1) D(k2) E(k3).
+ *
+ * Instances, all on des_ctx (only ek is used):
+ *
+ *   du_sp_enc, du_sp_dec                 (dc, data, blocks), as des_enc
+ *   du_sp_eee_enc, du_sp_eee_dec         (dc[3], data, blocks)
+ *   du_sp_ede_enc, du_sp_ede_dec
+ *   du_mg_*                              the same on the merged tables
+ *
+ * Keys known at build time need no schedule at all:
+ *
+ *   ./desGen -k name=KEY[,KEY2,KEY3] ... -o desFixedKeys.h
+ *
+ * runs deskey() in the generator and emits each cooked schedule as a
+ * static const array plus des_fk_name_enc/_dec(data, blocks), the
+ * engines above specialised on it (EEE for three keys), and a des_fixed[]
+ * table listing them.  Include desFixedKeys.h after this header.
+ *
+ * There are no tables or state to set up at run time.  Header-only
+ * (static); include after des.c.
+ */
+
+#ifdef DES_UNROLL_MERGED
+#include "desSPMerged.h"
+#endif
+
+/* Schedule index of cooked word w (0, 1) of round i (0..15). */
+#define DU_KI(dir, i, w)  ((dir) == DE1 ? 30 - 2*(i) + (w) : 2*(i) + (w))
+
+/* l ^= f(r) with the cooked key pair k0, k1 (desfunc's loop body). */
+#define DU_HALF_SP(l, r, k0, k1)                                          \
+  do {                                                                    \
+    work  = ((r) << 28) | ((r) >> 4);                                     \
+    work ^= (k0);                                                         \
+    fval  = SP7[work       & 0x3fL];                                      \
+    fval |= SP5[(work>> 8) & 0x3fL];                                      \
+    fval |= SP3[(work>>16) & 0x3fL];                                      \
+    fval |= SP1[(work>>24) & 0x3fL];                                      \
+    work  = (r) ^ (k1);                                                   \
+    fval |= SP8[work       & 0x3fL];                                      \
+    fval |= SP6[(work>> 8) & 0x3fL];                                      \
+    fval |= SP4[(work>>16) & 0x3fL];                                      \
+    fval |= SP2[(work>>24) & 0x3fL];                                      \
+    (l) ^= fval;                                                          \
+  } while (0)
+
+#define DU_HALF_MERGED(l, r, k0, k1)                                      \
+  do {                                                                    \
+    work  = ((r) << 28) | ((r) >> 4);                                     \
+    work ^= (k0);                                                         \
+    fval  = SP13[((work>>18) & 0xfc0L) | ((work>>16) & 0x3fL)];           \
+    fval |= SP57[((work>> 2) & 0xfc0L) | (work       & 0x3fL)];           \
+    work  = (r) ^ (k1);                                                   \
+    fval |= SP24[((work>>18) & 0xfc0L) | ((work>>16) & 0x3fL)];           \
+    fval |= SP68[((work>> 2) & 0xfc0L) | (work       & 0x3fL)];           \
+    (l) ^= fval;                                                          \
+  } while (0)
+
+#define DU_ROUND(HALF, dir, i, l, r, k)                                   \
+  HALF(l, r, (k)[DU_KI(dir, i, 0)], (k)[DU_KI(dir, i, 1)])
+
+/* All 16 rounds, unrolled. */
+#define DU_ROUNDS(HALF, dir, k)                                           \
+  do {                                                                    \
+    DU_ROUND(HALF, dir,  0, leftt, right, k);                             \
+    DU_ROUND(HALF, dir,  1, right, leftt, k);                             \
+    DU_ROUND(HALF, dir,  2, leftt, right, k);                             \
+    DU_ROUND(HALF, dir,  3, right, leftt, k);                             \
+    DU_ROUND(HALF, dir,  4, leftt, right, k);                             \
+    DU_ROUND(HALF, dir,  5, right, leftt, k);                             \
+    DU_ROUND(HALF, dir,  6, leftt, right, k);                             \
+    DU_ROUND(HALF, dir,  7, right, leftt, k);                             \
+    DU_ROUND(HALF, dir,  8, leftt, right, k);                             \
+    DU_ROUND(HALF, dir,  9, right, leftt, k);                             \
+    DU_ROUND(HALF, dir, 10, leftt, right, k);                             \
+    DU_ROUND(HALF, dir, 11, right, leftt, k);                             \
+    DU_ROUND(HALF, dir, 12, leftt, right, k);                             \
+    DU_ROUND(HALF, dir, 13, right, leftt, k);                             \
+    DU_ROUND(HALF, dir, 14, leftt, right, k);                             \
+    DU_ROUND(HALF, dir, 15, right, leftt, k);                             \
+  } while (0)
+
+/* desfunc's initial permutation, on leftt/right. */
+#define DU_IP()                                                           \
+  do {                                                                    \
+    work = ((leftt>>4) ^ right) & 0x0f0f0f0fL;                            \
+    right ^= work;                                                        \
+    leftt ^= (work<<4);                                                   \
+    work = ((leftt>>16) ^ right) & 0x0000ffffL;                           \
+    right ^= work;                                                        \
+    leftt ^= (work<<16);                                                  \
+    work = ((right>>2) ^ leftt) & 0x33333333L;                            \
+    leftt ^= work;                                                        \
+    right ^= (work<<2);                                                   \
+    work = ((right>>8) ^ leftt) & 0x00ff00ffL;                            \
+    leftt ^= work;                                                        \
+    right ^= (work<<8);                                                   \
+    right = ((right<<1) | ((right>>31) & 1L)) & 0xffffffffL;              \
+    work = (leftt ^ right) & 0xaaaaaaaaL;                                 \
+    leftt ^= work;                                                        \
+    right ^= work;                                                        \
+    leftt = ((leftt<<1) | ((leftt>>31) & 1L)) & 0xffffffffL;              \
+  } while (0)
+
+/* desfunc's final permutation; the result is (right, leftt). */
+#define DU_FP()                                                           \
+  do {                                                                    \
+    right = (right<<31) | (right>>1);                                     \
+    work = (leftt ^ right) & 0xaaaaaaaaL;                                 \
+    leftt ^= work;                                                        \
+    right ^= work;                                                        \
+    leftt = (leftt<<31) | (leftt>>1);                                     \
+    work = ((leftt>>8) ^ right) & 0x00ff00ffL;                            \
+    right ^= work;                                                        \
+    leftt ^= (work<<8);                                                   \
+    work = ((leftt>>2) ^ right) & 0x33333333L;                            \
+    right ^= work;                                                        \
+    leftt ^= (work<<2);                                                   \
+    work = ((right>>16) ^ leftt) & 0x0000ffffL;                           \
+    leftt ^= work;                                                        \
+    right ^= (work<<16);                                                  \
+    work = ((right>>4) ^ leftt) & 0x0f0f0f0fL;                            \
+    leftt ^= work;                                                        \
+    right ^= (work<<4);                                                   \
+  } while (0)
+
+/* Between triple stages FP then IP is the identity on the block, which
+   leaves the halves swapped. */
+#define DU_SWAP()                                                         \
+  do {                                                                    \
+    work = leftt;                                                         \
+    leftt = right;                                                        \
+    right = work;                                                         \
+  } while (0)
+
+/* ECB loop bodies: single DES with schedule k in direction dir, and
+   triple DES with stage s on schedule ks in direction ds. */
+#define DU_ECB(HALF, dir, k)                                              \
+  register unsigned long fval, work, right, leftt;                        \
+  unsigned long blk[2];                                                   \
+  int i;                                                                  \
+                                                                          \
+  for (i=0; i<blocks; i++, data += 8) {                                   \
+    scrunch(data, blk);                                                   \
+    leftt = blk[0];                                                       \
+    right = blk[1];                                                       \
+    DU_IP();                                                              \
+    DU_ROUNDS(HALF, dir, k);                                              \
+    DU_FP();                                                              \
+    blk[0] = right;                                                       \
+    blk[1] = leftt;                                                       \
+    unscrun(blk, data);                                                   \
+  }
+
+#define DU_ECB3(HALF, ka, d0, kb, d1, kc, d2)                             \
+  register unsigned long fval, work, right, leftt;                        \
+  unsigned long blk[2];                                                   \
+  int i;                                                                  \
+                                                                          \
+  for (i=0; i<blocks; i++, data += 8) {                                   \
+    scrunch(data, blk);                                                   \
+    leftt = blk[0];                                                       \
+    right = blk[1];                                                       \
+    DU_IP();                                                              \
+    DU_ROUNDS(HALF, d0, ka);                                              \
+    DU_SWAP();                                                            \
+    DU_ROUNDS(HALF, d1, kb);                                              \
+    DU_SWAP();                                                            \
+    DU_ROUNDS(HALF, d2, kc);                                              \
+    DU_FP();                                                              \
+    blk[0] = right;                                                       \
+    blk[1] = leftt;                                                       \
+    unscrun(blk, data);                                                   \
+  }
+
+/* Single DES engine on dc->ek. */
+#define DU_DEFINE(name, HALF, dir)                                        \
+static void name(des_ctx *dc, unsigned char *data, int blocks) {          \
+  const unsigned long *k = dc->ek;                                        \
+  DU_ECB(HALF, dir, k)                                                    \
+}
+
+/* Triple DES engine: stage s uses dc[ks].ek in direction ds. */
+#define DU_DEFINE3(name, HALF, k0, d0, k1, d1, k2, d2)                    \
+static void name(des_ctx *dc, unsigned char *data, int blocks) {          \
+  const unsigned long *ka = dc[k0].ek, *kb = dc[k1].ek, *kc = dc[k2].ek;  \
+  DU_ECB3(HALF, ka, d0, kb, d1, kc, d2)                                   \
+}
+
+/* Fixed-key engines: ks.. are static const schedules, so every subkey
+   folds into an immediate.  desGen -k emits these. */
+#define DU_DEFINE_FIXED(name, HALF, dir, ks)                              \
+static void name(unsigned char *data, int blocks) {                       \
+  DU_ECB(HALF, dir, ks)                                                   \
+}
+
+#define DU_DEFINE3_FIXED(name, HALF, ka, d0, kb, d1, kc, d2)              \
+static void name(unsigned char *data, int blocks) {                       \
+  DU_ECB3(HALF, ka, d0, kb, d1, kc, d2)                                   \
+}
+
+DU_DEFINE(du_sp_enc, DU_HALF_SP, EN0)
+DU_DEFINE(du_sp_dec, DU_HALF_SP, DE1)
+DU_DEFINE3(du_sp_eee_enc, DU_HALF_SP, 0, EN0, 1, EN0, 2, EN0)
+DU_DEFINE3(du_sp_eee_dec, DU_HALF_SP, 2, DE1, 1, DE1, 0, DE1)
+DU_DEFINE3(du_sp_ede_enc, DU_HALF_SP, 0, EN0, 1, DE1, 2, EN0)
+DU_DEFINE3(du_sp_ede_dec, DU_HALF_SP, 2, DE1, 1, EN0, 0, DE1)
+
+#ifdef DES_UNROLL_MERGED
+DU_DEFINE(du_mg_enc, DU_HALF_MERGED, EN0)
+DU_DEFINE(du_mg_dec, DU_HALF_MERGED, DE1)
+DU_DEFINE3(du_mg_eee_enc, DU_HALF_MERGED, 0, EN0, 1, EN0, 2, EN0)
+DU_DEFINE3(du_mg_eee_dec, DU_HALF_MERGED, 2, DE1, 1, DE1, 0, DE1)
+DU_DEFINE3(du_mg_ede_enc, DU_HALF_MERGED, 0, EN0, 1, DE1, 2, EN0)
+DU_DEFINE3(du_mg_ede_dec, DU_HALF_MERGED, 2, DE1, 1, EN0, 0, DE1)
+#endif
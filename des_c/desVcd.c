@@ -0,0 +1,398 @@
+/* Streaming VCD analyzer for des_cipher_top simulations (for example
+ * des_vhdl/sim_results.vcd).  The dump is read one token at a time and
+ * only the current value of each traced net is kept, so memory does not
+ * grow with the length of the dump.
+ *
+ *   gcc -O2 -pthread desVcd.c -o desVcd
+ *   ./desVcd [-v] dump.vcd          (or - for stdin)
+ *
+ * Nets are taken from the outermost scope (the testbench): clock, reset,
+ * key_in, data_in, data_out, funct_select/function_select, lddata,
+ * core_busy and des_out_rdy.  Buses can be dumped either bit by bit, the
+ * way ModelSim writes "key_in [5]", or as one vector ("b0101...").
+ *
+ * Per rising clock edge, inputs are the values just before the edge and
+ * outputs the values after it.  A block starts on the edge where
+ * core_busy rises and ends on the edge where des_out_rdy rises.  Its
+ * data is the last data_in captured with lddata high before that, the
+ * key is key_in at the start edge.  Every data_out is checked against
+ * des_enc/des_dec.
+ *
+ * Reported: blocks, mismatches, latency in cycles (core: busy to ready;
+ * request: first lddata to ready), reset/busy/idle cycles, and achieved
+ * blocks per cycle.  -v prints every transaction.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <stdint.h>
+#include <ctype.h>
+
+enum { N_CLOCK, N_RESET, N_KEY, N_DIN, N_DOUT, N_FSEL, N_LD, N_BUSY, N_RDY,
+       N_COUNT };
+
+static const char *net_names[N_COUNT][2] = {
+  {"clock", NULL}, {"reset", NULL}, {"key_in", NULL}, {"data_in", NULL},
+  {"data_out", NULL}, {"funct_select", "function_select"}, {"lddata", NULL},
+  {"core_busy", NULL}, {"des_out_rdy", NULL}};
+
+typedef struct {
+  uint64_t val;
+  uint64_t xmask;             /* bits that are x/u/z */
+} vcd_net;
+
+/* One $var: an identifier code bound to a whole net or to one bit. */
+typedef struct vcd_var {
+  char id[64];
+  int net;
+  int lsb_first;              /* vector declared [lo:hi]... see vcd_set */
+  int width;
+  int bit;                    /* bus index for a single-bit var, else -1 */
+  struct vcd_var *next;       /* hash chain */
+} vcd_var;
+
+#define VAR_HASH 4096
+
+static vcd_var *vars[VAR_HASH];
+static vcd_net net[N_COUNT], pre[N_COUNT];
+static int verbose;
+
+static unsigned vcd_hash(const char *s) {
+  unsigned h = 2166136261u;
+
+  while (*s)
+    h = (h ^ (unsigned char) *s++) * 16777619u;
+  return h & (VAR_HASH - 1);
+}
+
+/* Whitespace-separated token; returns 0 at EOF. */
+static int vcd_token(FILE *fp, char *tok, int cap) {
+  int c, n = 0;
+
+  do {
+    c = getc_unlocked(fp);
+  } while (c != EOF && isspace(c));
+  if (c == EOF)
+    return 0;
+  while (c != EOF && !isspace(c)) {
+    if (n < cap - 1)
+      tok[n++] = (char) c;
+    c = getc_unlocked(fp);
+  }
+  tok[n] = '\0';
+  return 1;
+}
+
+/* Bus bit i (VHDL index, 0 = MSB for the (0 to 63) buses) of a
+   width-w net, as a uint64 mask. */
+static uint64_t bus_bit(int i, int w) {
+  return (uint64_t) 1 << (w - 1 - i);
+}
+
+static int net_width(int n) {
+  return (n == N_KEY || n == N_DIN || n == N_DOUT) ? 64 : 1;
+}
+
+static void vcd_set(vcd_var *v, const char *value) {
+  vcd_net *s = &net[v->net];
+  int w = net_width(v->net), len, i, pos;
+  uint64_t m;
+  char c;
+
+  if (v->bit >= 0 || w == 1) {
+    c = value[0] == 'b' || value[0] == 'B' ? value[strlen(value)-1] : value[0];
+    m = w == 1 ? 1 : bus_bit(v->bit, w);
+    s->val &= ~m;
+    s->xmask &= ~m;
+    if (c == '1')
+      s->val |= m;
+    else if (c != '0')
+      s->xmask |= m;
+    return;
+  }
+
+  /* vector: characters left to right are the declared left..right
+     indices; short values are extended with their first digit (0/x) */
+  value++;
+  len = (int) strlen(value);
+  for (i=0; i<v->width; i++) {
+    c = i < v->width - len ? (value[0] == '1' ? '0' : value[0])
+                           : value[i - (v->width - len)];
+    pos = v->lsb_first ? v->width - 1 - i : i;
+    if (pos >= w)
+      continue;
+    m = bus_bit(pos, w);
+    s->val &= ~m;
+    s->xmask &= ~m;
+    if (c == '1')
+      s->val |= m;
+    else if (c != '0')
+      s->xmask |= m;
+  }
+}
+
+static void vcd_declare(int n, const char *id, int width, const char *range) {
+  vcd_var *v = calloc(1, sizeof(*v));
+  unsigned h = vcd_hash(id);
+  int lo, hi;
+
+  snprintf(v->id, sizeof(v->id), "%s", id);
+  v->net = n;
+  v->width = width;
+  v->bit = -1;
+  if (range && sscanf(range, "[%d:%d]", &lo, &hi) == 2) {
+    /* [63:0] lists bit 63 first; the buses here are (0 to 63), so a
+       "downto" dump of them is reversed relative to VHDL index */
+    v->lsb_first = lo > hi;
+  } else if (range && sscanf(range, "[%d]", &lo) == 1 && width == 1) {
+    v->bit = lo;
+  }
+  v->next = vars[h];
+  vars[h] = v;
+}
+
+static vcd_var *vcd_lookup(const char *id) {
+  vcd_var *v;
+
+  for (v = vars[vcd_hash(id)]; v; v = v->next)
+    if (strcmp(v->id, id) == 0)
+      return v;
+  return NULL;
+}
+
+static void vcd_change(const char *id, const char *value) {
+  vcd_var *v;
+
+  for (v = vars[vcd_hash(id)]; v; v = v->next)
+    if (strcmp(v->id, id) == 0)
+      vcd_set(v, value);
+}
+
+/* ---- transaction tracking, one call per rising clock edge ---- */
+
+static struct {
+  unsigned long long cycles, reset_cycles, busy_cycles, idle_cycles;
+  unsigned long long blocks, mismatches, unknown;
+  unsigned long long core_lat_sum, req_lat_sum;
+  unsigned long long core_lat_min, core_lat_max, req_lat_min, req_lat_max;
+  /* in flight */
+  int active, fsel, req_open;
+  uint64_t cap_data, cap_key, key, data;
+  unsigned long long start, req_start;
+  int prev_busy, prev_rdy;
+} tx;
+
+static uint64_t sw_des(uint64_t key, uint64_t data, int encrypt) {
+  static des_ctx dc;
+  static uint64_t last;
+  static int valid;
+  unsigned char kb[8], db[8];
+  uint64_t out = 0;
+  int i;
+
+  if (!valid || last != key) {
+    for (i=0; i<8; i++)
+      kb[i] = (unsigned char) (key >> (56 - 8*i));
+    des_key(&dc, kb);
+    last = key;
+    valid = 1;
+  }
+  for (i=0; i<8; i++)
+    db[i] = (unsigned char) (data >> (56 - 8*i));
+  if (encrypt)
+    des_enc(&dc, db, 1);
+  else
+    des_dec(&dc, db, 1);
+  for (i=0; i<8; i++)
+    out = (out << 8) | db[i];
+  return out;
+}
+
+static void edge(void) {
+  int busy = (int) (net[N_BUSY].val & 1), rdy = (int) (net[N_RDY].val & 1);
+  unsigned long long core_lat, req_lat;
+  uint64_t want;
+
+  tx.cycles++;
+  if (pre[N_RESET].val & 1) {
+    tx.reset_cycles++;
+    tx.active = 0;
+    tx.req_open = 0;
+  } else if (busy) {
+    tx.busy_cycles++;
+  } else {
+    tx.idle_cycles++;
+  }
+
+  if (busy && !tx.prev_busy && !(pre[N_RESET].val & 1)) {
+    tx.active = 1;
+    tx.start = tx.cycles;
+    tx.data = tx.cap_data;
+    tx.key = tx.cap_key;
+    tx.fsel = (int) (pre[N_FSEL].val & 1);
+  }
+
+  if (rdy && !tx.prev_rdy && tx.active) {
+    core_lat = tx.cycles - tx.start;
+    req_lat = tx.req_open ? tx.cycles - tx.req_start : core_lat;
+    tx.blocks++;
+    tx.core_lat_sum += core_lat;
+    tx.req_lat_sum += req_lat;
+    if (tx.blocks == 1 || core_lat < tx.core_lat_min) tx.core_lat_min = core_lat;
+    if (core_lat > tx.core_lat_max) tx.core_lat_max = core_lat;
+    if (tx.blocks == 1 || req_lat < tx.req_lat_min) tx.req_lat_min = req_lat;
+    if (req_lat > tx.req_lat_max) tx.req_lat_max = req_lat;
+
+    want = sw_des(tx.key, tx.data, tx.fsel);
+    if (net[N_DOUT].xmask) {
+      tx.unknown++;
+    } else if (net[N_DOUT].val != want) {
+      tx.mismatches++;
+      if (tx.mismatches <= 10)
+        fprintf(stderr, "mismatch at cycle %llu: %s key=%016llx in=%016llx "
+                "hw=%016llx sw=%016llx\n", tx.cycles,
+                tx.fsel ? "enc" : "dec", (unsigned long long) tx.key,
+                (unsigned long long) tx.data,
+                (unsigned long long) net[N_DOUT].val,
+                (unsigned long long) want);
+    }
+    if (verbose)
+      printf("cycle %8llu %s key=%016llx in=%016llx out=%016llx "
+             "core=%llu req=%llu%s\n", tx.cycles, tx.fsel ? "enc" : "dec",
+             (unsigned long long) tx.key, (unsigned long long) tx.data,
+             (unsigned long long) net[N_DOUT].val, core_lat, req_lat,
+             net[N_DOUT].xmask ? " X" :
+             net[N_DOUT].val == want ? "" : " MISMATCH");
+    tx.active = 0;
+    tx.req_open = 0;
+  }
+
+  /* data/key the core will see at the next edge */
+  if ((pre[N_LD].val & 1) && !(pre[N_RESET].val & 1)) {
+    tx.cap_data = pre[N_DIN].val;
+    if (!tx.req_open && !tx.active) {
+      tx.req_open = 1;
+      tx.req_start = tx.cycles;
+    }
+  }
+  tx.cap_key = pre[N_KEY].val;
+  tx.prev_busy = busy;
+  tx.prev_rdy = rdy;
+}
+
+int main(int argc, char **argv) {
+  char tok[256], type[64], size[32], id[64], name[128], range[64];
+  const char *path = NULL;
+  FILE *fp;
+  int depth = 0, scope_seen = 0, in_defs = 1, rose = 0, i, n, width;
+  int have[N_COUNT];
+  vcd_var *clk;
+  uint64_t oldclk;
+
+  for (i=1; i<argc; i++) {
+    if (strcmp(argv[i], "-v") == 0)
+      verbose = 1;
+    else
+      path = argv[i];
+  }
+  if (path == NULL) {
+    fprintf(stderr, "usage: %s [-v] dump.vcd\n", argv[0]);
+    return 2;
+  }
+  fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+  if (fp == NULL) {
+    perror(path);
+    return 1;
+  }
+  setvbuf(fp, NULL, _IOFBF, 1 << 20);
+  memset(have, 0, sizeof(have));
+
+  while (vcd_token(fp, tok, sizeof(tok))) {
+    if (in_defs) {
+      if (strcmp(tok, "$scope") == 0) {
+        depth++;
+        scope_seen = 1;
+      } else if (strcmp(tok, "$upscope") == 0) {
+        depth--;
+      } else if (strcmp(tok, "$enddefinitions") == 0) {
+        in_defs = 0;
+      } else if (strcmp(tok, "$var") == 0) {
+        if (!vcd_token(fp, type, sizeof(type)) ||
+            !vcd_token(fp, size, sizeof(size)) ||
+            !vcd_token(fp, id, sizeof(id)) ||
+            !vcd_token(fp, name, sizeof(name)))
+          break;
+        range[0] = '\0';
+        if (vcd_token(fp, range, sizeof(range)) && strcmp(range, "$end") == 0)
+          range[0] = '\0';
+        else
+          while (vcd_token(fp, tok, sizeof(tok)) && strcmp(tok, "$end") != 0)
+            ;
+        /* only the outermost scope: deeper "data_in" ports are internal */
+        if (scope_seen && depth != 1)
+          continue;
+        width = atoi(size);
+        for (n=0; n<N_COUNT; n++)
+          if (strcmp(name, net_names[n][0]) == 0 ||
+              (net_names[n][1] && strcmp(name, net_names[n][1]) == 0)) {
+            vcd_declare(n, id, width, range[0] ? range : NULL);
+            have[n] = 1;
+          }
+      }
+      continue;
+    }
+
+    if (tok[0] == '#') {
+      /* new timestamp: finish the previous one */
+      if (rose)
+        edge();
+      rose = 0;
+      memcpy(pre, net, sizeof(net));
+    } else if (tok[0] == '$') {
+      /* $dumpvars, $end, ... carry no values themselves */
+    } else if (tok[0] == 'b' || tok[0] == 'B' || tok[0] == 'r' ||
+               tok[0] == 'R') {
+      if (!vcd_token(fp, id, sizeof(id)))
+        break;
+      if (tok[0] == 'b' || tok[0] == 'B')
+        vcd_change(id, tok);
+    } else {
+      clk = vcd_lookup(tok + 1);
+      if (clk && clk->net == N_CLOCK) {
+        oldclk = net[N_CLOCK].val & 1;
+        vcd_change(tok + 1, tok);
+        if (!oldclk && (net[N_CLOCK].val & 1) && !net[N_CLOCK].xmask)
+          rose = 1;
+      } else {
+        vcd_change(tok + 1, tok);
+      }
+    }
+  }
+  if (rose)
+    edge();
+  if (fp != stdin)
+    fclose(fp);
+
+  for (n=0; n<N_COUNT; n++)
+    if (!have[n])
+      fprintf(stderr, "warning: no net named %s in the outermost scope\n",
+              net_names[n][0]);
+
+  printf("cycles=%llu reset=%llu busy=%llu idle=%llu\n", tx.cycles,
+         tx.reset_cycles, tx.busy_cycles, tx.idle_cycles);
+  printf("blocks=%llu mismatches=%llu unknown=%llu\n", tx.blocks,
+         tx.mismatches, tx.unknown);
+  if (tx.blocks) {
+    printf("core latency    min=%llu avg=%.2f max=%llu cycles\n",
+           tx.core_lat_min, (double) tx.core_lat_sum / tx.blocks,
+           tx.core_lat_max);
+    printf("request latency min=%llu avg=%.2f max=%llu cycles\n",
+           tx.req_lat_min, (double) tx.req_lat_sum / tx.blocks,
+           tx.req_lat_max);
+    printf("blocks/cycle=%.4f  cycles/block=%.2f  core busy %.1f%% of "
+           "cycles\n", (double) tx.blocks / tx.cycles,
+           (double) tx.cycles / tx.blocks,
+           100.0 * tx.busy_cycles / tx.cycles);
+  }
+  return tx.mismatches || tx.unknown ? 1 : 0;
+}
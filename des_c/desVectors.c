@@ -0,0 +1,154 @@
+/* Vector-file generator for des_vhdl/des_cipher_top_file_tb.vhd.
+ *
+ * Replaces the scratch.py step that pastes KEY1/KEY2/KEY3/DATAIN/
+ * DATAOUT1..3 into one copy of input2.txt per vector.  Each vector is a
+ * single text line the testbench reads with TEXTIO, so the testbench
+ * source (and its elaboration time) no longer grows with the vector
+ * count:
+ *
+ *   # key1 key2 key3 datain dataout1 dataout2 dataout3
+ *   626c697a7a617264 736b69706a61636b ... 1ea1789cd57b3af8
+ *
+ * dataout1..3 are the outputs of encrypting datain with key1, then key2,
+ * then key3, the same chain main() in des.c and the old testbench use.
+ *
+ *   gcc -O2 -pthread desVectors.c -o desVectors
+ *   ./desVectors [-n vectors] [-s seed] [-k Key.txt] [-p Plaintextin.txt]
+ *                [-o file]
+ *
+ *   -n  random keys and data; without -n the vectors are every key
+ *       triple of -k crossed with every record of -p, like main()
+ *   -o  output file (default des_vectors.txt)
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+
+static unsigned long long vg_state = 0xda3e39cb94b95bdbULL;
+
+static unsigned long long vg_rand(void) {
+  vg_state ^= vg_state << 13;
+  vg_state ^= vg_state >> 7;
+  vg_state ^= vg_state << 17;
+  return vg_state;
+}
+
+static void vg_hex(FILE *fp, const unsigned char *b) {
+  static const char hex[] = "0123456789abcdef";
+  char s[17];
+  int i;
+
+  for (i=0; i<8; i++) {
+    s[2*i]   = hex[b[i] >> 4];
+    s[2*i+1] = hex[b[i] & 0xf];
+  }
+  s[16] = '\0';
+  fputs(s, fp);
+}
+
+static void vg_vector(FILE *fp, const unsigned char *keys,
+                      const unsigned char *data) {
+  unsigned char blk[8];
+  des_ctx dc;
+  int p;
+
+  for (p=0; p<3; p++) {
+    vg_hex(fp, keys + 8*p);
+    fputc(' ', fp);
+  }
+  vg_hex(fp, data);
+  memcpy(blk, data, 8);
+  for (p=0; p<3; p++) {
+    des_key(&dc, (unsigned char *) keys + 8*p);
+    des_enc(&dc, blk, 1);
+    fputc(' ', fp);
+    vg_hex(fp, blk);
+  }
+  fputc('\n', fp);
+}
+
+/* Records of an input file as 8-byte blocks, as main() reads them. */
+static unsigned char *vg_records(const char *path, long *n) {
+  FILE *fp;
+  char *line = NULL;
+  size_t cap = 0, w;
+  unsigned char *out = NULL;
+  long alloc = 0;
+
+  if ((fp = fopen(path, "r")) == NULL) {
+    perror(path);
+    exit(1);
+  }
+  *n = 0;
+  while (getline(&line, &cap, fp) != -1) {
+    if (*n == alloc) {
+      alloc = alloc ? 2*alloc : 64;
+      out = realloc(out, 8 * alloc);
+    }
+    w = strcspn(line, "\r\n");
+    memset(out + 8 * *n, 0, 8);
+    memcpy(out + 8 * *n, line, w < 8 ? w : 8);
+    (*n)++;
+  }
+  free(line);
+  fclose(fp);
+  return out;
+}
+
+int main(int argc, char **argv) {
+  const char *keyfile = "Key.txt", *textfile = "Plaintextin.txt";
+  const char *outname = "des_vectors.txt";
+  long vectors = -1, nkeys, ntext, i, t;
+  unsigned char *keys, *text, kb[24], db[8];
+  unsigned long long r = 0;
+  int opt, j;
+  FILE *out;
+
+  while ((opt = getopt(argc, argv, "n:s:k:p:o:")) != -1) {
+    switch (opt) {
+    case 'n': vectors = atol(optarg); break;
+    case 's': vg_state = strtoull(optarg, NULL, 0) | 1; break;
+    case 'k': keyfile = optarg; break;
+    case 'p': textfile = optarg; break;
+    case 'o': outname = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-n vectors] [-s seed] [-k Key.txt] "
+                      "[-p Plaintextin.txt] [-o file]\n", argv[0]);
+      return 2;
+    }
+  }
+  if ((out = fopen(outname, "w")) == NULL) {
+    perror(outname);
+    return 1;
+  }
+  setvbuf(out, NULL, _IOFBF, 1 << 20);
+  fprintf(out, "# key1 key2 key3 datain dataout1 dataout2 dataout3\n");
+
+  if (vectors >= 0) {
+    for (i=0; i<vectors; i++) {
+      for (j=0; j<24; j++) {
+        if ((j & 7) == 0)
+          r = vg_rand();
+        kb[j] = (unsigned char) r;
+        r >>= 8;
+      }
+      r = vg_rand();
+      for (j=0; j<8; j++, r >>= 8)
+        db[j] = (unsigned char) r;
+      vg_vector(out, kb, db);
+    }
+  } else {
+    keys = vg_records(keyfile, &nkeys);
+    text = vg_records(textfile, &ntext);
+    vectors = 0;
+    for (t=0; t+3<=nkeys; t+=3)
+      for (i=0; i<ntext; i++, vectors++)
+        vg_vector(out, keys + 8*t, text + 8*i);
+    free(keys);
+    free(text);
+  }
+  fclose(out);
+  fprintf(stderr, "%ld vectors -> %s\n", vectors, outname);
+  return 0;
+}
@@ -0,0 +1,74 @@
+/* Reference DES for VHDL testbenches, called through GHDL's VHPIDIRECT
+ * foreign interface (see des_vhdl/des_ref_pkg.vhd).  The testbench
+ * computes each expected data_out at run time instead of reading it from
+ * a pregenerated file.
+ *
+ *   gcc -O2 -pthread -c -fPIC desVhpi.c -o desVhpi.o
+ *   ghdl -e --std=93c --ieee=synopsys -fexplicit -Wl,desVhpi.o \
+ *        -Wl,-pthread des_cipher_top_ref_tb
+ *
+ * 64-bit buses cross the interface as two VHDL integers (32-bit, two's
+ * complement): bits 0..31 of the bus in hi, 32..63 in lo, bit 0 as the
+ * MSB of hi, as desCore.h numbers them.
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <stdint.h>
+
+/* A few cached schedules: the testbench reuses each key (triple-DES
+   chains, encrypt then decrypt). */
+#define REF_KEYS 8
+
+static des_ctx ref_ctx[REF_KEYS];
+static uint64_t ref_key[REF_KEYS];
+static int ref_valid[REF_KEYS], ref_next;
+static unsigned long long ref_calls;
+
+static des_ctx *ref_schedule(uint64_t key) {
+  unsigned char kb[8];
+  int i, k;
+
+  for (k=0; k<REF_KEYS; k++)
+    if (ref_valid[k] && ref_key[k] == key)
+      return &ref_ctx[k];
+  k = ref_next;
+  ref_next = (ref_next + 1) % REF_KEYS;
+  for (i=0; i<8; i++)
+    kb[i] = (unsigned char) (key >> (56 - 8*i));
+  des_key(&ref_ctx[k], kb);
+  ref_key[k] = key;
+  ref_valid[k] = 1;
+  return &ref_ctx[k];
+}
+
+/* procedure des_ref_c(key_hi, key_lo, data_hi, data_lo, encrypt : integer;
+                       out_hi, out_lo : out integer) */
+void des_ref_c(int32_t key_hi, int32_t key_lo, int32_t data_hi,
+               int32_t data_lo, int32_t encrypt, int32_t *out_hi,
+               int32_t *out_lo) {
+  uint64_t key = ((uint64_t) (uint32_t) key_hi << 32) | (uint32_t) key_lo;
+  des_ctx *dc = ref_schedule(key);
+  unsigned char db[8];
+  int i;
+
+  for (i=0; i<4; i++) {
+    db[i]   = (unsigned char) ((uint32_t) data_hi >> (24 - 8*i));
+    db[4+i] = (unsigned char) ((uint32_t) data_lo >> (24 - 8*i));
+  }
+  if (encrypt)
+    des_enc(dc, db, 1);
+  else
+    des_dec(dc, db, 1);
+  *out_hi = (int32_t) (((uint32_t) db[0] << 24) | ((uint32_t) db[1] << 16) |
+                       ((uint32_t) db[2] << 8) | db[3]);
+  *out_lo = (int32_t) (((uint32_t) db[4] << 24) | ((uint32_t) db[5] << 16) |
+                       ((uint32_t) db[6] << 8) | db[7]);
+  ref_calls++;
+}
+
+/* function des_ref_calls return integer: calls so far (for the tb's
+   summary) */
+int32_t des_ref_calls(void) {
+  return (int32_t) ref_calls;
+}
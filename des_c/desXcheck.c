@@ -0,0 +1,111 @@
+/* Check the differential cross-checker itself:
+ *
+ *   sampling   des_enc/des_dec through des_xcheck at several rates, in
+ *              random batch sizes: rate 1 must check every block, other
+ *              rates within 3% of blocks/rate, and nothing may mismatch
+ *              (rates above 100 run rate/100 times as many blocks, to
+ *              keep the expected error well inside 3%)
+ *   faults     an engine that corrupts one block per call, at rate 1:
+ *              every fault counted, and each faulty batch zeroed
+ *
+ *   gcc -O2 -pthread desXcheck.c -o desXcheck
+ *   ./desXcheck [-b blocks] [-s seed]
+ *
+ *   -b  blocks per rate (default 1 << 20)
+ */
+
+#define DES_NO_MAIN
+#include "des.c"
+#include <unistd.h>
+
+#define XC_BATCH 64                      /* largest batch in blocks */
+
+static unsigned long long xc_state = 0x5be0cd19137e2179ULL;
+
+static unsigned long long xc_rand(void) {
+  xc_state ^= xc_state << 13;
+  xc_state ^= xc_state >> 7;
+  xc_state ^= xc_state << 17;
+  return xc_state;
+}
+
+static long xc_faults;
+
+/* des_enc, then one random bit flipped in one random block.  The checker
+   may split a batch into several engine calls, so count them here. */
+static void xc_bad_enc(des_ctx *dc, unsigned char *data, int blocks) {
+  des_enc(dc, data, blocks);
+  xc_faults++;
+  data[xc_rand() % (8 * (unsigned) blocks)] ^=
+    (unsigned char) (1 << (xc_rand() % 8));
+}
+
+int main(int argc, char **argv) {
+  static const unsigned long rates[] = {1, 2, 3, 10, 100, 1000};
+  long blocks = 1L << 20, total, done;
+  unsigned long mismatches = 0;
+  unsigned char key[8], data[8*XC_BATCH], zero[8*XC_BATCH];
+  des_xcheck xc;
+  des_ctx dc;
+  double want, ratio;
+  int opt, i, n, bad;
+
+  while ((opt = getopt(argc, argv, "b:s:")) != -1) {
+    switch (opt) {
+    case 'b': blocks = atol(optarg); break;
+    case 's': xc_state = strtoull(optarg, NULL, 0) | 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-b blocks] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (blocks < 1)
+    blocks = 1;
+  for (i=0; i<8; i++)
+    key[i] = (unsigned char) xc_rand();
+  des_key(&dc, key);
+  for (i=0; i<8*XC_BATCH; i++)
+    data[i] = (unsigned char) xc_rand();
+
+  printf("%-8s %12s %12s %12s %8s\n", "rate", "blocks", "checked",
+         "blocks/rate", "ratio");
+  for (i=0; i<(int) (sizeof(rates)/sizeof(rates[0])); i++) {
+    total = rates[i] > 100 ? blocks * (long) (rates[i] / 100) : blocks;
+    des_xcheck_init(&xc, "des_enc", des_enc, des_dec, rates[i], 0);
+    for (done=0; done<total; done+=n) {
+      n = 1 + (int) (xc_rand() % XC_BATCH);
+      if (n > total - done)
+        n = (int) (total - done);
+      if (xc_rand() & 1)
+        des_xcheck_enc(&xc, &dc, data, n);
+      else
+        des_xcheck_dec(&xc, &dc, data, n);
+    }
+    want = (double) xc.blocks / rates[i];
+    ratio = xc.checked / want;
+    if (rates[i] == 1)
+      bad = xc.checked != xc.blocks;
+    else
+      bad = ratio < 0.97 || ratio > 1.03;
+    bad += xc.blocks != (unsigned long long) total || xc.mismatches != 0;
+    printf("%-8lu %12llu %12llu %12.0f %8.4f %s\n", rates[i], xc.blocks,
+           xc.checked, want, ratio, bad ? "MISMATCH" : "ok");
+    mismatches += bad;
+  }
+
+  /* a broken engine: one corrupt block per call, every one caught */
+  des_xcheck_init(&xc, "bad_enc", xc_bad_enc, des_dec, 1, 1);
+  memset(zero, 0, sizeof(zero));
+  for (bad=0, done=0; done<blocks; done+=n) {
+    n = 1 + (int) (xc_rand() % XC_BATCH);
+    bad += des_xcheck_enc(&xc, &dc, data, n) < 1;
+    bad += memcmp(data, zero, 8 * (size_t) n) != 0;
+    for (i=0; i<8*n; i++)
+      data[i] = (unsigned char) xc_rand();
+  }
+  bad += xc.mismatches != (unsigned long long) xc_faults;
+  printf("\nfaults   %12llu blocks, %ld faults, %llu caught %s\n", xc.blocks,
+         xc_faults, xc.mismatches, bad ? "MISMATCH" : "ok");
+  mismatches += bad;
+  return mismatches != 0;
+}
@@ -0,0 +1,144 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     block_top_tb.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Round-level testbench for block_top (one DES round: e_expansion_function, add_key, s_box, p_box,
+--      add_left) in isolation. Vectors come from des_c/desTraceGen -b, one round per line:
+--
+--          round L_in R_in key L_out R_out
+--
+--      block_top is combinational, so there is no clock or handshake: each vector is applied and checked
+--      STEP later. A failure names the block (line / 16), the round and the half that differs, and the summary
+--      counts failures per round, which points at the failing round without stepping through waveforms.
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- block_top.vhd
+--    |- add_key.vhd
+--    |
+--    |- add_left.vhd
+--    |
+--    |- e_expansion_function.vhd
+--    |
+--    |- p_box.vhd
+--    |
+--    |- s_box.vhd
+--        |- s1_box.vhd .. s8_box.vhd
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.std_logic_textio.all;
+use std.textio.all;
+
+entity block_top_tb is
+    Generic (
+        STEP        : time := 1 ns;                     -- settle time per vector
+        MAX_REPORTS : natural := 20;                    -- individual failures printed
+        VECTOR_FILE : string := "block_top_vectors.txt" -- written by des_c/desTraceGen -b
+    );
+end block_top_tb;
+
+architecture behavior of block_top_tb is
+
+    --=============================================================================================
+    -- Signals
+    --=============================================================================================
+    signal L_in             : std_logic_vector (0 to 31);   -- left half into the round
+    signal R_in             : std_logic_vector (0 to 31);   -- right half into the round
+    signal round_key        : std_logic_vector (0 to 47);   -- subkey K(i)
+    signal L_out            : std_logic_vector (0 to 31);   -- left half out of the round
+    signal R_out            : std_logic_vector (0 to 31);   -- right half out of the round
+
+begin
+
+    --=============================================================================================
+    -- INSTANTIATION FOR THE DEVICE UNDER TEST
+    --=============================================================================================
+	Inst_block_top_dut: entity work.block_top
+        port map(
+            L_in              => L_in,
+            R_in              => R_in,
+
+            L_out             => L_out,
+            R_out             => R_out,
+
+            round_key_des     => round_key
+        );
+
+    --=============================================================================================
+    -- TEST BENCH STIMULI
+    --=============================================================================================
+    tb1 : process is
+
+        type count_array is array (1 to 16) of natural;
+
+        file     vectors    : text open read_mode is VECTOR_FILE;
+        variable vline      : line;
+        variable round      : integer;
+        variable lin        : std_logic_vector (0 to 31);
+        variable rin        : std_logic_vector (0 to 31);
+        variable key        : std_logic_vector (0 to 47);
+        variable lout       : std_logic_vector (0 to 31);
+        variable rout       : std_logic_vector (0 to 31);
+        variable count      : natural := 0;
+        variable errors     : natural := 0;
+        variable per_round  : count_array := (others => 0);
+        variable halves     : line;
+
+    begin
+        while not endfile(vectors) loop
+            readline(vectors, vline);
+            next when vline'length = 0;
+            next when vline(vline'left) = '#';
+
+            read(vline, round);
+            hread(vline, lin);
+            hread(vline, rin);
+            hread(vline, key);
+            hread(vline, lout);
+            hread(vline, rout);
+
+            L_in      <= lin;
+            R_in      <= rin;
+            round_key <= key;
+            wait for STEP;
+
+            if L_out /= lout or R_out /= rout then
+                errors := errors + 1;
+                if round >= 1 and round <= 16 then
+                    per_round(round) := per_round(round) + 1;
+                end if;
+                if errors <= MAX_REPORTS then
+                    if R_out /= rout then
+                        write(halves, string'(" R_out"));
+                    end if;
+                    if L_out /= lout then
+                        write(halves, string'(" L_out"));
+                    end if;
+                    report "block " & integer'image(count / 16) & " round " & integer'image(round) &
+                           " failed:" & halves.all severity error;
+                    deallocate(halves);
+                end if;
+            end if;
+            count := count + 1;
+        end loop;
+
+        report "block_top_tb: " & integer'image(count) & " rounds, " & integer'image(errors) & " errors" severity note;
+        if errors > 0 then
+            for r in 1 to 16 loop
+                if per_round(r) > 0 then
+                    report "  round " & integer'image(r) & ": " & integer'image(per_round(r)) & " failures"
+                        severity note;
+                end if;
+            end loop;
+        end if;
+        wait; -- stop simulation
+    end process tb1;
+    --  End Test Bench
+END;
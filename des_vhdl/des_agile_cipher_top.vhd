@@ -0,0 +1,162 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     des_agile_cipher_top.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Key-agile variant of des_cipher_top: every block may use a different key without a reset in between.
+--      The key is loaded with its own strobe, key_valid, and expanded into the shadow bank of key_schedule_agile
+--      while the current block is still running. The block that starts next takes the newest key.
+--
+--          key_in + key_valid      strobe a key (it applies to the next block that starts)
+--          data_in + lddata        strobe a block (function_select is sampled with it); it waits in the input
+--                                  register until the core is free
+--
+--      Strobing key and data on the same edge runs that block with that key. Strobing both while a block runs
+--      queues one block behind it, so the key change costs no cycles. des_c/desAgileSim.c is the
+--      cycle-accurate model and measures blocks/cycle against the reset-and-rekey protocol of des_cipher_top.
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- des_agile_cipher_top.vhd
+--    |- des_agile_top.vhd
+--      |- block_top.vhd
+--    |- key_schedule_agile.vhd
+--      |- key_schedule.vhd
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.STD_LOGIC_ARITH.ALL;
+use IEEE.STD_LOGIC_UNSIGNED.ALL;
+
+entity des_agile_cipher_top is
+port(
+		--
+		-- Core Interface 
+		--
+		key_in:				in std_logic_vector(0 to 63);		-- input for key
+		key_valid:			in std_logic;							-- key strobe (active high)
+
+		function_select:	in	std_logic; 							-- function	select: '1' = encryption, '0' = decryption
+
+		data_in:				in std_logic_vector(0 to 63);		-- input for data
+
+		data_out:			out std_logic_vector(0 to 63);	-- output for data
+
+		lddata:				in 	std_logic;						-- data strobe (active high)
+		core_busy:			out	std_logic;						-- active high when encrypting/decryption data 
+		des_out_rdy:		out	std_logic;						-- active high when encryption/decryption of data is done	
+
+		reset: 				in std_logic;							-- active high
+		clock: 				in std_logic							-- master clock
+	);
+end des_agile_cipher_top;
+
+architecture Behavioral of des_agile_cipher_top is
+
+component key_schedule_agile is
+port (
+		key_in:			in std_logic_vector(0 to 63);		-- key to be expanded
+		key_valid:		in std_logic;							-- key strobe (active high)
+
+		KeySelect: 		in std_logic_vector(3 downto 0);	-- selector for key (active bank)
+    	key_out: 		out std_logic_vector(0 to 47);	-- expaned key output
+		key_swap:		in std_logic;							-- block starts: switch to the newest key
+		key_ready: 		out std_logic;							-- a key has been strobed since reset
+
+		reset: 			in std_logic; 							-- reset
+		clock: 			in std_logic  							-- master clock
+		);
+end component;
+
+component des_agile_top is
+port (
+		-- Main Data
+		key_round_in:	in 	std_logic_vector(0 to 47);
+		data_in:			in 	std_logic_vector(0 to 63);
+		data_out:		out 	std_logic_vector(0 to 63);
+
+		-- Signals for communication with the key schedule
+		KeySelect: 		inout std_logic_vector(3 downto 0);	-- selector for key
+		key_ready: 		in std_logic;								-- a key has been strobed
+		key_swap: 		out std_logic;								-- a block starts: activate the newest key
+		data_ready: 	in std_logic;								-- a block is waiting in the input register
+		func_select:	in std_logic;
+
+		des_out_rdy: 	out std_logic;
+		core_busy: 		out std_logic;	
+
+		reset: 			in std_logic; 
+		clock: 			in std_logic  								-- master clock
+		);
+end component;
+
+signal key_select_internal: std_logic_vector(3 downto 0);
+signal key_round_internal: std_logic_vector(0 to 47);
+signal key_ready_internal: std_logic;
+signal key_swap_internal: std_logic;
+signal data_in_internal: std_logic_vector(0 to 63);
+signal data_ready_internal: std_logic;
+signal func_internal: std_logic;
+
+begin
+
+--
+-- Input register: holds one block until the core takes it (key_swap marks the edge it is taken)
+--
+process (clock)
+begin
+
+if rising_edge(clock) then
+
+		if reset = '1' then
+			data_ready_internal	<= '0';
+		elsif lddata = '1' then
+			-- capute data from the bus
+			data_in_internal 		<= data_in; -- register data from the bus
+			func_internal			<= function_select;	-- the function travels with its block
+			data_ready_internal	<= '1';		-- data has been loaded: continue with encryptio/decryption   
+		elsif key_swap_internal = '1' then
+			data_ready_internal	<= '0';		-- the core has taken the block: wait for the next one
+		end if;
+
+end if;
+
+end process;
+
+--
+-- KEY EXPANDER AND DES CORE instantiation
+--
+KEYSCHEDULE: key_schedule_agile 
+port map (
+		KeySelect 	=> key_select_internal,
+		key_in 		=> key_in,
+		key_valid	=> key_valid,
+		key_out 		=> key_round_internal,
+		key_swap		=> key_swap_internal,
+		key_ready 	=> key_ready_internal,
+		reset 		=> reset,
+		clock 		=> clock
+);
+
+DESTOP: des_agile_top 
+port map (
+		key_round_in 	=> key_round_internal,
+		data_in		 	=> data_in_internal,
+		key_ready 		=> key_ready_internal,
+		key_swap			=> key_swap_internal,
+		data_ready 		=> data_ready_internal,
+		KeySelect 		=> key_select_internal,
+		func_select 	=> func_internal,
+		data_out 		=> data_out,
+		core_busy 		=> core_busy,
+		des_out_rdy 	=> des_out_rdy,
+		reset 			=> reset,
+		clock 			=> clock
+);
+
+end Behavioral;
@@ -0,0 +1,228 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     des_agile_cipher_top_tb.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Key-agile testbench for des_agile_cipher_top: a different key on every block, no reset between blocks.
+--      Vectors come from a text file written by des_c/desAgileSim.c -o, one block per line:
+--
+--          key func datain dataout         (func: 1 = encrypt, 0 = decrypt)
+--
+--      The driver strobes key_valid and lddata together for one clock with each block's key, function and data,
+--      then waits until the core has taken that block (core_busy rises) before it strobes the next one. So the
+--      next key is expanded into the shadow bank while the current block runs. A separate checker compares each
+--      des_out_rdy cycle against the next expected output. At the end the achieved blocks per cycle is reported
+--      (desAgileSim.c predicts 1/18, against 1/20 for des_cipher_top with a reset per key).
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- des_agile_cipher_top.vhd
+--    |- des_agile_top.vhd
+--      |- block_top.vhd
+--    |- key_schedule_agile.vhd
+--      |- key_schedule.vhd
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.std_logic_textio.all;
+use std.textio.all;
+
+entity des_agile_cipher_top_tb is
+    Generic (
+        CLK_PERIOD  : time := 10 ns;                    -- clock period (default 100MHz)
+        VECTOR_FILE : string := "des_agile_vectors.txt"  -- written by des_c/desAgileSim.c -o
+    );
+end des_agile_cipher_top_tb;
+
+architecture behavior of des_agile_cipher_top_tb is
+
+    --=============================================================================================
+    -- Constants
+    --=============================================================================================
+    -- clock period
+    constant CLOCK_PERIOD : time := CLK_PERIOD;          -- clock
+    -- cycles without a result before the checker gives up
+    constant WATCHDOG     : natural := 64;
+
+    --=============================================================================================
+    -- Signals
+    --=============================================================================================
+    --- clock and reset signals ---
+    signal clock            : std_logic := '1';                 -- 100MHz clock
+    signal reset            : std_logic := '1';                 -- reset active high
+    signal done             : boolean := false;                 -- stops the clock after the last result
+    --- input data ---
+    signal key_in           : std_logic_vector (0 to 63);   -- key input
+    signal key_valid        : std_logic := '0';                 -- key strobe (active high)
+    signal data_in          : std_logic_vector (0 to 63);   -- data input
+    --- control signals ---
+    signal funct_select     : std_logic;                        -- function select: '1' = encryption, '0' = decryption
+    signal lddata           : std_logic := '0';                 -- data strobe (active high)
+    signal core_busy        : std_logic;
+    signal des_out_rdy      : std_logic;
+    --- output data ---
+    signal data_out         : std_logic_vector (0 to 63);   -- data output
+    --- statistics ---
+    signal cycles           : natural := 0;                     -- rising edges since reset was released
+    signal first_load       : natural := 0;                     -- cycle of the first block
+
+begin
+
+    --=============================================================================================
+    -- INSTANTIATION FOR THE DEVICE UNDER TEST
+    --=============================================================================================
+	Inst_des_agile_cipher_top_dut: entity work.des_agile_cipher_top
+        port map(
+            --
+            -- Core Interface
+            --
+            key_in            => key_in,            -- input for key
+            key_valid         => key_valid,         -- key strobe (active high)
+
+            function_select   => funct_select,      -- function	select: '1' = encryption, '0' = decryption
+
+            data_in           => data_in,           -- input for data
+
+            data_out          => data_out,          -- output for data
+
+            lddata            => lddata,            -- data strobe (active high)
+            core_busy         => core_busy,         -- active high while a block is being processed
+            des_out_rdy       => des_out_rdy,       -- active high for one cycle per finished block
+
+            reset             => reset,             -- active high
+            clock             => clock              -- master clock
+
+        );
+
+    --=============================================================================================
+    -- CLOCK GENERATION
+    --=============================================================================================
+    clock_proc: process is
+    begin
+        while not done loop
+            clock <= not clock;
+            wait for CLOCK_PERIOD / 2;
+        end loop;
+        wait;
+    end process clock_proc;
+
+    cycle_count: process (clock) is
+    begin
+        if rising_edge(clock) and reset = '0' then
+            cycles <= cycles + 1;
+        end if;
+    end process cycle_count;
+
+    --=============================================================================================
+    -- DRIVER: key and block strobed together, the next pair as soon as the core takes a block
+    --=============================================================================================
+    driver : process is
+
+        file     vectors    : text open read_mode is VECTOR_FILE;
+        variable vline      : line;
+        variable key        : std_logic_vector (0 to 63);
+        variable func       : integer;
+        variable datain     : std_logic_vector (0 to 63);
+        variable dataout    : std_logic_vector (0 to 63);
+        variable first      : boolean := true;
+
+    begin
+        reset <= '1';
+        wait until falling_edge(clock);
+        wait until falling_edge(clock);
+        reset <= '0';
+
+        while not endfile(vectors) loop
+            readline(vectors, vline);
+            next when vline'length = 0;
+            next when vline(vline'left) = '#';
+
+            hread(vline, key);
+            read(vline, func);
+            hread(vline, datain);
+            hread(vline, dataout);
+
+            if first then
+                first_load <= cycles;
+                first := false;
+            else
+                -- wait until the previous block has been taken (core_busy rises)
+                wait until falling_edge(clock) and core_busy = '1';
+            end if;
+
+            key_in <= key;
+            data_in <= datain;
+            if func = 1 then
+                funct_select <= '1';
+            else
+                funct_select <= '0';
+            end if;
+            key_valid <= '1';
+            lddata <= '1';
+            wait until falling_edge(clock);
+            key_valid <= '0';
+            lddata <= '0';
+            -- core_busy may still be high from the block in flight: let it drop first
+            if core_busy = '1' then
+                wait until falling_edge(clock) and core_busy = '0';
+            end if;
+        end loop;
+
+        lddata <= '0';
+        wait; -- all blocks issued
+    end process driver;
+
+    --=============================================================================================
+    -- CHECKER: compares results in issue order
+    --=============================================================================================
+    checker : process is
+
+        file     vectors    : text open read_mode is VECTOR_FILE;
+        variable vline      : line;
+        variable key        : std_logic_vector (0 to 63);
+        variable func       : integer;
+        variable datain     : std_logic_vector (0 to 63);
+        variable dataout    : std_logic_vector (0 to 63);
+        variable count      : natural := 0;
+        variable errors     : natural := 0;
+        variable waited     : natural;
+
+    begin
+        while not endfile(vectors) loop
+            readline(vectors, vline);
+            next when vline'length = 0;
+            next when vline(vline'left) = '#';
+
+            hread(vline, key);
+            read(vline, func);
+            hread(vline, datain);
+            hread(vline, dataout);
+
+            waited := 0;
+            loop
+                wait until falling_edge(clock);
+                exit when des_out_rdy = '1';
+                waited := waited + 1;
+                assert waited < WATCHDOG report "no result for block " & integer'image(count) severity failure;
+            end loop;
+
+            if data_out /= dataout then
+                errors := errors + 1;
+                report "block " & integer'image(count) & " failed" severity error;
+            end if;
+            count := count + 1;
+        end loop;
+
+        report "des_agile_cipher_top_tb: " & integer'image(count) & " blocks, " & integer'image(errors) & " errors, " &
+               integer'image(cycles - first_load) & " cycles (" &
+               integer'image((1000 * count) / (cycles - first_load)) & "/1000 blocks per cycle)" severity note;
+        done <= true;
+        wait; -- stop simulation
+    end process checker;
+    --  End Test Bench
+END;
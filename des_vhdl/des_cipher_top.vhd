@@ -98,6 +98,7 @@ port (
 		-- signals for communication with des top
 		KeySelect: 		in std_logic_vector(3 downto 0);	-- selector for key
     	key_out: 		out std_logic_vector(0 to 47);	-- expaned key (depends on selector)
+		key_all_out:	out std_logic_vector(0 to 767);	-- all expanded keys (unused here)
 		key_ready: 		out std_logic;							-- signal for the core that key has been expanded
 	
 		reset: in std_logic; 									-- active high
@@ -164,6 +165,7 @@ port map (
 		key_in 		=> key_in,
 		
 		key_out 		=> key_round_internal,
+		key_all_out		=> open,
 		key_ready 	=> key_ready_internal,
 
 		reset 		=> reset,
@@ -0,0 +1,200 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     des_cipher_top_file_tb.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      File-driven testbench for the des_cipher_top engine.
+--      Same stimulus protocol as des_cipher_top_tb.vhd (reset, load key and data, wait for des_out_rdy) but the
+--      vectors are streamed at run time from a text file written by des_c/desVectors.c, one vector per line:
+--
+--          key1 key2 key3 datain dataout1 dataout2 dataout3
+--
+--      Each vector is triple-encrypted (key1, key2, key3) and triple-decrypted (key3, key2, key1). Lines that are
+--      empty or start with '#' are skipped. The source does not grow with the vector count, so elaboration time
+--      stays flat from 10 vectors to 10^6. The clock stops after the last vector, so the simulation ends by itself.
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- des_cipher_top.vhd
+--    |- des_top.vhd
+--      |- block_top.vhd
+--        |- add_key.vhd
+--        |
+--        |- add_left.vhd
+--        |
+--        |- e_expansion_function.vhd
+--        |
+--        |- p_box.vhd
+--        |
+--        |- s_box.vhd
+--            |- s1_box.vhd
+--            |- s2_box.vhd
+--            |- s3_box.vhd
+--            |- s4_box.vhd
+--            |- s5_box.vhd
+--            |- s6_box.vhd
+--            |- s7_box.vhd
+--            |- s8_box.vhd
+--    |- key_schedule.vhd
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.std_logic_textio.all;
+use std.textio.all;
+
+entity des_cipher_top_file_tb is
+    Generic (
+        CLK_PERIOD  : time := 10 ns;                    -- clock period (default 100MHz)
+        VECTOR_FILE : string := "des_vectors.txt"       -- written by des_c/desVectors.c
+    );
+end des_cipher_top_file_tb;
+
+architecture behavior of des_cipher_top_file_tb is
+
+    --=============================================================================================
+    -- Constants
+    --=============================================================================================
+    -- clock period
+    constant CLOCK_PERIOD : time := CLK_PERIOD;          -- clock
+
+    --=============================================================================================
+    -- Signals
+    --=============================================================================================
+    --- clock and reset signals ---
+    signal clock            : std_logic := '1';                 -- 100MHz clock
+    signal reset            : std_logic := '1';                 -- reset active high
+    signal done             : boolean := false;                 -- stops the clock after the last vector
+    --- input data ---
+    signal key_in           : std_logic_vector (0 to 63);   -- key input
+    signal data_in          : std_logic_vector (0 to 63);   -- data input
+    --- control signals ---
+    signal funct_select     : std_logic;                        -- function select: '1' = encryption, '0' = decryption
+    signal lddata           : std_logic;                        -- data strobe (active high)
+    signal core_busy        : std_logic;
+    signal des_out_rdy      : std_logic;
+    --- output data ---
+    signal data_out         : std_logic_vector (0 to 63);   -- data output
+
+begin
+
+    --=============================================================================================
+    -- INSTANTIATION FOR THE DEVICE UNDER TEST
+    --=============================================================================================
+	Inst_des_cipher_top_dut: entity work.des_cipher_top
+        port map(
+            --
+            -- Core Interface
+            --
+            key_in            => key_in,            -- input for key
+
+            function_select   => funct_select,      -- function	select: '1' = encryption, '0' = decryption
+
+            data_in           => data_in,           -- input for data
+
+            data_out          => data_out,          -- output for data
+
+            lddata            => lddata,            -- data strobe (active high)
+            core_busy         => core_busy,         -- active high when encrypting/decryption data
+            des_out_rdy       => des_out_rdy,       -- active high when encryption/decryption of data is done
+
+            reset             => reset,             -- active high
+            clock             => clock              -- master clock
+
+        );
+
+    --=============================================================================================
+    -- CLOCK GENERATION
+    --=============================================================================================
+    clock_proc: process is
+    begin
+        while not done loop
+            clock <= not clock;
+            wait for CLOCK_PERIOD / 2;
+        end loop;
+        wait;
+    end process clock_proc;
+
+    --=============================================================================================
+    -- TEST BENCH STIMULI
+    --=============================================================================================
+    tb1 : process is
+
+        file     vectors    : text open read_mode is VECTOR_FILE;
+        variable vline      : line;
+        variable key1       : std_logic_vector (0 to 63);
+        variable key2       : std_logic_vector (0 to 63);
+        variable key3       : std_logic_vector (0 to 63);
+        variable datain     : std_logic_vector (0 to 63);
+        variable dataout1   : std_logic_vector (0 to 63);
+        variable dataout2   : std_logic_vector (0 to 63);
+        variable dataout3   : std_logic_vector (0 to 63);
+        variable count      : natural := 0;
+        variable errors     : natural := 0;
+
+        -- one DES operation, driven exactly like des_cipher_top_tb.vhd
+        procedure des_op (
+            constant key      : in std_logic_vector (0 to 63);
+            constant func     : in std_logic;
+            constant data     : in std_logic_vector (0 to 63);
+            constant expected : in std_logic_vector (0 to 63);
+            constant gap      : in natural;
+            constant what     : in string
+        ) is
+        begin
+            wait for CLOCK_PERIOD*gap;
+            reset <= '1';
+            wait for CLOCK_PERIOD; -- wait until reset completes
+            reset <= '0';
+            -----------------------------
+            key_in            <= key;
+            funct_select      <= func;
+            data_in           <= data;
+            lddata            <= '1';
+            wait until des_out_rdy = '1';
+
+            if data_out /= expected then
+                errors := errors + 1;
+                report "vector " & integer'image(count) & " " & what & " failed" severity error;
+            end if;
+        end procedure des_op;
+
+    begin
+        reset <= '1';
+
+        while not endfile(vectors) loop
+            readline(vectors, vline);
+            next when vline'length = 0;
+            next when vline(vline'left) = '#';
+
+            hread(vline, key1);
+            hread(vline, key2);
+            hread(vline, key3);
+            hread(vline, datain);
+            hread(vline, dataout1);
+            hread(vline, dataout2);
+            hread(vline, dataout3);
+            count := count + 1;
+
+            -- triple encryption
+            des_op(key1, '1', datain,   dataout1, 0, "encrypt key1");
+            des_op(key2, '1', dataout1, dataout2, 0, "encrypt key2");
+            des_op(key3, '1', dataout2, dataout3, 0, "encrypt key3");
+            -------------------------------------------------------------------------------------------
+            -- triple decryption
+            des_op(key3, '0', dataout3, dataout2, 5, "decrypt key3");
+            des_op(key2, '0', dataout2, dataout1, 5, "decrypt key2");
+            des_op(key1, '0', dataout1, datain,   5, "decrypt key1");
+        end loop;
+
+        report "des_cipher_top_file_tb: " & integer'image(count) & " vectors, " &
+               integer'image(errors) & " errors" severity note;
+        done <= true;
+        wait; -- stop simulation
+    end process tb1;
+    --  End Test Bench
+END;
@@ -0,0 +1,190 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     des_cipher_top_ref_tb.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Self-checking testbench for the des_cipher_top engine.
+--      Stimulus is generated inside the simulation and every expected data_out comes from the C engine at run
+--      time (des_ref_pkg.vhd, des_c/desVhpi.c), so no vector or expected-value files are involved. Same
+--      reset/load/wait protocol as des_cipher_top_tb.vhd.
+--
+--          STIMULUS = 0   N_VECTORS random keys and blocks (xorshift64, SEED); each block is encrypted and the
+--                         result decrypted again
+--          STIMULUS = 1   exhaustive walking ones: every single-bit key against every single-bit block
+--                         (64 x 64 encryptions; N_VECTORS is ignored)
+--
+--          gcc -O2 -pthread -c -fPIC ../des_c/desVhpi.c -o desVhpi.o
+--          ghdl -a --std=93c --ieee=synopsys -fexplicit <design files> des_ref_pkg.vhd des_cipher_top_ref_tb.vhd
+--          ghdl -e --std=93c --ieee=synopsys -fexplicit -Wl,desVhpi.o -Wl,-pthread des_cipher_top_ref_tb
+--          ghdl -r des_cipher_top_ref_tb -gN_VECTORS=100000
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- des_cipher_top.vhd
+--    |- des_top.vhd
+--      |- block_top.vhd
+--    |- key_schedule.vhd
+--  |- des_ref_pkg.vhd (-> des_c/desVhpi.c)
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.des_ref_pkg.all;
+
+entity des_cipher_top_ref_tb is
+    Generic (
+        CLK_PERIOD  : time := 10 ns;                    -- clock period (default 100MHz)
+        STIMULUS    : natural := 0;                     -- 0 = random, 1 = walking ones
+        N_VECTORS   : natural := 1000;                  -- random vectors
+        SEED        : natural := 1                      -- random seed
+    );
+end des_cipher_top_ref_tb;
+
+architecture behavior of des_cipher_top_ref_tb is
+
+    --=============================================================================================
+    -- Constants
+    --=============================================================================================
+    -- clock period
+    constant CLOCK_PERIOD : time := CLK_PERIOD;          -- clock
+
+    --=============================================================================================
+    -- Signals
+    --=============================================================================================
+    --- clock and reset signals ---
+    signal clock            : std_logic := '1';                 -- 100MHz clock
+    signal reset            : std_logic := '1';                 -- reset active high
+    signal done             : boolean := false;                 -- stops the clock after the last vector
+    --- input data ---
+    signal key_in           : std_logic_vector (0 to 63);   -- key input
+    signal data_in          : std_logic_vector (0 to 63);   -- data input
+    --- control signals ---
+    signal funct_select     : std_logic;                        -- function select: '1' = encryption, '0' = decryption
+    signal lddata           : std_logic;                        -- data strobe (active high)
+    signal core_busy        : std_logic;
+    signal des_out_rdy      : std_logic;
+    --- output data ---
+    signal data_out         : std_logic_vector (0 to 63);   -- data output
+
+begin
+
+    --=============================================================================================
+    -- INSTANTIATION FOR THE DEVICE UNDER TEST
+    --=============================================================================================
+	Inst_des_cipher_top_dut: entity work.des_cipher_top
+        port map(
+            --
+            -- Core Interface
+            --
+            key_in            => key_in,            -- input for key
+
+            function_select   => funct_select,      -- function	select: '1' = encryption, '0' = decryption
+
+            data_in           => data_in,           -- input for data
+
+            data_out          => data_out,          -- output for data
+
+            lddata            => lddata,            -- data strobe (active high)
+            core_busy         => core_busy,         -- active high when encrypting/decryption data
+            des_out_rdy       => des_out_rdy,       -- active high when encryption/decryption of data is done
+
+            reset             => reset,             -- active high
+            clock             => clock              -- master clock
+
+        );
+
+    --=============================================================================================
+    -- CLOCK GENERATION
+    --=============================================================================================
+    clock_proc: process is
+    begin
+        while not done loop
+            clock <= not clock;
+            wait for CLOCK_PERIOD / 2;
+        end loop;
+        wait;
+    end process clock_proc;
+
+    --=============================================================================================
+    -- TEST BENCH STIMULI
+    --=============================================================================================
+    tb1 : process is
+
+        variable state      : unsigned (63 downto 0);
+        variable key        : std_logic_vector (0 to 63);
+        variable datain     : std_logic_vector (0 to 63);
+        variable result     : std_logic_vector (0 to 63);
+        variable count      : natural := 0;
+        variable errors     : natural := 0;
+
+        -- xorshift64, as the C generators use
+        procedure next_random (variable value : out std_logic_vector (0 to 63)) is
+        begin
+            state := state xor shift_left(state, 13);
+            state := state xor shift_right(state, 7);
+            state := state xor shift_left(state, 17);
+            value := std_logic_vector(state);
+        end procedure next_random;
+
+        -- one DES operation, driven exactly like des_cipher_top_tb.vhd; returns data_out
+        procedure des_op (
+            constant key      : in std_logic_vector (0 to 63);
+            constant func     : in std_logic;
+            constant data     : in std_logic_vector (0 to 63);
+            variable output   : out std_logic_vector (0 to 63)
+        ) is
+            variable expected : std_logic_vector (0 to 63);
+        begin
+            expected := des_ref(key, func, data);
+            reset <= '1';
+            wait for CLOCK_PERIOD; -- wait until reset completes
+            reset <= '0';
+            -----------------------------
+            key_in            <= key;
+            funct_select      <= func;
+            data_in           <= data;
+            lddata            <= '1';
+            wait until des_out_rdy = '1';
+
+            count := count + 1;
+            if data_out /= expected then
+                errors := errors + 1;
+                report "operation " & integer'image(count) & " failed" severity error;
+            end if;
+            output := data_out;
+        end procedure des_op;
+
+    begin
+        reset <= '1';
+        state := to_unsigned(SEED, 64) xor x"9e3779b97f4a7c15";
+
+        if STIMULUS = 1 then
+            for k in 0 to 63 loop
+                for d in 0 to 63 loop
+                    key := (others => '0');
+                    key(k) := '1';
+                    datain := (others => '0');
+                    datain(d) := '1';
+                    des_op(key, '1', datain, result);
+                end loop;
+            end loop;
+        else
+            for v in 1 to N_VECTORS loop
+                next_random(key);
+                next_random(datain);
+                des_op(key, '1', datain, result);
+                des_op(key, '0', result, result);
+            end loop;
+        end if;
+
+        report "des_cipher_top_ref_tb: " & integer'image(count) & " operations, " &
+               integer'image(errors) & " errors, " & integer'image(des_ref_calls) & " reference calls" severity note;
+        done <= true;
+        wait; -- stop simulation
+    end process tb1;
+    --  End Test Bench
+END;
@@ -0,0 +1,216 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     des_pipe_top.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Fully pipelined variant of des_cipher_top.
+--      des_top reuses one block_top for all 16 rounds, so a block occupies the core for ~19 cycles. Here the 16
+--      rounds are unrolled into 16 block_top instances with a register after each one, and every stage takes its
+--      own subkey from key_schedule's key_all_out. A new block can be loaded on every clock edge; its result
+--      appears on data_out 16 edges later with des_out_rdy high for one cycle, in the order the blocks went in.
+--
+--      function_select is sampled with each block and travels down the pipeline with it, so encryption and
+--      decryption can be mixed freely. key_in is captured by key_schedule on every edge: present a new key on
+--      the same edge as the first block that uses it, and only once the blocks under the old key have drained
+--      (core_busy = '0').
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- des_pipe_top.vhd
+--    |- block_top.vhd (x16)
+--      |- add_key.vhd
+--      |
+--      |- add_left.vhd
+--      |
+--      |- e_expansion_function.vhd
+--      |
+--      |- p_box.vhd
+--      |
+--      |- s_box.vhd
+--          |- s1_box.vhd .. s8_box.vhd
+--    |- key_schedule.vhd
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.STD_LOGIC_ARITH.ALL;
+use IEEE.STD_LOGIC_UNSIGNED.ALL;
+
+entity des_pipe_top is
+port(
+		--
+		-- Core Interface
+		--
+		key_in:				in std_logic_vector(0 to 63);		-- input for key
+		function_select:	in	std_logic; 							-- function	select: '1' = encryption, '0' = decryption
+
+		data_in:				in std_logic_vector(0 to 63);		-- input for data
+
+		data_out:			out std_logic_vector(0 to 63);	-- output for data
+
+		lddata:				in 	std_logic;						-- data strobe (active high), one block per clock
+		core_busy:			out	std_logic;						-- active high while any block is in the pipeline
+		des_out_rdy:		out	std_logic;						-- active high for one cycle per finished block
+
+		reset: 				in std_logic;							-- active high
+		clock: 				in std_logic							-- master clock
+
+	);
+end des_pipe_top;
+
+architecture Behavioral of des_pipe_top is
+
+component key_schedule is
+port (
+		key_in:			in std_logic_vector(0 to 63);		-- input for key
+
+		KeySelect: 		in std_logic_vector(3 downto 0);	-- selector for key
+    	key_out: 		out std_logic_vector(0 to 47);	-- expaned key (depends on selector)
+		key_all_out:	out std_logic_vector(0 to 767);	-- all expanded keys, K1 first
+		key_ready: 		out std_logic;							-- signal for the core that key has been expanded
+
+		reset: in std_logic; 									-- active high
+		clock: in std_logic  									-- master clock
+		);
+end component;
+
+component block_top is
+port(
+		L_in: in std_logic_vector(0 to 31);				-- left permuted input
+		R_in: in std_logic_vector(0 to 31);				-- right permuted input
+
+		L_out: out std_logic_vector(0 to 31);			-- left permuted output
+		R_out: out std_logic_vector(0 to 31);			-- right permuted output
+
+		round_key_des: in std_logic_vector(0 to 47)	-- current round key
+
+	);
+end component;
+
+--
+-- Pipeline registers: stage 0 holds the block after IP, stage i (1..15) after round i.
+-- Round 16 feeds the inverse IP and data_out directly.
+--
+type half_array is array (0 to 16) of std_logic_vector(0 to 31);
+type key_array is array (1 to 16) of std_logic_vector(0 to 47);
+
+signal L_pipe, R_pipe: 		half_array;			-- stage registers (0 to 15 used)
+signal L_round, R_round: 	half_array;			-- block_top outputs (1 to 16 used)
+signal V_pipe: 				std_logic_vector(0 to 15);		-- stage holds a valid block
+signal F_pipe: 				std_logic_vector(0 to 15);		-- function select of that block
+signal round_key: 			key_array;
+signal key_all_internal: 	std_logic_vector(0 to 767);
+
+constant KEY_SELECT_UNUSED: std_logic_vector(3 downto 0) := "0000";		-- key_out is not used here
+
+begin
+
+process (clock)
+begin
+	if rising_edge(clock) then
+		if reset = '1' then
+
+			V_pipe			<= (others => '0');
+			des_out_rdy		<= '0';
+
+		else
+
+			--
+			-- Stage 0: initial permutation of the incoming block
+			--
+			V_pipe(0) <= lddata;
+			F_pipe(0) <= function_select;
+
+			L_pipe(0) <= 	data_in(57) & data_in(49) & data_in(41) & data_in(33) & data_in(25) & data_in(17) &
+								data_in(9) & data_in(1) & data_in(59) & data_in(51) & data_in(43) & data_in(35) &
+								data_in(27) & data_in(19) & data_in(11) & data_in(3) & data_in(61) & data_in(53) &
+								data_in(45) & data_in(37) & data_in(29) & data_in(21) & data_in(13) & data_in(5) &
+								data_in(63) & data_in(55) & data_in(47) & data_in(39) & data_in(31) & data_in(23) &
+								data_in(15) & data_in(7);
+
+			R_pipe(0) <= 	data_in(56) & data_in(48) & data_in(40) & data_in(32) & data_in(24) & data_in(16) &
+								data_in(8) & data_in(0) & data_in(58) & data_in(50) & data_in(42) & data_in(34) &
+								data_in(26) & data_in(18) & data_in(10) & data_in(2) & data_in(60) & data_in(52) &
+								data_in(44) & data_in(36) & data_in(28) & data_in(20) & data_in(12) & data_in(4) &
+								data_in(62) & data_in(54) & data_in(46) & data_in(38) & data_in(30) & data_in(22) &
+								data_in(14) & data_in(6);
+
+			--
+			-- Stages 1..15: one round each
+			--
+			for i in 1 to 15 loop
+				L_pipe(i) <= L_round(i);
+				R_pipe(i) <= R_round(i);
+				V_pipe(i) <= V_pipe(i-1);
+				F_pipe(i) <= F_pipe(i-1);
+			end loop;
+
+			--
+			-- Round 16 and inverse initial permutation
+			--
+			data_out	<=	L_round(16)(7) & R_round(16)(7) & L_round(16)(15) & R_round(16)(15) &
+							L_round(16)(23) & R_round(16)(23) & L_round(16)(31) & R_round(16)(31) &
+							L_round(16)(6) & R_round(16)(6) & L_round(16)(14) & R_round(16)(14) &
+							L_round(16)(22) & R_round(16)(22) & L_round(16)(30) & R_round(16)(30) &
+							L_round(16)(5) & R_round(16)(5) & L_round(16)(13) & R_round(16)(13) &
+							L_round(16)(21) & R_round(16)(21) & L_round(16)(29) & R_round(16)(29) &
+							L_round(16)(4) & R_round(16)(4) & L_round(16)(12) & R_round(16)(12) &
+							L_round(16)(20) & R_round(16)(20) & L_round(16)(28) & R_round(16)(28) &
+							L_round(16)(3) & R_round(16)(3) & L_round(16)(11) & R_round(16)(11) &
+							L_round(16)(19) & R_round(16)(19) & L_round(16)(27) & R_round(16)(27) &
+							L_round(16)(2) & R_round(16)(2) & L_round(16)(10) & R_round(16)(10) &
+							L_round(16)(18) & R_round(16)(18) & L_round(16)(26) & R_round(16)(26) &
+							L_round(16)(1) & R_round(16)(1) & L_round(16)(9) & R_round(16)(9) &
+							L_round(16)(17) & R_round(16)(17) & L_round(16)(25) & R_round(16)(25) &
+							L_round(16)(0) & R_round(16)(0) & L_round(16)(8) & R_round(16)(8) &
+							L_round(16)(16) & R_round(16)(16) & L_round(16)(24) & R_round(16)(24);
+
+			des_out_rdy <= V_pipe(15);
+
+		end if;
+	end if;
+end process;
+
+core_busy <= '0' when V_pipe = x"0000" else '1';
+
+--
+-- Instantations
+--
+KEYSCHEDULE: key_schedule
+port map (
+
+		KeySelect 	=> KEY_SELECT_UNUSED,
+		key_in 		=> key_in,
+
+		key_out 		=> open,
+		key_all_out	=> key_all_internal,
+		key_ready 	=> open,
+
+		reset 		=> reset,
+		clock 		=> clock
+);
+
+ROUNDS: for i in 1 to 16 generate
+
+	-- encryption uses K1..K16 in stage order, decryption K16..K1
+	round_key(i) <= key_all_internal(48*(i-1) to 48*i-1) when F_pipe(i-1) = '1' else
+						 key_all_internal(48*(16-i) to 48*(17-i)-1);
+
+	BLOCKTOP: block_top
+	port map (
+			L_in 				=> L_pipe(i-1),
+			R_in 				=> R_pipe(i-1),
+
+			round_key_des 	=> round_key(i),
+
+			L_out 			=> L_round(i),
+			R_out 			=>	R_round(i)
+	);
+
+end generate;
+
+end Behavioral;
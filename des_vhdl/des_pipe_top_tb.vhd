@@ -0,0 +1,231 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     des_pipe_top_tb.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Throughput testbench for the pipelined des_pipe_top engine.
+--      Vectors come from a text file written by des_c/desPipeSim.c -o, one block per line:
+--
+--          key func datain dataout         (func: 1 = encrypt, 0 = decrypt)
+--
+--      The driver offers one block on every clock. When the key changes it holds lddata low until the pipeline
+--      has drained (core_busy = '0') and presents the new key together with the first block that uses it. A
+--      separate checker reads the same file and compares each des_out_rdy cycle against the next expected
+--      output, so blocks are checked in the order they went in. At the end the achieved blocks per cycle is
+--      reported; with no key changes it approaches 1.
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- des_pipe_top.vhd
+--    |- block_top.vhd (x16)
+--      |- add_key.vhd
+--      |
+--      |- add_left.vhd
+--      |
+--      |- e_expansion_function.vhd
+--      |
+--      |- p_box.vhd
+--      |
+--      |- s_box.vhd
+--          |- s1_box.vhd .. s8_box.vhd
+--    |- key_schedule.vhd
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.std_logic_textio.all;
+use std.textio.all;
+
+entity des_pipe_top_tb is
+    Generic (
+        CLK_PERIOD  : time := 10 ns;                    -- clock period (default 100MHz)
+        VECTOR_FILE : string := "des_pipe_vectors.txt"  -- written by des_c/desPipeSim.c -o
+    );
+end des_pipe_top_tb;
+
+architecture behavior of des_pipe_top_tb is
+
+    --=============================================================================================
+    -- Constants
+    --=============================================================================================
+    -- clock period
+    constant CLOCK_PERIOD : time := CLK_PERIOD;          -- clock
+    -- cycles without a result before the checker gives up
+    constant WATCHDOG     : natural := 64;
+
+    --=============================================================================================
+    -- Signals
+    --=============================================================================================
+    --- clock and reset signals ---
+    signal clock            : std_logic := '1';                 -- 100MHz clock
+    signal reset            : std_logic := '1';                 -- reset active high
+    signal done             : boolean := false;                 -- stops the clock after the last result
+    --- input data ---
+    signal key_in           : std_logic_vector (0 to 63);   -- key input
+    signal data_in          : std_logic_vector (0 to 63);   -- data input
+    --- control signals ---
+    signal funct_select     : std_logic;                        -- function select: '1' = encryption, '0' = decryption
+    signal lddata           : std_logic := '0';                 -- data strobe (active high)
+    signal core_busy        : std_logic;
+    signal des_out_rdy      : std_logic;
+    --- output data ---
+    signal data_out         : std_logic_vector (0 to 63);   -- data output
+    --- statistics ---
+    signal cycles           : natural := 0;                     -- rising edges since reset was released
+    signal first_load       : natural := 0;                     -- cycle of the first block
+
+begin
+
+    --=============================================================================================
+    -- INSTANTIATION FOR THE DEVICE UNDER TEST
+    --=============================================================================================
+	Inst_des_pipe_top_dut: entity work.des_pipe_top
+        port map(
+            --
+            -- Core Interface
+            --
+            key_in            => key_in,            -- input for key
+
+            function_select   => funct_select,      -- function	select: '1' = encryption, '0' = decryption
+
+            data_in           => data_in,           -- input for data
+
+            data_out          => data_out,          -- output for data
+
+            lddata            => lddata,            -- data strobe (active high)
+            core_busy         => core_busy,         -- active high while blocks are in the pipeline
+            des_out_rdy       => des_out_rdy,       -- active high for one cycle per finished block
+
+            reset             => reset,             -- active high
+            clock             => clock              -- master clock
+
+        );
+
+    --=============================================================================================
+    -- CLOCK GENERATION
+    --=============================================================================================
+    clock_proc: process is
+    begin
+        while not done loop
+            clock <= not clock;
+            wait for CLOCK_PERIOD / 2;
+        end loop;
+        wait;
+    end process clock_proc;
+
+    cycle_count: process (clock) is
+    begin
+        if rising_edge(clock) and reset = '0' then
+            cycles <= cycles + 1;
+        end if;
+    end process cycle_count;
+
+    --=============================================================================================
+    -- DRIVER: one block per clock, drained before every key change
+    --=============================================================================================
+    driver : process is
+
+        file     vectors    : text open read_mode is VECTOR_FILE;
+        variable vline      : line;
+        variable key        : std_logic_vector (0 to 63);
+        variable func       : integer;
+        variable datain     : std_logic_vector (0 to 63);
+        variable dataout    : std_logic_vector (0 to 63);
+        variable first      : boolean := true;
+
+    begin
+        reset <= '1';
+        wait until falling_edge(clock);
+        wait until falling_edge(clock);
+        reset <= '0';
+
+        while not endfile(vectors) loop
+            readline(vectors, vline);
+            next when vline'length = 0;
+            next when vline(vline'left) = '#';
+
+            hread(vline, key);
+            read(vline, func);
+            hread(vline, datain);
+            hread(vline, dataout);
+
+            if first then
+                first_load <= cycles;
+                first := false;
+            elsif key /= key_in then
+                -- let the blocks under the old key finish first
+                lddata <= '0';
+                wait until falling_edge(clock);
+                while core_busy = '1' loop
+                    wait until falling_edge(clock);
+                end loop;
+            end if;
+
+            key_in <= key;
+            data_in <= datain;
+            if func = 1 then
+                funct_select <= '1';
+            else
+                funct_select <= '0';
+            end if;
+            lddata <= '1';
+            wait until falling_edge(clock);
+        end loop;
+
+        lddata <= '0';
+        wait; -- all blocks issued
+    end process driver;
+
+    --=============================================================================================
+    -- CHECKER: compares results in issue order
+    --=============================================================================================
+    checker : process is
+
+        file     vectors    : text open read_mode is VECTOR_FILE;
+        variable vline      : line;
+        variable key        : std_logic_vector (0 to 63);
+        variable func       : integer;
+        variable datain     : std_logic_vector (0 to 63);
+        variable dataout    : std_logic_vector (0 to 63);
+        variable count      : natural := 0;
+        variable errors     : natural := 0;
+        variable waited     : natural;
+
+    begin
+        while not endfile(vectors) loop
+            readline(vectors, vline);
+            next when vline'length = 0;
+            next when vline(vline'left) = '#';
+
+            hread(vline, key);
+            read(vline, func);
+            hread(vline, datain);
+            hread(vline, dataout);
+
+            waited := 0;
+            loop
+                wait until falling_edge(clock);
+                exit when des_out_rdy = '1';
+                waited := waited + 1;
+                assert waited < WATCHDOG report "no result for block " & integer'image(count) severity failure;
+            end loop;
+
+            if data_out /= dataout then
+                errors := errors + 1;
+                report "block " & integer'image(count) & " failed" severity error;
+            end if;
+            count := count + 1;
+        end loop;
+
+        report "des_pipe_top_tb: " & integer'image(count) & " blocks, " & integer'image(errors) & " errors, " &
+               integer'image(cycles - first_load) & " cycles (" &
+               integer'image((1000 * count) / (cycles - first_load)) & "/1000 blocks per cycle)" severity note;
+        done <= true;
+        wait; -- stop simulation
+    end process checker;
+    --  End Test Bench
+END;
@@ -0,0 +1,79 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     des_ref_pkg.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Reference DES for testbenches: des_ref() returns the expected data_out for a key, function select and
+--      data_in by calling the C engine (des_c/desVhpi.c) through GHDL's VHPIDIRECT interface, so stimulus
+--      generated inside the simulation can be checked without a pregenerated expected-value file.
+--
+--      Link the C side into the simulation when elaborating:
+--
+--          gcc -O2 -pthread -c -fPIC ../des_c/desVhpi.c -o desVhpi.o
+--          ghdl -e --std=93c --ieee=synopsys -fexplicit -Wl,desVhpi.o -Wl,-pthread <testbench>
+--
+--      The bodies below only run if the foreign subprograms were not bound, i.e. desVhpi.o was not linked.
+--
+-----------------------------------------------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+package des_ref_pkg is
+
+    -- raw foreign calls: 64-bit buses as two integers, bus bit 0 = MSB of hi
+    procedure des_ref_c (
+        key_hi, key_lo, data_hi, data_lo, encrypt : in integer;
+        out_hi, out_lo                            : out integer
+    );
+    attribute foreign of des_ref_c : procedure is "VHPIDIRECT des_ref_c";
+
+    function des_ref_calls return integer;
+    attribute foreign of des_ref_calls : function is "VHPIDIRECT des_ref_calls";
+
+    -- expected data_out of des_cipher_top ('1' = encryption, '0' = decryption)
+    impure function des_ref (
+        key  : std_logic_vector (0 to 63);
+        func : std_logic;
+        data : std_logic_vector (0 to 63)
+    ) return std_logic_vector;
+
+end package des_ref_pkg;
+
+package body des_ref_pkg is
+
+    procedure des_ref_c (
+        key_hi, key_lo, data_hi, data_lo, encrypt : in integer;
+        out_hi, out_lo                            : out integer
+    ) is
+    begin
+        report "des_ref_c: desVhpi.o is not linked (ghdl -e -Wl,desVhpi.o)" severity failure;
+    end procedure des_ref_c;
+
+    function des_ref_calls return integer is
+    begin
+        report "des_ref_calls: desVhpi.o is not linked (ghdl -e -Wl,desVhpi.o)" severity failure;
+        return 0;
+    end function des_ref_calls;
+
+    impure function des_ref (
+        key  : std_logic_vector (0 to 63);
+        func : std_logic;
+        data : std_logic_vector (0 to 63)
+    ) return std_logic_vector is
+        variable hi, lo  : integer;
+        variable encrypt : integer := 0;
+        variable result  : std_logic_vector (0 to 63);
+    begin
+        if func = '1' then
+            encrypt := 1;
+        end if;
+        des_ref_c(to_integer(signed(key(0 to 31))), to_integer(signed(key(32 to 63))),
+                  to_integer(signed(data(0 to 31))), to_integer(signed(data(32 to 63))),
+                  encrypt, hi, lo);
+        result(0 to 31)  := std_logic_vector(to_signed(hi, 32));
+        result(32 to 63) := std_logic_vector(to_signed(lo, 32));
+        return result;
+    end function des_ref;
+
+end package body des_ref_pkg;
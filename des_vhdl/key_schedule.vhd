@@ -71,6 +71,7 @@ port (
 		-- interface signals for communication with DES 
 		KeySelect: 		in std_logic_vector(3 downto 0);	-- selector for key
     	key_out: 		out std_logic_vector(0 to 47);	-- expaned key output
+		key_all_out:	out std_logic_vector(0 to 767);	-- all expanded keys, K1 first (pipelined core)
 		key_ready: 		out std_logic;							-- signal for DES that key has been expanded
 	
 		reset: 			in std_logic; 							-- reset
@@ -115,6 +116,11 @@ key_out <= 	K1 	when 	KeySelect = x"0" else
 				K15 	when 	KeySelect = x"E" else
 				K16;
 
+--
+-- All sixteen expanded keys at once, one per stage of the pipelined core
+--
+key_all_out <= K1 & K2 & K3 & K4 & K5 & K6 & K7 & K8 & K9 & K10 & K11 & K12 & K13 & K14 & K15 & K16;
+
 process (clock)
 begin
 	
@@ -0,0 +1,138 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     key_schedule_agile.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Double-buffered key schedule for the key-agile core.
+--      key_schedule expands key_in on every clock; this wrapper keeps two banks of K1..K16 next to it:
+--
+--          active   the subkeys the running block reads through KeySelect / key_out
+--          shadow   the next key, loaded while a block is running
+--
+--      A key is taken when key_valid is high on a rising edge (key_in only has to be valid in that cycle). On
+--      the following edge its expansion is copied into the shadow bank, or straight into the active bank if a
+--      block starts on that edge. key_swap (from the core, high on the edge a block starts) moves a pending
+--      shadow key into the active bank. So a key strobed together with lddata applies to that block, and a key
+--      strobed while a block is running applies to the next one, without stalling the current block.
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- des_agile_cipher_top.vhd
+--    |- des_agile_top.vhd
+--      |- block_top.vhd
+--    |- key_schedule_agile.vhd
+--      |- key_schedule.vhd
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.STD_LOGIC_ARITH.ALL;
+use IEEE.STD_LOGIC_UNSIGNED.ALL;
+
+entity key_schedule_agile is
+port (
+
+		key_in:			in std_logic_vector(0 to 63);		-- key to be expanded
+		key_valid:		in std_logic;							-- key strobe (active high)
+
+		-- interface signals for communication with DES
+		KeySelect: 		in std_logic_vector(3 downto 0);	-- selector for key (active bank)
+    	key_out: 		out std_logic_vector(0 to 47);	-- expaned key output
+		key_swap:		in std_logic;							-- block starts: switch to the newest key
+		key_ready: 		out std_logic;							-- a key has been strobed since reset
+
+		reset: 			in std_logic; 							-- reset
+		clock: 			in std_logic  							-- master clock
+		);
+end key_schedule_agile;
+
+architecture Behavioral of key_schedule_agile is
+
+component key_schedule is
+port (
+		key_in:			in std_logic_vector(0 to 63);		-- input for key
+
+		KeySelect: 		in std_logic_vector(3 downto 0);	-- selector for key
+    	key_out: 		out std_logic_vector(0 to 47);	-- expaned key (depends on selector)
+		key_all_out:	out std_logic_vector(0 to 767);	-- all expanded keys, K1 first
+		key_ready: 		out std_logic;							-- signal for the core that key has been expanded
+
+		reset: in std_logic; 									-- active high
+		clock: in std_logic  									-- master clock
+		);
+end component;
+
+constant KEY_SELECT_UNUSED: std_logic_vector(3 downto 0) := "0000";		-- key_out is not used here
+
+signal key_expanded: 	std_logic_vector(0 to 767);	-- K1..K16 of the key_in seen on the last edge
+signal K_active: 			std_logic_vector(0 to 767);	-- bank read by the running block
+signal K_shadow: 			std_logic_vector(0 to 767);	-- next key
+signal capture: 			std_logic;							-- key_expanded holds a strobed key
+signal pending: 			std_logic;							-- K_shadow holds a key not yet active
+signal loaded: 			std_logic;							-- any key since reset
+
+begin
+
+--
+-- Selector for the active bank
+--
+key_out <= K_active(48*conv_integer(KeySelect) to 48*conv_integer(KeySelect)+47);
+
+key_ready <= loaded or capture;
+
+process (clock)
+begin
+
+if rising_edge(clock) then
+
+	if reset = '1' then
+		capture	<= '0';
+		pending	<= '0';
+		loaded	<= '0';
+	else
+
+		if capture = '1' then
+
+			-- the strobed key has been expanded: a starting block takes it directly
+			if key_swap = '1' then
+				K_active	<= key_expanded;
+				pending	<= '0';
+			else
+				K_shadow	<= key_expanded;
+				pending	<= '1';
+			end if;
+			loaded <= '1';
+
+		elsif key_swap = '1' and pending = '1' then
+
+			K_active	<= K_shadow;
+			pending	<= '0';
+
+		end if;
+
+		capture <= key_valid;
+
+	end if;
+
+end if;
+end process;
+
+--
+-- Expansion of key_in, one clock after it is presented
+--
+KEYSCHEDULE: key_schedule
+port map (
+		KeySelect 	=> KEY_SELECT_UNUSED,
+		key_in 		=> key_in,
+		key_out 		=> open,
+		key_all_out	=> key_expanded,
+		key_ready 	=> open,
+		reset 		=> reset,
+		clock 		=> clock
+);
+
+end Behavioral;
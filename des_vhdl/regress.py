@@ -0,0 +1,176 @@
+"""Sharded GHDL regression for des_cipher_top.
+
+Splits a vector file written by des_c/desVectors.c into shards, runs
+des_cipher_top_file_tb.vhd on every shard in parallel (one GHDL process
+per core), and merges the results into one pass/fail report that lists
+the failing vectors by their line in the original file.
+
+  ../des_c/desVectors -n 100000 -o des_vectors.txt
+  python3 regress.py des_vectors.txt [-j jobs] [-n shards] [-k]
+
+The design is analysed and elaborated once into a shared build
+directory; each shard is then only a `ghdl -r` with its own
+VECTOR_FILE generic.  Exit status is 0 only if every vector passed and
+every shard finished.
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+SOURCES = [
+    "s1_box.vhd", "s2_box.vhd", "s3_box.vhd", "s4_box.vhd",
+    "s5_box.vhd", "s6_box.vhd", "s7_box.vhd", "s8_box.vhd",
+    "s_box.vhd", "add_key.vhd", "add_left.vhd", "e_expansion_function.vhd",
+    "p_box.vhd", "block_top.vhd", "key_schedule.vhd", "des_top.vhd",
+    "des_cipher_top.vhd", "des_cipher_top_file_tb.vhd",
+]
+TOP = "des_cipher_top_file_tb"
+# the design uses std_logic_arith/unsigned
+GHDL_FLAGS = ["--std=93c", "--ieee=synopsys", "-fexplicit"]
+
+FAIL_RE = re.compile(r"vector (\d+) (.*) failed")
+SUMMARY_RE = re.compile(TOP + r": (\d+) vectors, (\d+) errors")
+
+
+def run(cmd, cwd, timeout=None):
+    p = subprocess.run(cmd, cwd=cwd, stdout=subprocess.PIPE,
+                       stderr=subprocess.STDOUT, universal_newlines=True,
+                       timeout=timeout)
+    return p.returncode, p.stdout
+
+
+def build(ghdl, src_dir, build_dir):
+    work = ["--workdir=" + build_dir]
+    for src in SOURCES:
+        rc, out = run([ghdl, "-a"] + GHDL_FLAGS + work +
+                      [os.path.join(src_dir, src)], build_dir)
+        if rc != 0:
+            sys.exit("ghdl -a %s failed:\n%s" % (src, out))
+    rc, out = run([ghdl, "-e"] + GHDL_FLAGS + work + [TOP], build_dir)
+    if rc != 0:
+        sys.exit("ghdl -e %s failed:\n%s" % (TOP, out))
+
+
+def read_vectors(path):
+    """(line number, text) of every vector line; comments are dropped."""
+    vectors = []
+    with open(path) as fp:
+        for number, line in enumerate(fp, 1):
+            text = line.strip()
+            if text and not text.startswith("#"):
+                vectors.append((number, text))
+    return vectors
+
+
+def write_shards(vectors, shards, build_dir):
+    per = (len(vectors) + shards - 1) // shards
+    out = []
+    for i in range(shards):
+        part = vectors[i * per:(i + 1) * per]
+        if not part:
+            break
+        name = os.path.join(build_dir, "shard%03d.txt" % i)
+        with open(name, "w") as fp:
+            for _, text in part:
+                fp.write(text + "\n")
+        out.append((i, name, part))
+    return out
+
+
+def run_shard(ghdl, build_dir, shard, timeout):
+    index, name, part = shard
+    start = time.time()
+    try:
+        rc, out = run([ghdl, "-r"] + GHDL_FLAGS +
+                      ["--workdir=" + build_dir, TOP,
+                       "-gVECTOR_FILE=" + name], build_dir, timeout)
+    except subprocess.TimeoutExpired:
+        rc, out = -1, "timeout after %ds" % timeout
+    failed = {}
+    for m in FAIL_RE.finditer(out):
+        # the testbench numbers vectors from 1 within its file
+        failed.setdefault(int(m.group(1)), []).append(m.group(2))
+    m = SUMMARY_RE.search(out)
+    done = int(m.group(1)) if m else None
+    return {
+        "index": index, "part": part, "rc": rc, "out": out,
+        "failed": failed, "done": done, "seconds": time.time() - start,
+    }
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("vectors", help="vector file from desVectors")
+    ap.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1,
+                    help="parallel simulations (default: all cores)")
+    ap.add_argument("-n", "--shards", type=int, default=0,
+                    help="number of shards (default: 4 per job)")
+    ap.add_argument("-t", "--timeout", type=int, default=3600,
+                    help="seconds per shard")
+    ap.add_argument("-b", "--build", default="regress_build",
+                    help="build/work directory")
+    ap.add_argument("-g", "--ghdl", default="ghdl")
+    ap.add_argument("-k", "--keep", action="store_true",
+                    help="keep the build directory")
+    args = ap.parse_args()
+
+    if shutil.which(args.ghdl) is None:
+        sys.exit("%s not found" % args.ghdl)
+    src_dir = os.path.dirname(os.path.abspath(__file__))
+    build_dir = os.path.abspath(args.build)
+    os.makedirs(build_dir, exist_ok=True)
+
+    vectors = read_vectors(args.vectors)
+    if not vectors:
+        sys.exit("no vectors in %s" % args.vectors)
+    shards = args.shards or 4 * args.jobs
+    shards = max(1, min(shards, len(vectors)))
+
+    start = time.time()
+    build(args.ghdl, src_dir, build_dir)
+    work = write_shards(vectors, shards, build_dir)
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        results = list(pool.map(
+            lambda s: run_shard(args.ghdl, build_dir, s, args.timeout), work))
+
+    passed = failed = 0
+    broken = []
+    failures = []
+    for r in results:
+        if r["done"] != len(r["part"]):
+            # crashed, timed out or stopped early: nothing in it counts
+            broken.append(r)
+            continue
+        for i, (number, text) in enumerate(r["part"], 1):
+            if i in r["failed"]:
+                failed += 1
+                failures.append((number, text, r["failed"][i]))
+            else:
+                passed += 1
+
+    print("%d vectors in %d shards, %d jobs, %.1fs" %
+          (len(vectors), len(work), args.jobs, time.time() - start))
+    print("passed %d  failed %d  shards not completed %d" %
+          (passed, failed, len(broken)))
+    for number, text, what in sorted(failures):
+        print("FAIL line %d: %s  (%s)" % (number, text, ", ".join(what)))
+    for r in broken:
+        lines = r["part"][0][0], r["part"][-1][0]
+        tail = r["out"].strip().splitlines()[-3:]
+        print("INCOMPLETE shard %d (lines %d-%d, exit %d): %s" %
+              (r["index"], lines[0], lines[1], r["rc"], " | ".join(tail)))
+    if not args.keep and not failures and not broken:
+        shutil.rmtree(build_dir, ignore_errors=True)
+    ok = not failures and not broken
+    print("PASS" if ok else "FAIL")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
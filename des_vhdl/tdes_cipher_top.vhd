@@ -0,0 +1,201 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     tdes_cipher_top.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Triple-DES top level. Same interface and handshake as des_cipher_top (lddata in, core_busy, des_out_rdy
+--      out), with one key input per stage. Each key has its own key_schedule, loaded on every clock while reset
+--      is low, so a block runs all 48 rounds in one pass: 48 clocks of rounds plus the data load, where
+--      des_cipher_top_tb.vhd spends a reset, WaitKey and reload on each of the three single-DES operations.
+--      Blocks can be streamed by keeping lddata high; no reset is needed between blocks or after a key change
+--      made while core_busy is low.
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- tdes_cipher_top.vhd
+--    |- tdes_top.vhd
+--      |- block_top.vhd
+--        |- add_key.vhd
+--        |
+--        |- add_left.vhd
+--        |
+--        |- e_expansion_function.vhd
+--        |
+--        |- p_box.vhd
+--        |
+--        |- s_box.vhd
+--            |- s1_box.vhd .. s8_box.vhd
+--    |- key_schedule.vhd (x3)
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.STD_LOGIC_ARITH.ALL;
+use IEEE.STD_LOGIC_UNSIGNED.ALL;
+
+entity tdes_cipher_top is
+generic (
+		TDES_EDE:			boolean := true						-- true: EDE/DED, false: EEE/DDD
+		);
+port(
+		--
+		-- Core Interface
+		--
+		key1_in:				in std_logic_vector(0 to 63);		-- first-stage key (last when decrypting)
+		key2_in:				in std_logic_vector(0 to 63);		-- middle-stage key
+		key3_in:				in std_logic_vector(0 to 63);		-- last-stage key (first when decrypting)
+		function_select:	in	std_logic; 							-- function	select: '1' = encryption, '0' = decryption
+
+		data_in:				in std_logic_vector(0 to 63);		-- input for data
+
+		data_out:			out std_logic_vector(0 to 63);	-- output for data
+
+		lddata:				in 	std_logic;						-- data strobe (active high)
+		core_busy:			out	std_logic;						-- active high when encrypting/decryption data
+		des_out_rdy:		out	std_logic;						-- active high when encryption/decryption of data is done
+
+		reset: 				in std_logic;							-- active high
+		clock: 				in std_logic							-- master clock
+
+	);
+end tdes_cipher_top;
+
+architecture Behavioral of tdes_cipher_top is
+
+component key_schedule is
+port (
+		key_in:			in std_logic_vector(0 to 63);		-- input for key
+
+		KeySelect: 		in std_logic_vector(3 downto 0);	-- selector for key
+    	key_out: 		out std_logic_vector(0 to 47);	-- expaned key (depends on selector)
+		key_all_out:	out std_logic_vector(0 to 767);	-- all expanded keys (unused here)
+		key_ready: 		out std_logic;							-- signal for the core that key has been expanded
+
+		reset: in std_logic; 									-- active high
+		clock: in std_logic  									-- master clock
+		);
+end component;
+
+component tdes_top is
+generic (
+		TDES_EDE:		boolean
+		);
+port (
+		key1_round_in:	in 	std_logic_vector(0 to 47);
+		key2_round_in:	in 	std_logic_vector(0 to 47);
+		key3_round_in:	in 	std_logic_vector(0 to 47);
+		data_in:			in 	std_logic_vector(0 to 63);
+		data_out:		out 	std_logic_vector(0 to 63);
+
+		KeySelect: 		inout std_logic_vector(3 downto 0);	-- selector for key
+		key_ready: 		in std_logic;
+		data_ready: 	in std_logic;
+		func_select:	in std_logic;
+
+		des_out_rdy: 	out std_logic;
+		core_busy: 		out std_logic;
+
+		reset: 			in std_logic;
+		clock: 			in std_logic  								-- master clock
+		);
+end component;
+
+signal key_select_internal: std_logic_vector(3 downto 0);
+signal key1_round_internal, key2_round_internal, key3_round_internal: std_logic_vector(0 to 47);
+signal key1_ready_internal, key2_ready_internal, key3_ready_internal: std_logic;
+signal key_ready_internal: std_logic;
+signal data_in_internal: std_logic_vector(0 to 63);
+signal data_ready_internal: std_logic;
+
+begin
+
+process (clock)
+begin
+
+if rising_edge(clock) then
+
+		if lddata = '1' then
+
+			-- capute data from the bus
+			data_in_internal 		<= data_in; -- register data from the bus
+			data_ready_internal	<= '1';		-- data has been loaded: continue with encryptio/decryption
+
+		else
+
+			data_ready_internal	<= '0';		-- data is not loaded: wait for data
+
+		end if;
+
+end if;
+end process;
+
+key_ready_internal <= key1_ready_internal and key2_ready_internal and key3_ready_internal;
+
+--
+-- KEY EXPANDERS AND TDES CORE instantiation
+--
+KEYSCHEDULE1: key_schedule
+port map (
+		KeySelect 	=> key_select_internal,
+		key_in 		=> key1_in,
+		key_out 		=> key1_round_internal,
+		key_all_out	=> open,
+		key_ready 	=> key1_ready_internal,
+		reset 		=> reset,
+		clock 		=> clock
+);
+
+KEYSCHEDULE2: key_schedule
+port map (
+		KeySelect 	=> key_select_internal,
+		key_in 		=> key2_in,
+		key_out 		=> key2_round_internal,
+		key_all_out	=> open,
+		key_ready 	=> key2_ready_internal,
+		reset 		=> reset,
+		clock 		=> clock
+);
+
+KEYSCHEDULE3: key_schedule
+port map (
+		KeySelect 	=> key_select_internal,
+		key_in 		=> key3_in,
+		key_out 		=> key3_round_internal,
+		key_all_out	=> open,
+		key_ready 	=> key3_ready_internal,
+		reset 		=> reset,
+		clock 		=> clock
+);
+
+TDESTOP: tdes_top
+generic map (
+		TDES_EDE			=> TDES_EDE
+)
+port map (
+
+		key1_round_in 	=> key1_round_internal,
+		key2_round_in 	=> key2_round_internal,
+		key3_round_in 	=> key3_round_internal,
+
+		data_in		 	=> data_in_internal,
+
+		key_ready 		=> key_ready_internal,
+		data_ready 		=> data_ready_internal,
+
+		KeySelect 		=> key_select_internal,
+
+		func_select 	=> function_select,
+
+		data_out 		=> data_out,
+		core_busy 		=> core_busy,
+		des_out_rdy 	=> des_out_rdy,
+
+		reset 			=> reset,
+		clock 			=> clock
+);
+
+end Behavioral;
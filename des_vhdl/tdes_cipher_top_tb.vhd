@@ -0,0 +1,173 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     tdes_cipher_top_tb.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      File-driven testbench for the tdes_cipher_top engine.
+--      Vectors are written by des_c/desTdesSim.c -o, one triple-DES block per line:
+--
+--          key1 key2 key3 func datain dataout         (func: 1 = encrypt, 0 = decrypt)
+--
+--      The engine is reset once. After that lddata stays high and the next keys and block are presented as soon
+--      as des_out_rdy is seen, so the keys change between blocks without a reset. Generate the vectors with the
+--      same stage order as the TDES_EDE generic (desTdesSim -m ede / -m eee).
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- tdes_cipher_top.vhd
+--    |- tdes_top.vhd
+--      |- block_top.vhd
+--    |- key_schedule.vhd (x3)
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.std_logic_textio.all;
+use std.textio.all;
+
+entity tdes_cipher_top_tb is
+    Generic (
+        CLK_PERIOD  : time := 10 ns;                    -- clock period (default 100MHz)
+        TDES_EDE    : boolean := true;                  -- must match the vector file
+        VECTOR_FILE : string := "tdes_vectors.txt"      -- written by des_c/desTdesSim.c -o
+    );
+end tdes_cipher_top_tb;
+
+architecture behavior of tdes_cipher_top_tb is
+
+    --=============================================================================================
+    -- Constants
+    --=============================================================================================
+    -- clock period
+    constant CLOCK_PERIOD : time := CLK_PERIOD;          -- clock
+
+    --=============================================================================================
+    -- Signals
+    --=============================================================================================
+    --- clock and reset signals ---
+    signal clock            : std_logic := '1';                 -- 100MHz clock
+    signal reset            : std_logic := '1';                 -- reset active high
+    signal done             : boolean := false;                 -- stops the clock after the last vector
+    --- input data ---
+    signal key1_in          : std_logic_vector (0 to 63);   -- key inputs
+    signal key2_in          : std_logic_vector (0 to 63);
+    signal key3_in          : std_logic_vector (0 to 63);
+    signal data_in          : std_logic_vector (0 to 63);   -- data input
+    --- control signals ---
+    signal funct_select     : std_logic;                        -- function select: '1' = encryption, '0' = decryption
+    signal lddata           : std_logic := '0';                 -- data strobe (active high)
+    signal core_busy        : std_logic;
+    signal des_out_rdy      : std_logic;
+    --- output data ---
+    signal data_out         : std_logic_vector (0 to 63);   -- data output
+
+begin
+
+    --=============================================================================================
+    -- INSTANTIATION FOR THE DEVICE UNDER TEST
+    --=============================================================================================
+	Inst_tdes_cipher_top_dut: entity work.tdes_cipher_top
+        generic map(
+            TDES_EDE          => TDES_EDE
+        )
+        port map(
+            --
+            -- Core Interface
+            --
+            key1_in           => key1_in,           -- input for the stage keys
+            key2_in           => key2_in,
+            key3_in           => key3_in,
+
+            function_select   => funct_select,      -- function	select: '1' = encryption, '0' = decryption
+
+            data_in           => data_in,           -- input for data
+
+            data_out          => data_out,          -- output for data
+
+            lddata            => lddata,            -- data strobe (active high)
+            core_busy         => core_busy,         -- active high when encrypting/decryption data
+            des_out_rdy       => des_out_rdy,       -- active high when encryption/decryption of data is done
+
+            reset             => reset,             -- active high
+            clock             => clock              -- master clock
+
+        );
+
+    --=============================================================================================
+    -- CLOCK GENERATION
+    --=============================================================================================
+    clock_proc: process is
+    begin
+        while not done loop
+            clock <= not clock;
+            wait for CLOCK_PERIOD / 2;
+        end loop;
+        wait;
+    end process clock_proc;
+
+    --=============================================================================================
+    -- TEST BENCH STIMULI
+    --=============================================================================================
+    tb1 : process is
+
+        file     vectors    : text open read_mode is VECTOR_FILE;
+        variable vline      : line;
+        variable key1       : std_logic_vector (0 to 63);
+        variable key2       : std_logic_vector (0 to 63);
+        variable key3       : std_logic_vector (0 to 63);
+        variable func       : integer;
+        variable datain     : std_logic_vector (0 to 63);
+        variable dataout    : std_logic_vector (0 to 63);
+        variable count      : natural := 0;
+        variable errors     : natural := 0;
+        variable start      : time;
+
+    begin
+        reset <= '1';
+        wait for CLOCK_PERIOD; -- wait until reset completes
+        reset <= '0';
+        start := now;
+
+        while not endfile(vectors) loop
+            readline(vectors, vline);
+            next when vline'length = 0;
+            next when vline(vline'left) = '#';
+
+            hread(vline, key1);
+            hread(vline, key2);
+            hread(vline, key3);
+            read(vline, func);
+            hread(vline, datain);
+            hread(vline, dataout);
+
+            -- no reset: new keys and block go in while the last result is on data_out
+            key1_in           <= key1;
+            key2_in           <= key2;
+            key3_in           <= key3;
+            if func = 1 then
+                funct_select  <= '1';
+            else
+                funct_select  <= '0';
+            end if;
+            data_in           <= datain;
+            lddata            <= '1';
+            wait until des_out_rdy = '1';
+
+            if data_out /= dataout then
+                errors := errors + 1;
+                report "vector " & integer'image(count) & " failed" severity error;
+            end if;
+            count := count + 1;
+        end loop;
+
+        report "tdes_cipher_top_tb: " & integer'image(count) & " vectors, " & integer'image(errors) & " errors, " &
+               integer'image((now - start) / CLOCK_PERIOD) & " cycles" severity note;
+        done <= true;
+        wait; -- stop simulation
+    end process tb1;
+    --  End Test Bench
+END;
@@ -0,0 +1,271 @@
+-----------------------------------------------------------------------------------------------------------------------
+-- Module Name:     tdes_top.vhd
+-- Project Name:    des_cipher
+-- Description:
+--
+--      Triple-DES round controller, the three-key counterpart of des_top.
+--      One block_top is reused for all 48 rounds. Between the stages the block is not taken through the inverse
+--      IP and the IP again (they cancel); the halves of round 16 are swapped straight into round 1 of the next
+--      stage, and the next stage's round keys come from its own key_schedule, so the three stages run back to
+--      back with no reset, WaitKey or reload in between.
+--
+--      Stage order and direction (TDES_EDE = true):    encrypt  E(K1) D(K2) E(K3)
+--                                                      decrypt  D(K3) E(K2) D(K1)
+--      With TDES_EDE = false every stage runs in the direction of func_select (E-E-E / D-D-D), which is what
+--      des_cipher_top_tb.vhd and encodeSteps.txt chain with single-DES operations.
+--
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+--
+--  Project structure:
+--
+--  |- tdes_cipher_top.vhd
+--    |- tdes_top.vhd
+--      |- block_top.vhd
+--    |- key_schedule.vhd (x3)
+-----------------------------------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------------------------------------
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use IEEE.STD_LOGIC_ARITH.ALL;
+use IEEE.STD_LOGIC_UNSIGNED.ALL;
+
+entity tdes_top is
+generic (
+		TDES_EDE:		boolean := true							-- true: EDE/DED, false: EEE/DDD
+		);
+port (
+
+		-- input/output core signals
+		key1_round_in:	in 	std_logic_vector(0 to 47);		-- round key from the K1 key_schedule
+		key2_round_in:	in 	std_logic_vector(0 to 47);		-- round key from the K2 key_schedule
+		key3_round_in:	in 	std_logic_vector(0 to 47);		-- round key from the K3 key_schedule
+		data_in:			in 	std_logic_vector(0 to 63);
+		data_out:		out 	std_logic_vector(0 to 63);
+
+		-- signals for communication with key expander modules
+		KeySelect: 		inout std_logic_vector(3 downto 0);		-- selector for key (shared by all three)
+		key_ready: 		in std_logic;						-- active high when all keys are ready
+		data_ready: 	in std_logic;						-- active high when data is ready
+		func_select:   in std_logic;						-- encryption/decryption flag
+
+		des_out_rdy: out std_logic;						-- active high when decrypted/encrypted data are ready
+		core_busy: out std_logic;							-- active high when core is in process of encryption
+
+		reset: in std_logic; 								-- master reset
+		clock: in std_logic  								-- master clock
+		);
+end tdes_top;
+
+architecture Behavioral of tdes_top is
+
+component block_top is
+port(
+		L_in: in std_logic_vector(0 to 31);				-- left permuted input
+		R_in: in std_logic_vector(0 to 31);				-- right permuted input
+
+		L_out: out std_logic_vector(0 to 31);			-- left permuted output
+		R_out: out std_logic_vector(0 to 31);			-- right permuted output
+
+		round_key_des: in std_logic_vector(0 to 47)	-- current round key
+
+	);
+end component;
+
+--
+-- Internal TDES_TOP signals
+--
+signal L_in_internal, R_in_internal: 	std_logic_vector(0 to 31);
+signal L_out_internal, R_out_internal: std_logic_vector(0 to 31);
+signal key_round_internal: 				std_logic_vector(0 to 47);
+type statetype is (WaitKey, WaitData, Rounds, FinalRound);
+signal nextstate: statetype;
+signal RoundCounter: 						std_logic_vector(3 downto 0);
+signal StageCounter: 						std_logic_vector(1 downto 0);	-- 0, 1, 2
+signal FuncLatched: 							std_logic;		-- func_select of the block in flight
+signal StageFunc: 							std_logic;		-- direction of the current stage
+signal NextStageFunc: 						std_logic;		-- direction of the following stage
+signal EdeMiddle, EdeNextMiddle: 		std_logic;
+
+begin
+
+--
+-- Stage direction: the middle stage runs the other way in EDE mode
+--
+EdeMiddle 		<= '1' when TDES_EDE and StageCounter = "01" else '0';
+EdeNextMiddle 	<= '1' when TDES_EDE and StageCounter = "00" else '0';
+StageFunc 		<= FuncLatched xor EdeMiddle;
+NextStageFunc 	<= FuncLatched xor EdeNextMiddle;
+
+--
+-- Stage key: K1, K2, K3 when encrypting, K3, K2, K1 when decrypting
+--
+key_round_internal <= 	key2_round_in when StageCounter = "01" else
+								key1_round_in when (StageCounter = "00") = (FuncLatched = '1') else
+								key3_round_in;
+
+--
+-- Finite state machine
+--
+process (clock)
+begin
+	if rising_edge(clock)  then
+		if reset = '1' then
+			--
+			-- Reset all signal to inital values
+			--
+			nextstate 				<= WaitKey;
+			RoundCounter			<= "0000";
+			StageCounter			<= "00";
+			core_busy				<= '0';				-- core is in reset state: not busy
+			des_out_rdy				<= '0';				-- output data is not ready
+
+		else
+
+			case nextstate is
+
+				--
+				-- WaitKey: wait for the three keys to be expanded
+				--
+				when WaitKey =>
+
+					if key_ready = '0' then
+						nextstate	<= WaitKey;
+					else
+						nextstate	<= WaitData;
+					end if;
+
+					core_busy				<= '0';
+					des_out_rdy				<= '0';
+
+				--
+				-- WaitData: initial permutation of the next block
+				--
+				when WaitData =>
+
+					if (data_ready = '0') then
+
+						nextstate				<= WaitData;
+
+					else
+						core_busy				<= '1';				-- core is processing = busy
+
+						L_in_internal <= 	data_in(57) & data_in(49) & data_in(41) & data_in(33) & data_in(25) & data_in(17) &
+												data_in(9) & data_in(1) & data_in(59) & data_in(51) & data_in(43) & data_in(35) &
+												data_in(27) & data_in(19) & data_in(11) & data_in(3) & data_in(61) & data_in(53) &
+												data_in(45) & data_in(37) & data_in(29) & data_in(21) & data_in(13) & data_in(5) &
+												data_in(63) & data_in(55) & data_in(47) & data_in(39) & data_in(31) & data_in(23) &
+												data_in(15) & data_in(7);
+
+						R_in_internal <= 	data_in(56) & data_in(48) & data_in(40) & data_in(32) & data_in(24) & data_in(16) &
+												data_in(8) & data_in(0) & data_in(58) & data_in(50) & data_in(42) & data_in(34) &
+												data_in(26) & data_in(18) & data_in(10) & data_in(2) & data_in(60) & data_in(52) &
+												data_in(44) & data_in(36) & data_in(28) & data_in(20) & data_in(12) & data_in(4) &
+												data_in(62) & data_in(54) & data_in(46) & data_in(38) & data_in(30) & data_in(22) &
+												data_in(14) & data_in(6);
+
+						FuncLatched		<= func_select;
+						StageCounter	<= "00";
+						RoundCounter	<= "0000";
+						nextstate		<= Rounds;
+
+						-- the first stage runs in the direction of func_select
+						if func_select = '1' then
+							KeySelect	<= "0000";
+						else
+							KeySelect	<= "1111";
+						end if;
+
+					end if;
+
+				--
+				-- Rounds: one round per clock, 16 per stage, 3 stages
+				--
+				when Rounds =>
+
+						RoundCounter <= RoundCounter + '1';
+
+						if RoundCounter /= x"F" then
+
+							L_in_internal <= L_out_internal;
+							R_in_internal <= R_out_internal;
+
+							if StageFunc = '1' then
+								KeySelect <= KeySelect + '1';
+							else
+								KeySelect <= KeySelect - '1';
+							end if;
+
+						elsif StageCounter /= "10" then
+
+							-- end of stage 1 or 2: FP and the next IP cancel, only the halves swap
+							L_in_internal <= R_out_internal;
+							R_in_internal <= L_out_internal;
+							StageCounter  <= StageCounter + '1';
+
+							if NextStageFunc = '1' then
+								KeySelect	<= "0000";
+							else
+								KeySelect	<= "1111";
+							end if;
+
+						else
+
+							-- perform inverse initial permutation
+							data_out	<=	L_out_internal(7) & R_out_internal(7) & L_out_internal(15) & R_out_internal(15) &
+											L_out_internal(23) & R_out_internal(23) & L_out_internal(31) & R_out_internal(31) &
+											L_out_internal(6) & R_out_internal(6) & L_out_internal(14) & R_out_internal(14) &
+											L_out_internal(22) & R_out_internal(22) & L_out_internal(30) & R_out_internal(30) &
+											L_out_internal(5) & R_out_internal(5) & L_out_internal(13) & R_out_internal(13) &
+											L_out_internal(21) & R_out_internal(21) & L_out_internal(29) & R_out_internal(29) &
+											L_out_internal(4) & R_out_internal(4) & L_out_internal(12) & R_out_internal(12) &
+											L_out_internal(20) & R_out_internal(20) & L_out_internal(28) & R_out_internal(28) &
+											L_out_internal(3) & R_out_internal(3) & L_out_internal(11) & R_out_internal(11) &
+											L_out_internal(19) & R_out_internal(19) & L_out_internal(27) & R_out_internal(27) &
+											L_out_internal(2) & R_out_internal(2) & L_out_internal(10) & R_out_internal(10) &
+											L_out_internal(18) & R_out_internal(18) & L_out_internal(26) & R_out_internal(26) &
+											L_out_internal(1) & R_out_internal(1) & L_out_internal(9) & R_out_internal(9) &
+											L_out_internal(17) & R_out_internal(17) & L_out_internal(25) & R_out_internal(25) &
+											L_out_internal(0) & R_out_internal(0) & L_out_internal(8) & R_out_internal(8) &
+											L_out_internal(16) & R_out_internal(16) & L_out_internal(24) & R_out_internal(24);
+
+							core_busy				<= '0';		-- core is not busy
+							des_out_rdy				<= '1';		-- output data is ready
+							nextstate 				<= FinalRound;
+
+						end if;
+
+				--
+				-- Last round: keys are still loaded, so go straight back for the next block
+				--
+				when FinalRound =>
+
+					RoundCounter 			<= "0000";
+					StageCounter 			<= "00";
+					nextstate 				<= WaitData;
+					des_out_rdy				<= '0';		-- deselect out data ready signal
+
+				when others =>
+					-- should never happen
+			end case;
+		end if;
+	end if;
+end process;
+
+--
+-- Instantations
+--
+BLOCKTOP: block_top
+port map (
+		L_in 				=> L_in_internal,
+		R_in 				=> R_in_internal,
+
+		round_key_des 	=> key_round_internal,
+
+		L_out 			=> L_out_internal,
+		R_out 			=>	R_out_internal
+
+);
+
+end Behavioral;